@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   AssetKey.cpp
+ * Author: agent
+ *
+ * Created on October 16, 2026, 7:07 PM
+ */
+
+#include "AssetKey.h"
+#include "Mars.h"
+#include <mutex>
+#include <unordered_map>
+
+namespace mars
+{
+  /** Structure containing the debug string table of every remembered path.
+   */
+  struct AssetNames
+  {
+    std::unordered_map<std::uint64_t, std::string> names ; ///< The path of every remembered hash.
+    std::mutex                                     lock  ; ///< The lock guarding the table.
+  };
+
+  /** Static function to retrieve the debug string table.
+   * @return Reference to the debug string table.
+   * @note Function local so keys made during static initialization are safe.
+   */
+  static AssetNames& assetNames()
+  {
+    static AssetNames names ;
+    return names ;
+  }
+
+  /** Structure containing a thread's cache of the paths it already remembered, direct mapped by hash.
+   */
+  struct RememberedNames
+  {
+    static constexpr unsigned SIZE = 256 ; ///< The amount of paths cached. A power of two.
+
+    std::uint64_t      hashes[ SIZE ] = {} ; ///< The hash of every cached path.
+    const std::string* names [ SIZE ] = {} ; ///< The path of every cached hash, owned by the debug string table.
+  };
+
+  void AssetKey::remember( std::uint64_t hash, std::string_view path )
+  {
+    thread_local RememberedNames cache ;
+
+    const unsigned slot = static_cast<unsigned>( hash ) & ( RememberedNames::SIZE - 1 ) ;
+
+    // Paths of the table are never changed nor erased once inserted, so cached ones are compared without the lock.
+    if( cache.names[ slot ] && cache.hashes[ slot ] == hash )
+    {
+      if( *cache.names[ slot ] != path ) mars::handleError( __FILE__, __LINE__, mars::Error::KeyCollision ) ;
+      return ;
+    }
+
+    AssetNames&                 table = assetNames()                                         ;
+    std::lock_guard<std::mutex> lock( table.lock )                                           ;
+    auto                        iter  = table.names.emplace( hash, std::string( path ) ).first ;
+
+    if( iter->second != path ) mars::handleError( __FILE__, __LINE__, mars::Error::KeyCollision ) ;
+
+    cache.hashes[ slot ] = hash          ;
+    cache.names [ slot ] = &iter->second ;
+  }
+
+  const char* AssetKey::name() const
+  {
+    AssetNames&                 table = assetNames()                     ;
+    std::lock_guard<std::mutex> lock( table.lock )                       ;
+    auto                        iter  = table.names.find( this->m_hash ) ;
+
+    // Nodes of the table are never erased, so the path outlives the lock.
+    return iter != table.names.end() ? iter->second.c_str() : "" ;
+  }
+}
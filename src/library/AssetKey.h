@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   AssetKey.h
+ * Author: agent
+ *
+ * Created on October 16, 2026, 7:07 PM
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+/** Whether asset keys remember the paths they were made from, so they can be named again with AssetKey::name.
+ * Defaults to on, unless NDEBUG is defined. Keys made from literals are only remembered where the compiler can tell constant evaluation apart.
+ */
+#ifndef MARS_ASSET_NAMES
+  #ifdef NDEBUG
+    #define MARS_ASSET_NAMES 0
+  #else
+    #define MARS_ASSET_NAMES 1
+  #endif
+#endif
+
+#if defined( __has_builtin )
+  #if __has_builtin( __builtin_is_constant_evaluated )
+    #define MARS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+  #endif
+#elif defined( _MSC_VER ) && _MSC_VER >= 1925
+  #define MARS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+
+namespace mars
+{
+  class AssetKey ;
+
+  namespace literals
+  {
+    constexpr AssetKey operator""_asset( const char* path, std::size_t size ) ;
+  }
+
+  /** Key of an asset, e.g. a texture or model path, reduced to its 64-bit FNV-1a hash.
+   * Keys of string literals are hashed at compile time, so looking up a Manager keyed by AssetKey is a plain integer probe.
+   * Keys made at runtime, from std::string or std::string_view, are hashed once & never allocate outside of debug builds.
+   * @note With MARS_ASSET_NAMES, every path is remembered in a debug string table, and two paths hashing to the same key forward a KeyCollision error.
+   *       Each thread caches the paths it already remembered, so only the first key of a path on a thread locks the table.
+   */
+  class AssetKey
+  {
+    public:
+
+      /** Default constructor. Creates the key of the empty path.
+       */
+      constexpr AssetKey() : m_hash( AssetKey::hash( std::string_view() ) ) {} ;
+
+      /** Constructor. Hashes a string literal, at compile time when used in a constant expression.
+       * @param path The path of the asset.
+       */
+      template<std::size_t Size>
+      constexpr AssetKey( const char ( &path )[ Size ] ) : AssetKey( path, Size - 1 ) {}
+
+      /** Constructor. Hashes a path at runtime.
+       * @param path The path of the asset.
+       */
+      AssetKey( std::string_view path ) ;
+
+      /** Constructor. Hashes a path at runtime.
+       * @param path The path of the asset.
+       */
+      AssetKey( const std::string& path ) ;
+
+      /** Static method to create a key out of a hash computed beforehand, e.g. loaded from a file.
+       * @param hash The hash of the key.
+       * @return The key of the hash.
+       */
+      static constexpr AssetKey fromHash( std::uint64_t hash ) { AssetKey key ; key.m_hash = hash ; return key ; } ;
+
+      /** Static method to hash a path with 64-bit FNV-1a.
+       * @param path The path to hash.
+       * @return The hash of the path.
+       */
+      static constexpr std::uint64_t hash( std::string_view path ) ;
+
+      /** Method to retrieve the hash of this key.
+       * @return The hash of this key.
+       */
+      constexpr std::uint64_t value() const { return this->m_hash ; } ;
+
+      /** Method to retrieve the path this key was made from, through the debug string table.
+       * @return The path of this key if remembered. An empty string otherwise, e.g. without MARS_ASSET_NAMES.
+       */
+      const char* name() const ;
+
+      /** Equality operator.
+       * @param key The key to compare against.
+       * @return Whether both keys are equal.
+       */
+      constexpr bool operator==( const AssetKey& key ) const { return this->m_hash == key.m_hash ; } ;
+
+      /** Inequality operator.
+       * @param key The key to compare against.
+       * @return Whether the keys differ.
+       */
+      constexpr bool operator!=( const AssetKey& key ) const { return this->m_hash != key.m_hash ; } ;
+
+      /** Less than operator, for ordered containers.
+       * @param key The key to compare against.
+       * @return Whether this key orders before the other.
+       */
+      constexpr bool operator<( const AssetKey& key ) const { return this->m_hash < key.m_hash ; } ;
+
+    private:
+
+      /** Friend declaration so the literal operator keys paths like string literals do.
+       */
+      friend constexpr AssetKey literals::operator""_asset( const char* path, std::size_t size ) ;
+
+      /** Constructor. Hashes a path of a known length, at compile time when used in a constant expression.
+       * @param path The path of the asset.
+       * @param size The length of the path.
+       */
+      constexpr AssetKey( const char* path, std::size_t size ) : m_hash( AssetKey::hash( std::string_view( path, size ) ) )
+      {
+        #if MARS_ASSET_NAMES && defined( MARS_CONSTANT_EVALUATED )
+          if( !MARS_CONSTANT_EVALUATED() ) AssetKey::remember( this->m_hash, std::string_view( path, size ) ) ;
+        #endif
+      }
+
+      /** Static helper method to add a path to the debug string table.
+       * @param hash The hash of the path.
+       * @param path The path to remember.
+       */
+      static void remember( std::uint64_t hash, std::string_view path ) ;
+
+      /** The FNV-1a hash of the path.
+       */
+      std::uint64_t m_hash ;
+  };
+
+  constexpr std::uint64_t AssetKey::hash( std::string_view path )
+  {
+    std::uint64_t hash = 0xCBF29CE484222325ull ;
+
+    for( const char character : path )
+    {
+      hash ^= static_cast<unsigned char>( character ) ;
+      hash *= 0x100000001B3ull ;
+    }
+
+    return hash ;
+  }
+
+  inline AssetKey::AssetKey( std::string_view path ) : m_hash( AssetKey::hash( path ) )
+  {
+    #if MARS_ASSET_NAMES
+      AssetKey::remember( this->m_hash, path ) ;
+    #endif
+  }
+
+  inline AssetKey::AssetKey( const std::string& path ) : AssetKey( std::string_view( path ) )
+  {
+  }
+
+  namespace literals
+  {
+    /** Literal operator to create asset keys, e.g. "textures/foo.ngt"_asset.
+     * @param path The path of the asset.
+     * @param size The length of the path.
+     * @return The key of the path.
+     */
+    constexpr AssetKey operator""_asset( const char* path, std::size_t size )
+    {
+      return AssetKey( path, size ) ;
+    }
+  }
+}
+
+/** Hash specialization so asset keys can be used with hashed containers. The key already is a hash.
+ */
+template<>
+struct std::hash<mars::AssetKey>
+{
+  std::size_t operator()( const mars::AssetKey& key ) const noexcept
+  {
+    return static_cast<std::size_t>( key.value() ) ;
+  }
+};
+
+/** Macro to create an asset key that is guaranteed to be hashed at compile time, even in unoptimized builds.
+ * @param path The string literal path of the asset.
+ */
+#define MARS_ASSET_KEY( path ) ::mars::AssetKey::fromHash( std::integral_constant<std::uint64_t, ::mars::AssetKey::hash( path )>::value )
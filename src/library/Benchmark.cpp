@@ -0,0 +1,342 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Benchmark.cpp
+ * Author: agent
+ *
+ * Created on October 16, 2026, 8:05 PM
+ */
+
+#include "Factory.h"
+#include "Manager.h"
+#include "JobSystem.h"
+#include "FlatMap.h"
+#include "ConcurrentMap.h"
+#include "Stats.h"
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <new>
+
+/** Counts every allocation made by the benchmarks, to measure allocations per call.
+ */
+static std::atomic<unsigned> allocations( 0 ) ;
+
+void* operator new( std::size_t size )
+{
+  allocations.fetch_add( 1, std::memory_order_relaxed ) ;
+  void* memory = std::malloc( size != 0 ? size : 1 ) ;
+  if( memory == nullptr ) std::abort() ;
+  return memory ;
+}
+
+void operator delete( void* memory ) noexcept
+{
+  std::free( memory ) ;
+}
+
+void operator delete( void* memory, std::size_t ) noexcept
+{
+  std::free( memory ) ;
+}
+
+namespace mars
+{
+  class Particle
+  {
+    public:
+      Particle() = default ;
+
+      void initialize( unsigned id ) { this->owner = id ; } ;
+      bool initialized() const { return this->owner != 0 ; } ;
+      void reset() { this->owner = 0 ; } ;
+
+      unsigned id() const { return this->owner ; } ;
+
+    private:
+      unsigned owner = 0 ;
+  };
+
+  /** Parameter type that is expensive to copy, and counts how often it is.
+   */
+  struct Heavy
+  {
+    Heavy() : payload( 1024 ) {} ;
+    Heavy( const Heavy& heavy ) : payload( heavy.payload ) { Heavy::copies++ ; } ;
+    Heavy( Heavy&& heavy ) = default ;
+    Heavy& operator=( const Heavy& heavy ) { this->payload = heavy.payload ; Heavy::copies++ ; return *this ; } ;
+    Heavy& operator=( Heavy&& heavy ) = default ;
+
+    std::vector<unsigned> payload ;
+    static unsigned       copies  ;
+  };
+
+  unsigned Heavy::copies = 0 ;
+
+  class Mesh
+  {
+    public:
+      Mesh() = default ;
+      Mesh( std::string name, Heavy heavy ) : name( std::move( name ) ), heavy( std::move( heavy ) ) {} ;
+
+      void initialize( std::string name, Heavy heavy ) { this->name = std::move( name ) ; this->heavy = std::move( heavy ) ; } ;
+      bool initialized() const { return !this->name.empty() ; } ;
+      void reset() { this->name.clear() ; this->heavy.payload.clear() ; } ;
+
+    private:
+      std::string name  ;
+      Heavy       heavy ;
+  };
+
+  /** Measures the copies & allocations each create path makes for heavy parameters, on top of building the parameters themselves.
+   */
+  void benchmark_forwarding()
+  {
+    using Factory = mars::Factory<Mesh> ;
+    using Manager = mars::Manager<unsigned, Mesh> ;
+
+    constexpr unsigned COUNT = 1000 ;
+
+    std::vector<std::string> names ;
+    std::vector<Heavy>       heavies ;
+
+    auto prepare = [ &names, &heavies ]()
+    {
+      names  .assign( COUNT, std::string( 64, 'a' ) ) ;
+      heavies.assign( COUNT, Heavy()                ) ;
+    };
+
+    auto measure = [ & ]( const char* name, auto create )
+    {
+      prepare() ;
+
+      const unsigned copies = Heavy::copies ;
+      const unsigned start  = allocations.load() ;
+
+      for( unsigned index = 0; index < COUNT; index++ ) create( index ) ;
+
+      std::cout << "  " << name << ": " << static_cast<double>( Heavy::copies - copies ) / COUNT << " copies, " << static_cast<double>( allocations.load() - start ) / COUNT << " allocations per call" << std::endl ;
+    };
+
+    std::vector<Data<Mesh>> meshes ;
+
+    Factory::reserve( COUNT ) ;
+    meshes.reserve( COUNT ) ;
+
+    std::cout << "Heavy parameters:" << std::endl ;
+
+    measure( "Factory::create ", [ & ]( unsigned index ) { meshes.push_back( Factory::create( std::move( names[ index ] ), std::move( heavies[ index ] ) ) ) ; } ) ;
+    measure( "Manager::create ", [ & ]( unsigned index ) { Manager::create( index, std::move( names[ index ] ), std::move( heavies[ index ] ) ) ; } ) ;
+    measure( "Manager::emplace", [ & ]( unsigned index ) { Manager::emplace( COUNT + index, std::move( names[ index ] ), std::move( heavies[ index ] ) ) ; } ) ;
+
+    Factory::destroyBatch( meshes ) ;
+    Factory::cleanup() ;
+    Manager::cleanup() ;
+  }
+
+  /** Measures create/destroy throughput of a factory as threads are added.
+   */
+  void benchmark_factory()
+  {
+    using Factory = mars::Factory<Particle> ;
+
+    constexpr unsigned ITERATIONS  = 200000 ;
+    constexpr unsigned MAX_THREADS = 32     ;
+
+    std::cout << "Factory create/destroy:" << std::endl ;
+
+    for( unsigned count = 1; count <= MAX_THREADS; count *= 2 )
+    {
+      std::vector<std::thread> threads ;
+      const auto start = std::chrono::steady_clock::now() ;
+
+      for( unsigned thread = 0; thread < count; thread++ )
+      {
+        threads.emplace_back( [ thread ]()
+        {
+          for( unsigned iteration = 0; iteration < ITERATIONS; iteration++ )
+          {
+            auto particle = Factory::create( thread + 1 ) ;
+            Factory::destroy( particle ) ;
+          }
+        } ) ;
+      }
+
+      for( auto& thread : threads ) thread.join() ;
+
+      const std::chrono::duration<double> time = std::chrono::steady_clock::now() - start ;
+      std::cout << "  " << count << " threads: " << static_cast<unsigned>( count * ITERATIONS / time.count() ) << " create/destroy per second" << std::endl ;
+    }
+
+    Factory::cleanup() ;
+  }
+
+  /** Measures how a parallel loop over a large array scales with the amount of threads.
+   */
+  void benchmark_job_system()
+  {
+    constexpr unsigned COUNT = 1 << 22 ;
+
+    std::vector<float>    values( COUNT, 2.0f ) ;
+    std::vector<unsigned> counts ;
+    const unsigned        hardware = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1 ;
+    double                single   = 0.0 ;
+
+    for( unsigned threads = 1; threads < hardware; threads *= 2 ) counts.push_back( threads ) ;
+    counts.push_back( hardware ) ;
+
+    std::cout << "JobSystem parallelFor:" << std::endl ;
+
+    for( unsigned threads : counts )
+    {
+      mars::JobSystem system( threads - 1 ) ;
+
+      const auto start = std::chrono::steady_clock::now() ;
+
+      for( unsigned pass = 0; pass < 8; pass++ )
+      {
+        system.parallelFor( COUNT, 4096, [ &values ]( unsigned begin, unsigned end )
+        {
+          for( unsigned index = begin; index < end; index++ ) values[ index ] = std::sqrt( values[ index ] * values[ index ] ) ;
+        } ) ;
+      }
+
+      const std::chrono::duration<double> time = std::chrono::steady_clock::now() - start ;
+
+      if( threads == 1 ) single = time.count() ;
+      std::cout << "  " << threads << " threads: " << static_cast<unsigned>( 8.0 * COUNT / time.count() ) << " items per second, " << single / time.count() << "x" << std::endl ;
+    }
+  }
+
+  /** Measures lock-free Manager lookups as readers are added.
+   */
+  void benchmark_manager()
+  {
+    using Manager = mars::Manager<unsigned, Particle> ;
+
+    constexpr unsigned KEYS       = 1024   ;
+    constexpr unsigned ITERATIONS = 200000 ;
+    constexpr unsigned THREADS    = 16     ;
+
+    std::vector<std::thread> threads ;
+    std::atomic<unsigned>    found( 0 ) ;
+
+    for( unsigned key = 0; key < KEYS; key++ ) Manager::create( key, key + 1 ) ;
+
+    std::cout << "Manager lookups:" << std::endl ;
+
+    for( unsigned count = 1; count <= THREADS; count *= 2 )
+    {
+      const auto start = std::chrono::steady_clock::now() ;
+
+      for( unsigned thread = 0; thread < count; thread++ )
+      {
+        threads.emplace_back( [ &found, thread ]()
+        {
+          unsigned local = 0 ;
+
+          for( unsigned iteration = 0; iteration < ITERATIONS; iteration++ )
+          {
+            if( Manager::reference( ( iteration + thread ) % KEYS )->initialized() ) local++ ;
+          }
+
+          found += local ;
+        } ) ;
+      }
+
+      for( auto& thread : threads ) thread.join() ;
+      threads.clear() ;
+
+      const std::chrono::duration<double> time = std::chrono::steady_clock::now() - start ;
+      std::cout << "  " << count << " threads: " << static_cast<unsigned>( count * ITERATIONS / time.count() ) << " lookups per second" << std::endl ;
+    }
+
+    Manager::cleanup() ;
+  }
+
+  /** Measures lookup latency of the flat map against the node based map & the concurrent map Manager uses.
+   */
+  void benchmark_maps()
+  {
+    constexpr unsigned COUNT   = 100000  ;
+    constexpr unsigned LOOKUPS = 2000000 ;
+
+    std::unordered_map<unsigned, unsigned>    nodes      ;
+    mars::FlatMap<unsigned, unsigned>         flat       ;
+    mars::ConcurrentMap<unsigned, unsigned>   concurrent ;
+    unsigned                                  found = 0  ;
+
+    for( unsigned key = 0; key < COUNT; key++ )
+    {
+      unsigned value ;
+
+      nodes[ key * 2654435761u ] = key ;
+      flat [ key * 2654435761u ] = key ;
+      concurrent.insert( key * 2654435761u, [ key ]() { return key ; }, value ) ;
+    }
+
+    auto measure = [ & ]( const char* name, auto lookup )
+    {
+      const auto start = std::chrono::steady_clock::now() ;
+
+      for( unsigned lookup_index = 0; lookup_index < LOOKUPS; lookup_index++ ) found += lookup( ( lookup_index * 40503u ) % COUNT * 2654435761u ) ;
+
+      const std::chrono::duration<double, std::nano> time = std::chrono::steady_clock::now() - start ;
+      std::cout << "  " << name << ": " << time.count() / LOOKUPS << "ns per lookup" << std::endl ;
+    };
+
+    std::cout << "Map lookups:" << std::endl ;
+
+    measure( "std::unordered_map ", [ &nodes ]( unsigned key ) { return nodes.find( key ) != nodes.end() ? 1u : 0u ; } ) ;
+    measure( "mars::FlatMap      ", [ &flat ]( unsigned key ) { return flat.find( key ) != flat.end() ? 1u : 0u ; } ) ;
+    measure( "mars::ConcurrentMap", [ &concurrent ]( unsigned key ) { unsigned value ; return concurrent.find( key, value ) ? 1u : 0u ; } ) ;
+
+    // Keeps the lookups from being optimized away.
+    if( found != LOOKUPS * 3 ) std::cout << "  Missed " << LOOKUPS * 3 - found << " lookups" << std::endl ;
+  }
+
+  /** Prints the counters of every factory used by the benchmarks.
+   */
+  void benchmark_stats()
+  {
+    std::cout << "Factory stats:" << std::endl ;
+
+    for( const auto& factory : mars::factoryStats() )
+    {
+      std::cout << "  " << factory.name << ": " << factory.live << " live, " << factory.pooled << " pooled, " << factory.hits << " hits, " << factory.misses << " misses, " << factory.refills << " refills, " << factory.depot_time << "ns in depot" << std::endl ;
+    }
+  }
+}
+
+int main()
+{
+  mars::benchmark_forwarding() ;
+  mars::benchmark_factory   () ;
+  mars::benchmark_job_system() ;
+  mars::benchmark_manager   () ;
+  mars::benchmark_maps      () ;
+  mars::benchmark_stats     () ;
+
+  return 0 ;
+}
@@ -0,0 +1,614 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   ConcurrentMap.h
+ * Author: agent
+ *
+ * Created on October 16, 2026, 7:00 PM
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+#include "Epoch.h"
+#include "FlatMap.h"
+
+namespace mars
+{
+  /** Hash map safe to use from any amount of threads at once.
+   * Keys are spread over shards, each with its own lock for writers. Every shard is a flat, open addressed table with entries stored inline, probed a group of control bytes at a time like FlatMap.
+   * Lookups take no lock at all. An entry is never changed once its control byte is published, erased entries only have their control byte marked, and a shard's table is only freed through Epoch once it was replaced.
+   * Writers to the same shard are serialized, so concurrent inserts of the same key always resolve to a single entry.
+   * @tparam Key The type of key.
+   * @tparam Value The type of value. Copied out by lookups, so it should be cheap to copy.
+   * @tparam Hash The hash function of keys.
+   */
+  template<typename Key, typename Value, typename Hash = std::hash<Key>>
+  class ConcurrentMap
+  {
+    public:
+
+      /** Default constructor. Constant so that static maps are initialized before any dynamic initialization runs.
+       */
+      constexpr ConcurrentMap() : shards() {} ;
+
+      /** Deconstructor. Frees every entry.
+       */
+      ~ConcurrentMap() ;
+
+      /** Copying is disallowed.
+       */
+      ConcurrentMap( const ConcurrentMap& map ) = delete ;
+
+      /** Copying is disallowed.
+       */
+      ConcurrentMap& operator=( const ConcurrentMap& map ) = delete ;
+
+      /** Method to look up the value of a key. Lock-free.
+       * @param key The key to look up.
+       * @param value The value to copy the key's value into, if found.
+       * @return Whether or not the key was found.
+       */
+      bool find( const Key& key, Value& value ) const ;
+
+      /** Method to check whether a key is in this map. Lock-free.
+       * @param key The key to look for.
+       * @return Whether or not the key is in this map.
+       */
+      bool contains( const Key& key ) const ;
+
+      /** Method to look up the values of many keys at once, e.g. every asset of a scene. Lock-free.
+       * Pins the epoch once for the whole batch, and prefetches the groups of upcoming keys while probing the current one.
+       * @param keys The keys to look up.
+       * @param count The amount of keys.
+       * @param visit The function to hand the values found to, called as visit( index, value ) with the epoch still pinned.
+       * @return The amount of keys found.
+       */
+      template<typename Visit>
+      unsigned findMany( const Key* keys, unsigned count, Visit visit ) const ;
+
+      /** Method to insert a key, unless it is already in this map.
+       * @param key The key to insert.
+       * @param make The function to create the value with, called as make(), only if the key is not in this map yet. Called with the key's shard locked.
+       * @param value The value of the key once this returns, whether inserted or already present.
+       * @return Whether or not the key was inserted.
+       */
+      template<typename Make>
+      bool insert( const Key& key, Make make, Value& value ) ;
+
+      /** Method to insert many keys at once, unless they are already in this map. Every shard is locked at most once, for all of its keys in the batch.
+       * @param keys The keys to insert. Keys appearing more than once are inserted once.
+       * @param count The amount of keys.
+       * @param make The function to create the value of a key with, called as make( index ), only if the key is not in this map yet. Called with the key's shard locked.
+       * @param visit The function to hand the value of every key to, called as visit( index, value ) with the key's shard locked, whether inserted or already present.
+       * @return The amount of keys inserted.
+       */
+      template<typename Make, typename Visit>
+      unsigned insertMany( const Key* keys, unsigned count, Make make, Visit visit ) ;
+
+      /** Method to erase every entry a predicate selects. Erased entries are freed once their table is rebuilt & no lookup can see it anymore.
+       * @param predicate The predicate, called as predicate( key, value ) with the entry's shard locked.
+       * @return The amount of entries erased.
+       */
+      template<typename Predicate>
+      unsigned eraseIf( Predicate predicate ) ;
+
+      /** Method to erase a single key, if a predicate selects its entry. Only touches the key's shard.
+       * @param key The key to erase.
+       * @param predicate The predicate, called as predicate( key, value ) with the key's shard locked.
+       * @return Whether or not the key was erased.
+       */
+      template<typename Predicate>
+      bool eraseIf( const Key& key, Predicate predicate ) ;
+
+      /** Method to retrieve the amount of entries in this map.
+       * @return The amount of entries in this map.
+       */
+      unsigned size() const ;
+
+    private:
+
+      /** The amount of shards. A power of two.
+       */
+      static constexpr unsigned SHARDS = 64 ;
+
+      /** The amount of keys batched operations look ahead by, prefetching their groups.
+       */
+      static constexpr unsigned LOOKAHEAD = 8 ;
+
+      /** An immutable key-value pair.
+       */
+      struct Entry
+      {
+        Key   key   ; ///< The key.
+        Value value ; ///< The value.
+      };
+
+      /** Flat table of entries, read without locks.
+       */
+      struct Table
+      {
+        unsigned                   capacity ; ///< The amount of slots. A power of two, and a multiple of the group size.
+        unsigned                   deleted  ; ///< The amount of erased slots.
+        std::atomic<std::uint8_t>* control  ; ///< The control byte of every slot.
+        Entry*                     entries  ; ///< The storage of every slot.
+      };
+
+      /** A lock & table for a part of the key space. On its own cache line so shards do not slow each other down.
+       */
+      struct alignas( 64 ) Shard
+      {
+        std::mutex            lock                ; ///< The lock writers take.
+        std::atomic<Table*>   table = { nullptr } ; ///< The current table. Replaced when grown.
+        unsigned              used  = 0           ; ///< The amount of slots holding entries or erased entries.
+        std::atomic<unsigned> count = { 0 }       ; ///< The amount of entries.
+      };
+
+      /** Helper method to allocate an empty table.
+       * @param capacity The amount of slots of the table.
+       * @return The allocated table.
+       */
+      static Table* allocate( unsigned capacity ) ;
+
+      /** Helper method to free a table, along with every entry it holds, erased or not.
+       * @param table The table to free.
+       */
+      static void deallocate( void* table ) ;
+
+      /** Helper method to prefetch the first group a key probes, along with its entries.
+       * @param table The table the key is probed in. May be nullptr.
+       * @param hash The mixed hash of the key.
+       */
+      static void prefetch( const Table* table, std::uint64_t hash ) ;
+
+      /** Helper method to look up a key in a table.
+       * @param table The table to search.
+       * @param key The key to look up.
+       * @param hash The mixed hash of the key.
+       * @return The entry of the key. nullptr if missing.
+       */
+      static const Entry* locate( const Table* table, const Key& key, std::uint64_t hash ) ;
+
+      /** Helper method to mark a slot erased, rebuilding the table once mostly erased. The shard must be locked.
+       * @param shard The shard of the slot.
+       * @param index The index of the slot in the shard's table.
+       */
+      static void erase( Shard& shard, unsigned index ) ;
+
+      /** Helper method to construct an entry in the first empty slot of its probe sequence, then publish it. The shard must be locked.
+       * @param table The table to place the entry into.
+       * @param hash The mixed hash of the entry's key.
+       * @param key The key of the entry.
+       * @param value The value of the entry.
+       * @return The placed entry.
+       */
+      static const Entry* place( Table* table, std::uint64_t hash, const Key& key, const Value& value ) ;
+
+      /** Helper method to replace a shard's table with a new one holding only its live entries. The shard must be locked.
+       * @param shard The shard to rebuild.
+       * @param capacity The amount of slots of the new table.
+       */
+      static void rebuild( Shard& shard, unsigned capacity ) ;
+
+      /** Helper method to make room for one more entry, growing or rebuilding the table if needed. The shard must be locked.
+       * @param shard The shard to make room in.
+       * @return The table to insert into.
+       */
+      static Table* reserve( Shard& shard ) ;
+
+      /** Helper method to retrieve the shard of a hash.
+       * @param hash The mixed hash of a key.
+       * @return Reference to the shard of the hash.
+       */
+      Shard& shard( std::uint64_t hash ) const ;
+
+      /** The shards of this map.
+       */
+      mutable Shard shards[ SHARDS ] ;
+  };
+
+  template<typename Key, typename Value, typename Hash>
+  ConcurrentMap<Key, Value, Hash>::~ConcurrentMap()
+  {
+    for( Shard& shard : this->shards )
+    {
+      Table* table = shard.table.load( std::memory_order_relaxed ) ;
+
+      if( table ) ConcurrentMap::deallocate( table ) ;
+    }
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  bool ConcurrentMap<Key, Value, Hash>::find( const Key& key, Value& value ) const
+  {
+    const std::uint64_t hash  = mixHash( Hash()( key ) ) ;
+    Shard&              shard = this->shard( hash )      ;
+    Epoch::Guard        guard                            ;
+    const Table*        table = shard.table.load( std::memory_order_seq_cst ) ;
+    const Entry*        entry = table ? ConcurrentMap::locate( table, key, hash ) : nullptr ;
+
+    if( entry ) value = entry->value ;
+
+    return entry != nullptr ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  bool ConcurrentMap<Key, Value, Hash>::contains( const Key& key ) const
+  {
+    Value value ;
+
+    return this->find( key, value ) ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  template<typename Visit>
+  unsigned ConcurrentMap<Key, Value, Hash>::findMany( const Key* keys, unsigned count, Visit visit ) const
+  {
+    std::uint64_t hashes[ LOOKAHEAD ] ;
+    unsigned      found = 0           ;
+    Epoch::Guard  guard               ;
+
+    for( unsigned index = 0; index < count && index < LOOKAHEAD; index++ )
+    {
+      hashes[ index ] = mixHash( Hash()( keys[ index ] ) ) ;
+      ConcurrentMap::prefetch( this->shard( hashes[ index ] ).table.load( std::memory_order_acquire ), hashes[ index ] ) ;
+    }
+
+    for( unsigned index = 0; index < count; index++ )
+    {
+      const std::uint64_t hash  = hashes[ index % LOOKAHEAD ] ;
+      const unsigned      ahead = index + LOOKAHEAD          ;
+
+      // The slot of this key is reused for the key LOOKAHEAD ahead, whose group loads while this one is probed.
+      if( ahead < count )
+      {
+        hashes[ ahead % LOOKAHEAD ] = mixHash( Hash()( keys[ ahead ] ) ) ;
+        ConcurrentMap::prefetch( this->shard( hashes[ ahead % LOOKAHEAD ] ).table.load( std::memory_order_acquire ), hashes[ ahead % LOOKAHEAD ] ) ;
+      }
+
+      const Table* table = this->shard( hash ).table.load( std::memory_order_seq_cst ) ;
+      const Entry* entry = table ? ConcurrentMap::locate( table, keys[ index ], hash ) : nullptr ;
+
+      if( entry )
+      {
+        visit( index, entry->value ) ;
+        found++ ;
+      }
+    }
+
+    return found ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  template<typename Make>
+  bool ConcurrentMap<Key, Value, Hash>::insert( const Key& key, Make make, Value& value )
+  {
+    const std::uint64_t         hash  = mixHash( Hash()( key ) ) ;
+    Shard&                      shard = this->shard( hash )      ;
+    std::lock_guard<std::mutex> lock( shard.lock )               ;
+
+    const Table* table = shard.table.load( std::memory_order_relaxed ) ;
+    const Entry* entry = table ? ConcurrentMap::locate( table, key, hash ) : nullptr ;
+
+    if( entry )
+    {
+      value = entry->value ;
+      return false ;
+    }
+
+    value = make() ;
+
+    ConcurrentMap::place( ConcurrentMap::reserve( shard ), hash, key, value ) ;
+
+    shard.used++ ;
+    shard.count.fetch_add( 1, std::memory_order_relaxed ) ;
+
+    return true ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  template<typename Make, typename Visit>
+  unsigned ConcurrentMap<Key, Value, Hash>::insertMany( const Key* keys, unsigned count, Make make, Visit visit )
+  {
+    std::vector<std::uint64_t> hashes( count ) ;
+    std::vector<unsigned>      owners( count ) ;
+    std::vector<unsigned>      order ( count ) ;
+    unsigned                   start[ SHARDS + 1 ] = {} ;
+    unsigned                   next [ SHARDS     ]      ;
+    unsigned                   inserted = 0             ;
+    Epoch::Guard               guard                    ;
+
+    // Keys are ordered by shard, so each shard is locked once for all of its keys.
+    for( unsigned index = 0; index < count; index++ )
+    {
+      hashes[ index ] = mixHash( Hash()( keys[ index ] ) ) ;
+      owners[ index ] = static_cast<unsigned>( &this->shard( hashes[ index ] ) - this->shards ) ;
+      start[ owners[ index ] + 1 ]++ ;
+    }
+
+    for( unsigned shard = 0; shard < SHARDS; shard++ ) start[ shard + 1 ] += start[ shard ] ;
+
+    std::copy( start, start + SHARDS, next ) ;
+
+    for( unsigned index = 0; index < count; index++ ) order[ next[ owners[ index ] ]++ ] = index ;
+
+    for( unsigned shard = 0; shard < SHARDS; shard++ )
+    {
+      if( start[ shard ] == start[ shard + 1 ] ) continue ;
+
+      Shard&                      current = this->shards[ shard ] ;
+      std::lock_guard<std::mutex> lock( current.lock )           ;
+
+      for( unsigned position = start[ shard ]; position < start[ shard + 1 ]; position++ )
+      {
+        const unsigned      index = order [ position ] ;
+        const std::uint64_t hash  = hashes[ index    ] ;
+
+        // The table only changes through this writer, so the prefetched group is still the one probed.
+        if( position + LOOKAHEAD < start[ shard + 1 ] ) ConcurrentMap::prefetch( current.table.load( std::memory_order_relaxed ), hashes[ order[ position + LOOKAHEAD ] ] ) ;
+
+        const Table* table = current.table.load( std::memory_order_relaxed ) ;
+        const Entry* entry = table ? ConcurrentMap::locate( table, keys[ index ], hash ) : nullptr ;
+
+        if( entry )
+        {
+          visit( index, entry->value ) ;
+          continue ;
+        }
+
+        const Value value = make( index ) ;
+
+        ConcurrentMap::place( ConcurrentMap::reserve( current ), hash, keys[ index ], value ) ;
+
+        current.used++ ;
+        current.count.fetch_add( 1, std::memory_order_relaxed ) ;
+        inserted++ ;
+
+        visit( index, value ) ;
+      }
+    }
+
+    return inserted ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  template<typename Predicate>
+  unsigned ConcurrentMap<Key, Value, Hash>::eraseIf( Predicate predicate )
+  {
+    unsigned erased = 0 ;
+
+    for( Shard& shard : this->shards )
+    {
+      std::lock_guard<std::mutex> lock( shard.lock ) ;
+
+      Table* table = shard.table.load( std::memory_order_relaxed ) ;
+
+      if( !table ) continue ;
+
+      for( unsigned index = 0; index < table->capacity; index++ )
+      {
+        const std::uint8_t control = table->control[ index ].load( std::memory_order_relaxed ) ;
+
+        if( ( control & 0x80 ) || !predicate( table->entries[ index ].key, table->entries[ index ].value ) ) continue ;
+
+        // Lookups may still be reading the entry, so it stays constructed until the table itself is freed.
+        table->control[ index ].store( Group::DELETED, std::memory_order_release ) ;
+        table->deleted++ ;
+        shard.count.fetch_sub( 1, std::memory_order_relaxed ) ;
+        erased++ ;
+      }
+
+      // Mostly erased tables are rebuilt, so erased entries do not pile up without inserts.
+      if( table->deleted * 4 > table->capacity ) ConcurrentMap::rebuild( shard, table->capacity ) ;
+    }
+
+    return erased ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  template<typename Predicate>
+  bool ConcurrentMap<Key, Value, Hash>::eraseIf( const Key& key, Predicate predicate )
+  {
+    const std::uint64_t         hash  = mixHash( Hash()( key ) ) ;
+    Shard&                      shard = this->shard( hash )      ;
+    std::lock_guard<std::mutex> lock( shard.lock )               ;
+
+    const Table* table = shard.table.load( std::memory_order_relaxed ) ;
+    const Entry* entry = table ? ConcurrentMap::locate( table, key, hash ) : nullptr ;
+
+    if( !entry || !predicate( entry->key, entry->value ) ) return false ;
+
+    ConcurrentMap::erase( shard, static_cast<unsigned>( entry - table->entries ) ) ;
+
+    return true ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  void ConcurrentMap<Key, Value, Hash>::erase( Shard& shard, unsigned index )
+  {
+    Table* table = shard.table.load( std::memory_order_relaxed ) ;
+
+    // Lookups may still be reading the entry, so it stays constructed until the table itself is freed.
+    table->control[ index ].store( Group::DELETED, std::memory_order_release ) ;
+    table->deleted++ ;
+    shard.count.fetch_sub( 1, std::memory_order_relaxed ) ;
+
+    if( table->deleted * 4 > table->capacity ) ConcurrentMap::rebuild( shard, table->capacity ) ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  unsigned ConcurrentMap<Key, Value, Hash>::size() const
+  {
+    unsigned size = 0 ;
+
+    for( const Shard& shard : this->shards ) size += shard.count.load( std::memory_order_relaxed ) ;
+
+    return size ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  typename ConcurrentMap<Key, Value, Hash>::Table* ConcurrentMap<Key, Value, Hash>::allocate( unsigned capacity )
+  {
+    Table* table = new Table() ;
+
+    table->capacity = capacity ;
+    table->deleted  = 0 ;
+    table->control  = new std::atomic<std::uint8_t>[ capacity ] ;
+    table->entries  = std::allocator<Entry>().allocate( capacity ) ;
+
+    for( unsigned index = 0; index < capacity; index++ ) table->control[ index ].store( Group::EMPTY, std::memory_order_relaxed ) ;
+
+    return table ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  void ConcurrentMap<Key, Value, Hash>::deallocate( void* memory )
+  {
+    Table* table = static_cast<Table*>( memory ) ;
+
+    for( unsigned index = 0; index < table->capacity; index++ )
+    {
+      if( table->control[ index ].load( std::memory_order_relaxed ) != Group::EMPTY ) table->entries[ index ].~Entry() ;
+    }
+
+    std::allocator<Entry>().deallocate( table->entries, table->capacity ) ;
+    delete[] table->control ;
+    delete   table ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  void ConcurrentMap<Key, Value, Hash>::prefetch( const Table* table, std::uint64_t hash )
+  {
+    if( !table ) return ;
+
+    const unsigned groups = table->capacity / Group::SIZE                         ;
+    const unsigned group  = static_cast<unsigned>( hash >> 7 ) & ( groups - 1 ) ;
+
+    mars::prefetch( table->control + group * Group::SIZE ) ;
+    mars::prefetch( table->entries + group * Group::SIZE ) ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  const typename ConcurrentMap<Key, Value, Hash>::Entry* ConcurrentMap<Key, Value, Hash>::locate( const Table* table, const Key& key, std::uint64_t hash )
+  {
+    const unsigned     groups = table->capacity / Group::SIZE                         ;
+    const std::uint8_t tag    = static_cast<std::uint8_t>( hash & 0x7F )             ;
+    unsigned           group  = static_cast<unsigned>( hash >> 7 ) & ( groups - 1 ) ;
+
+    for( unsigned probe = 1; probe <= groups; probe++ )
+    {
+      const unsigned base = group * Group::SIZE             ;
+      const Group    bytes( table->control + base )          ;
+
+      for( Group::Mask mask = bytes.match( tag ); mask; mask = Group::next( mask ) )
+      {
+        const Entry& entry = table->entries[ base + Group::lowest( mask ) ] ;
+
+        if( entry.key == key ) return &entry ;
+      }
+
+      if( bytes.empty() ) return nullptr ;
+
+      group = ( group + probe ) & ( groups - 1 ) ;
+    }
+
+    return nullptr ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  const typename ConcurrentMap<Key, Value, Hash>::Entry* ConcurrentMap<Key, Value, Hash>::place( Table* table, std::uint64_t hash, const Key& key, const Value& value )
+  {
+    const unsigned groups = table->capacity / Group::SIZE                         ;
+    unsigned       group  = static_cast<unsigned>( hash >> 7 ) & ( groups - 1 ) ;
+
+    // Only empty slots are used. Erased slots may still be read, so they are only reclaimed by rebuilding.
+    for( unsigned probe = 1; ; probe++ )
+    {
+      const unsigned    base = group * Group::SIZE ;
+      const Group::Mask mask = Group( table->control + base ).empty() ;
+
+      if( mask )
+      {
+        const unsigned index = base + Group::lowest( mask ) ;
+
+        new ( &table->entries[ index ] ) Entry{ key, value } ;
+        table->control[ index ].store( static_cast<std::uint8_t>( hash & 0x7F ), std::memory_order_release ) ;
+
+        return &table->entries[ index ] ;
+      }
+
+      group = ( group + probe ) & ( groups - 1 ) ;
+    }
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  void ConcurrentMap<Key, Value, Hash>::rebuild( Shard& shard, unsigned capacity )
+  {
+    Table* table   = shard.table.load( std::memory_order_relaxed ) ;
+    Table* rebuilt = ConcurrentMap::allocate( capacity )           ;
+
+    // Entries are copied, as lookups may still read them from the old table.
+    for( unsigned index = 0; table && index < table->capacity; index++ )
+    {
+      if( table->control[ index ].load( std::memory_order_relaxed ) & 0x80 ) continue ;
+
+      const Entry& entry = table->entries[ index ] ;
+
+      ConcurrentMap::place( rebuilt, mixHash( Hash()( entry.key ) ), entry.key, entry.value ) ;
+    }
+
+    shard.table.store( rebuilt, std::memory_order_seq_cst ) ;
+    shard.used = shard.count.load( std::memory_order_relaxed ) ;
+
+    if( table ) Epoch::retire( table, &ConcurrentMap::deallocate ) ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  typename ConcurrentMap<Key, Value, Hash>::Table* ConcurrentMap<Key, Value, Hash>::reserve( Shard& shard )
+  {
+    Table* table = shard.table.load( std::memory_order_relaxed ) ;
+
+    // Grows at 7/8 full, counting erased slots, which rebuilding drops. The table only doubles if the live entries need it.
+    if( !table || ( shard.used + 1 ) * 8 > table->capacity * 7 )
+    {
+      const unsigned count    = shard.count.load( std::memory_order_relaxed ) ;
+      unsigned       capacity = table ? table->capacity : Group::SIZE ;
+
+      while( ( count + 1 ) * 2 > capacity ) capacity *= 2 ;
+
+      ConcurrentMap::rebuild( shard, capacity ) ;
+    }
+
+    return shard.table.load( std::memory_order_relaxed ) ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  typename ConcurrentMap<Key, Value, Hash>::Shard& ConcurrentMap<Key, Value, Hash>::shard( std::uint64_t hash ) const
+  {
+    // The top bits pick the shard, the low bits the control byte & group within it.
+    return this->shards[ ( hash >> 58 ) & ( SHARDS - 1 ) ] ;
+  }
+}
@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Data.h
+ * Author: agent
+ *
+ * Created on October 16, 2026, 6:42 PM
+ */
+
+#pragma once
+
+#include "Slab.h"
+#include "Handle.h"
+#include "Mars.h"
+
+namespace mars
+{
+  /** Forward declare for data friendship.
+   */
+  template<typename Type>
+  class Factory ;
+  
+  /** Forward declare for data friendship.
+   */
+  template<typename Type>
+  class Pool ;
+  
+  /** Forward declare for data friendship.
+   */
+  template<typename Key, typename Type>
+  class Manager ;
+  
+  /** Forward declare for data friendship.
+   */
+  template<typename Type>
+  class WeakReference ;
+  
+  /** Wrapper object for a object retrieved from the factory.
+   * @note Holds a single pointer to the object's slab cell. The reference count lives in the cell, next to the object.
+   *       Accesses are checked according to MARS_CHECKED_ACCESS.
+   */
+  template<typename Type>
+  class Data
+  {
+    public:
+      
+      /** Copy constructor. Adds a reference to the input's object.
+       * @param data The data to copy.
+       */
+      Data( const Data<Type>& data ) ;
+      
+      /** Move constructor. Takes the input's reference.
+       * @param data The data to move.
+       */
+      Data( Data<Type>&& data ) ;
+      
+      /** Copy assignment. Adds a reference to the input's object & removes this object's previous reference.
+       * @param data The data to copy.
+       * @return Reference to this object after assignment.
+       */
+      Data<Type>& operator=( const Data<Type>& data ) ;
+      
+      /** Move assignment. Takes the input's reference & removes this object's previous reference.
+       * @param data The data to move.
+       * @return Reference to this object after assignment.
+       */
+      Data<Type>& operator=( Data<Type>&& data ) ;
+      
+      /** The amount of references of this data.
+       * @return The amount of references for this data.
+       */
+      unsigned count() const ;
+
+      /** Conversion operator to boolean to check for validation.
+       * @return True if this object holds a valid reference. ( initialized & not de-referenced. )
+       */
+      operator bool() const ;
+      
+      /** Arrow overload to access underlying reference functions.
+       * @return Pointer to this object's underlying reference.
+       * @note Forwards a Mars library error on invalid access.
+       */
+      Type* operator->() ;
+      
+      /** Arrow overload to access underlying reference functions.
+       * @return Const Pointer to this object's underlying reference.
+       * @note Forwards a Mars library error on invalid access.
+       */
+      const Type* operator->() const ;
+      
+      /** Star overload to access a reference to this object's underlying data.
+       * @return Reference to this object's underlying data.
+       * @note Forwards a Mars library error on invalid access.
+       */
+      Type& operator*() ;
+      
+      /** Star overload to access a const reference to this object's underlying data.
+       * @return Const reference to this object's underlying data.
+       * @note Forwards a Mars library error on invalid access.
+       */
+      const Type& operator*() const ;
+      
+      /** Method to retrieve a lightweight handle to this object's underlying data.
+       * @return A handle to this object's data. Invalid if this object holds nothing, or its data belongs to an instanced Pool, as handles only resolve against the global slab.
+       */
+      Handle<Type> handle() const ;
+      
+      /** Deconstructor to allow saving off these objects and letting them die. Does not re-add this data back into the factory.
+       */
+      ~Data() ;
+
+    private:
+      
+      /** Helper method to access this object's underlying data, checked according to MARS_CHECKED_ACCESS.
+       * @return Pointer to this object's underlying data.
+       */
+      Type* access() const ;
+      
+      /** Friend decleration so the factory can access this object.
+       */
+      template<typename Type2>
+      friend class Factory ;
+      
+      template<typename Type2>
+      friend class Pool ;
+      
+      template<typename Key, typename Type2>
+      friend class Manager ;
+      
+      template<typename Type2>
+      friend class WeakReference ;
+      
+      /** Privated constructor so only the factory can create copies of this object.
+       */
+      Data() ;
+      
+      /** Underlying slab cell holding this object's data.
+       */
+      Cell<Type>* m_cell ;
+  };
+  
+  template<typename Type>
+  Data<Type>::Data()
+  {
+    this->m_cell = nullptr ;
+  }
+  
+  template<typename Type>
+  Data<Type>::Data( const Data<Type>& data )
+  {
+    this->m_cell = data.m_cell ;
+    if( this->m_cell ) this->m_cell->reference() ;
+  }
+  
+  template<typename Type>
+  Data<Type>::Data( Data<Type>&& data )
+  {
+    this->m_cell = data.m_cell ;
+    data.m_cell  = nullptr     ;
+  }
+  
+  template<typename Type>
+  Data<Type>& Data<Type>::operator=( const Data<Type>& data )
+  {
+    if( data.m_cell ) data.m_cell->reference() ;
+    if( this->m_cell ) this->m_cell->dereference() ;
+    
+    this->m_cell = data.m_cell ;
+    return *this ;
+  }
+  
+  template<typename Type>
+  Data<Type>& Data<Type>::operator=( Data<Type>&& data )
+  {
+    if( this != &data )
+    {
+      if( this->m_cell ) this->m_cell->dereference() ;
+      
+      this->m_cell = data.m_cell ;
+      data.m_cell  = nullptr     ;
+    }
+    
+    return *this ;
+  }
+
+  template<typename Type>
+  Handle<Type> Data<Type>::handle() const
+  {
+    return this->m_cell && this->m_cell->owner() == &Slab<Type>::global ? Handle<Type>( this->m_cell ) : Handle<Type>() ;
+  }
+
+  template<typename Type>
+  Data<Type>::~Data()
+  {
+    if( this->m_cell ) this->m_cell->dereference() ;
+    this->m_cell = nullptr ;
+  }
+  
+  template<typename Type>
+  unsigned Data<Type>::count() const
+  {
+    return this->m_cell ? this->m_cell->count() : 0 ;
+  }
+
+  template<typename Type>
+  Data<Type>::operator bool() const
+  {
+    return this->m_cell && this->m_cell->object()->initialized() ;
+  }
+  
+  template<typename Type>
+  Type* Data<Type>::access() const
+  {
+    #if MARS_CHECKED_ACCESS
+      if( this->m_cell ) return this->m_cell->object() ;
+      mars::handleError( __FILE__, __LINE__, mars::Error::InvalidAccess ) ;
+      return &mars::dummy<Type>() ;
+    #else
+      MARS_ASSERT( this->m_cell != nullptr ) ;
+      return this->m_cell->object() ;
+    #endif
+  }
+  
+  template<typename Type>
+  Type* Data<Type>::operator->()
+  {
+    return this->access() ;
+  }
+
+  template<typename Type>
+  const Type* Data<Type>::operator->() const
+  {
+    return this->access() ;
+  }
+
+  template<typename Type>
+  Type& Data<Type>::operator*()
+  {
+    return *this->access() ;
+  }
+
+  template<typename Type>
+  const Type& Data<Type>::operator*() const
+  {
+    return *this->access() ;
+  }
+}
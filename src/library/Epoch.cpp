@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Epoch.cpp
+ * Author: agent
+ *
+ * Created on October 16, 2026, 7:00 PM
+ */
+
+#include "Epoch.h"
+
+namespace mars
+{
+  /** The amount of retired pointers that triggers a collection.
+   */
+  static constexpr unsigned COLLECT_THRESHOLD = 64 ;
+
+  /** Value of a record's epoch while its thread is not reading.
+   */
+  static constexpr std::uint64_t IDLE = 0 ;
+
+  /** The epoch pinned by a single thread. On its own cache line so readers never share one.
+   */
+  struct alignas( 64 ) Record
+  {
+    std::atomic<std::uint64_t> epoch = { IDLE }   ; ///< The epoch pinned by the owning thread, or IDLE.
+    std::atomic<bool>          used  = { false }  ; ///< Whether a thread owns this record.
+    Record*                    next  = nullptr    ; ///< The next record. Records are never freed.
+  };
+
+  /** Memory waiting to be freed.
+   */
+  struct Retired
+  {
+    void*          pointer ; ///< The memory to free.
+    Epoch::Deleter deleter ; ///< The function to free the memory with.
+    std::uint64_t  epoch   ; ///< The epoch the memory was retired in.
+  };
+
+  /** Structure containing the global reclamation state.
+   */
+  struct EpochData
+  {
+    std::atomic<std::uint64_t> epoch   = { 1 }       ; ///< The current epoch.
+    std::atomic<Record*>       records = { nullptr } ; ///< Every thread's record.
+    std::vector<Retired>       retired               ; ///< Memory waiting to be freed.
+    std::mutex                 lock                  ; ///< The lock guarding the retired memory.
+
+    /** Deconstructor. Frees every retired memory, as no thread reads anymore.
+     */
+    ~EpochData() ;
+  };
+
+  /** Static function to retrieve the global reclamation state.
+   * @return Reference to the global reclamation state.
+   * @note Function local so readers during static initialization are safe.
+   */
+  static EpochData& epochData()
+  {
+    static EpochData data ;
+    return data ;
+  }
+
+  /** Gives a thread's record back once the thread exits.
+   */
+  struct Release
+  {
+    bool armed = false ; ///< Whether the thread claimed a record.
+
+    /** Deconstructor. Gives the record back for other threads to use.
+     */
+    ~Release() ;
+  };
+
+  /** The calling thread's record. Trivial, so pinning does not go through thread local initialization.
+   */
+  static thread_local Record* local = nullptr ;
+
+  /** The amount of guards alive on the calling thread.
+   */
+  static thread_local unsigned depth = 0 ;
+
+  /** The calling thread's release of its record. Only touched when claiming a record.
+   */
+  static thread_local Release release ;
+
+  EpochData::~EpochData()
+  {
+    for( auto& retired : this->retired ) retired.deleter( retired.pointer ) ;
+  }
+
+  Release::~Release()
+  {
+    if( local ) local->used.store( false, std::memory_order_release ) ;
+    local = nullptr ;
+  }
+
+  /** Static function to retrieve the calling thread's record, claiming a free or new one the first time.
+   * @return The record of the calling thread.
+   */
+  static Record* record()
+  {
+    if( local ) return local ;
+
+    EpochData& data = epochData() ;
+
+    release.armed = true ;
+
+    for( Record* record = data.records.load( std::memory_order_acquire ); record; record = record->next )
+    {
+      bool used = false ;
+
+      if( !record->used.load( std::memory_order_relaxed ) && record->used.compare_exchange_strong( used, true, std::memory_order_acquire ) )
+      {
+        return local = record ;
+      }
+    }
+
+    Record* record = new Record() ;
+
+    record->used.store( true, std::memory_order_relaxed ) ;
+    record->next = data.records.load( std::memory_order_relaxed ) ;
+
+    while( !data.records.compare_exchange_weak( record->next, record, std::memory_order_release, std::memory_order_relaxed ) ) ;
+
+    return local = record ;
+  }
+
+  Epoch::Guard::Guard()
+  {
+    if( depth++ != 0 ) return ;
+
+    // Sequentially consistent, so writers scanning the records after unlinking either see this pin or the reader misses the unlinked memory.
+    record()->epoch.store( epochData().epoch.load( std::memory_order_seq_cst ), std::memory_order_seq_cst ) ;
+  }
+
+  Epoch::Guard::~Guard()
+  {
+    if( --depth != 0 ) return ;
+
+    local->epoch.store( IDLE, std::memory_order_release ) ;
+  }
+
+  void Epoch::retire( void* pointer, Deleter deleter )
+  {
+    EpochData& data = epochData() ;
+    bool       full = false       ;
+
+    {
+      std::lock_guard<std::mutex> lock( data.lock ) ;
+
+      data.retired.push_back( { pointer, deleter, data.epoch.load( std::memory_order_seq_cst ) } ) ;
+      full = data.retired.size() >= COLLECT_THRESHOLD ;
+    }
+
+    if( full ) Epoch::collect() ;
+  }
+
+  void Epoch::collect()
+  {
+    EpochData&           data = epochData() ;
+    std::vector<Retired> freed              ;
+
+    // Readers pinning from here on see a newer epoch than anything retired so far.
+    data.epoch.fetch_add( 1, std::memory_order_seq_cst ) ;
+
+    std::uint64_t oldest = UINT64_MAX ;
+
+    for( Record* record = data.records.load( std::memory_order_acquire ); record; record = record->next )
+    {
+      const std::uint64_t epoch = record->epoch.load( std::memory_order_seq_cst ) ;
+
+      if( epoch != IDLE && epoch < oldest ) oldest = epoch ;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock( data.lock ) ;
+
+      auto kept = data.retired.begin() ;
+
+      for( auto& retired : data.retired )
+      {
+        if( retired.epoch < oldest ) freed.push_back( retired ) ;
+        else                         *kept++ = retired ;
+      }
+
+      data.retired.erase( kept, data.retired.end() ) ;
+    }
+
+    for( auto& retired : freed ) retired.deleter( retired.pointer ) ;
+  }
+
+  unsigned Epoch::pending()
+  {
+    EpochData&                  data = epochData() ;
+    std::lock_guard<std::mutex> lock( data.lock )  ;
+
+    return static_cast<unsigned>( data.retired.size() ) ;
+  }
+}
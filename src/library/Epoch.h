@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Epoch.h
+ * Author: agent
+ *
+ * Created on October 16, 2026, 7:00 PM
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace mars
+{
+  /** Epoch based reclamation of memory read by lock-free readers.
+   * Readers pin the current epoch for as long as they read shared memory. Writers unlink memory first, then retire it.
+   * Retired memory is only freed once every reader that could have seen it unpinned.
+   * Pinning only writes to the calling thread's own record, so readers never contend with each other.
+   */
+  class Epoch
+  {
+    public:
+
+      /** Function type used to free retired memory.
+       */
+      using Deleter = void (*)( void* pointer ) ;
+
+      /** Object pinning the epoch for the calling thread while it is alive. Guards may nest.
+       */
+      class Guard
+      {
+        public:
+
+          /** Constructor. Pins the epoch for the calling thread.
+           */
+          Guard() ;
+
+          /** Deconstructor. Unpins the epoch for the calling thread, unless an outer guard still pins it.
+           */
+          ~Guard() ;
+
+          /** Copying is disallowed.
+           */
+          Guard( const Guard& guard ) = delete ;
+
+          /** Copying is disallowed.
+           */
+          Guard& operator=( const Guard& guard ) = delete ;
+      };
+
+      /** Static method to hand memory over to be freed once no reader can see it anymore.
+       * @note The memory must already be unreachable for readers that pin the epoch from now on.
+       * @param pointer The memory to free.
+       * @param deleter The function to free the memory with.
+       */
+      static void retire( void* pointer, Deleter deleter ) ;
+
+      /** Static method to free every retired memory that no reader can see anymore.
+       * @note Called automatically every so often by retire.
+       */
+      static void collect() ;
+
+      /** Static method to retrieve the amount of retired memory not yet freed.
+       * @return The amount of retired pointers waiting to be freed.
+       */
+      static unsigned pending() ;
+  };
+}
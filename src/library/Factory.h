@@ -26,134 +26,361 @@
 
 /** Shouldn't have to worry about ABI because this is header only... I think.
  */
-#include <stack>
-#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <mutex>
+#include <utility>
+#include <initializer_list>
+#include <vector>
+#include "FreeList.h"
+#include "Slab.h"
+#include "Handle.h"
+#include "Data.h"
+#include "Pool.h"
+#include "Policy.h"
+#include "Parallel.h"
+#include "Stats.h"
 #include "Mars.h"
 
 namespace mars
 {
-  /** Forward declare for factory friendship.
-   */
-  template<typename Type>
-  class Factory ;
-  
-  /** Forward declare for manager friendship.
-   */
-  template<typename Key, typename Type>
-  class Manager ;
-  
-  /** Wrapper object for a object retrieved from the factory.
-   * @note This is used over just a shared pointer in case more library meta-data is needed.
+  /** Static template object for cacheing objects in RAM.
+   * Adds per-thread caches on top of a default, process-wide Pool of the type. Use a Pool directly for objects that should be freed together, e.g. with a level.
+   * @tparam Type The type of factory to access.
    */
   template<typename Type>
-  class Data
+  class Factory
   {
     public:
       
-      /** The amount of references of this data.
-       * @return The amount of references for this data.
+      /** Static method for retrieving an object from the factory.
+       * @param params The parameters to use for initializing the retrieved object. Forwarded as-is, so temporaries are moved into initialize.
+       * @return A Wrapped up reference to the created object.
+       * @note Thread safe & lock-free. Objects come from the calling thread's cache, which is refilled from the shared depot a magazine at a time.
        */
-      unsigned count() const ;
-
-      /** Conversion operator to boolean to check for validation.
-       * @return True if this object holds a valid reference. ( initialized & not de-referenced. )
+      template<typename ... Parameters>
+      static Data<Type> create( Parameters&&... params ) ;
+      
+      /** Static method for destroying/reusing an object from the factory.
+       * @param data The data reference to put back into the factory.
+       * @note Thread safe & lock-free. Objects go to the calling thread's cache, which spills into the shared depot a magazine at a time.
+       *       With the policy's deferred_reset, the object is only queued, and is reset & pooled by the next reclaim().
+       *       Forwards an InvalidAccess library error & leaves the data alone if it is empty, or belongs to an instanced pool.
        */
-      operator bool() const ;
+      static void destroy( Data<Type>& data ) ;
       
-      /** Arrow overload to access underlying reference functions.
-       * @return Pointer to this object's underlying reference.
-       * @note Forwards a Mars library error on invalid access.
+      /** Static method for retrieving an object from the factory as a lightweight handle.
+       * @param params The parameters to use for initializing the retrieved object. Forwarded as-is, so temporaries are moved into initialize.
+       * @return A handle to the created object. The object stays alive until it is destroyed through the factory.
        */
-      Type* operator->() ;
+      template<typename ... Parameters>
+      static Handle<Type> createHandle( Parameters&&... params ) ;
       
-      /** Arrow overload to access underlying reference functions.
-       * @return Const Pointer to this object's underlying reference.
-       * @note Forwards a Mars library error on invalid access.
+      /** Static method for destroying/reusing an object referenced by a handle.
+       * @note Every handle to the object is invalidated. Does nothing if the handle is already invalid.
+       *       Only for objects retrieved with createHandle. Objects retrieved with create are owned by their Data, and must be destroyed through it.
+       * @param handle The handle of the object to put back into the factory.
        */
-      const Type* operator->() const ;
+      static void destroy( Handle<Type> handle ) ;
       
-      /** Star overload to access a reference to this object's underlying data.
-       * @return Reference to this object's underlying data.
-       * @note Forwards a Mars library error on invalid access.
+      /** Static method for retrieving many objects from the factory at once.
+       * @note Objects are moved out of the depot a magazine at a time. Batches of at least the policy's parallel_batch are initialized across threads.
+       * @param count The amount of objects to retrieve.
+       * @param params The parameters to use for initializing every retrieved object. Passed by reference to every initialize call.
+       * @return The wrapped up references to the created objects.
        */
-      Type& operator*() ;
+      template<typename ... Parameters>
+      static std::vector<Data<Type>> createBatch( unsigned count, const Parameters&... params ) ;
       
-      /** Star overload to access a const reference to this object's underlying data.
-       * @return Const reference to this object's underlying data.
-       * @note Forwards a Mars library error on invalid access.
+      /** Static method for destroying/reusing many objects at once.
+       * @note Objects are moved into the depot a magazine at a time. Batches of at least the policy's parallel_batch are reset across threads.
+       *       Empty data & data of instanced pools forward an InvalidAccess library error, and are left alone.
+       * @param data Pointer to the data references to put back into the factory.
+       * @param count The amount of data references.
        */
-      const Type& operator*() const ;
+      static void destroyBatch( Data<Type>* data, unsigned count ) ;
+      
+      /** Static method for destroying/reusing many objects at once.
+       * @param data The data references to put back into the factory. Cleared afterwards.
+       */
+      static void destroyBatch( std::vector<Data<Type>>& data ) ;
+      
+      /** Static method to prewarm the factory, e.g. during a loading screen.
+       * @param count The amount of objects the factory should have pooled & ready.
+       */
+      static void reserve( unsigned count ) ;
+      
+      /** Static method to cleanup the factory.
+       * @Note Usage of this should be use sparingly, as it frees allocated data of the factory and returns it to minimum settings.
+       *       Enough objects are kept to reach the highest usage seen since the last cleanup again, but never less than the policy's minimum.
+       *       For example, if you use a LOT of factory objects in a scene, but use next to none in the next scene, the previous cache will exist if cleanup is not called.
+       *       Objects cached by other threads are returned to the depot on that thread's next factory access ( or exit ), and are trimmed by the following cleanup.
+       */
+      static void cleanup() ;
       
-      /** Deconstructor to allow saving off these objects and letting them die. Does not re-add this data back into the factory.
+      /** Static method to reset every object destroyed since the last reclaim, and return them to the pool.
+       * @note Only needed with the policy's deferred_reset. Thread safe, and can run on any thread. Resets run across threads for batches of at least the policy's parallel_batch.
        */
-      ~Data() ;
+      static void reclaim() ;
+      
+      /** Static method to call a function on every live object of the factory, in a linear scan.
+       * @note Only available with the policy's dense. Creating or destroying objects of this type from within the function deadlocks.
+       * @param function The function to call. Called as function( Type& ).
+       */
+      template<typename Function>
+      static void forEach( Function function ) ;
+      
+      /** Static method to call a function on every live object of the factory, split across threads.
+       * @note Only available with the policy's dense. Creating or destroying objects of this type from within the function deadlocks.
+       *       The dense list is split into parts of whole cache lines, at least the policy's parallel_batch ( or 1024 ) objects large.
+       * @param function The function to call. Called as function( Type& ) on different objects concurrently.
+       */
+      template<typename Function>
+      static void parallelForEach( Function function ) ;
+      
+      /** Static method to take a snapshot of this factory's counters.
+       * @note Counters are per-thread or relaxed atomics, so they are cheap enough to leave on. Every used factory can also be enumerated with mars::factoryStats().
+       * @return The current counters of this factory.
+       */
+      static FactoryStats stats() ;
+    private :
 
-    private:
+      /** Alias for the growth & shrink policy of this factory.
+       */
+      using Policy = PoolPolicy<Type> ;
       
-      /** Static dummy object for invalid access returns.
+      /** The amount of objects a magazine can hold.
        */
-      static Type dummy ;
+      static constexpr unsigned MAGAZINE_SIZE = 16 ;
       
-      /** Friend decleration so the factory can access this object.
+      /** Fixed size batch of pooled objects. Threads cache these locally, and exchange them with the depot whole.
        */
-      template<typename Type2>
-      friend class Factory ;
+      struct Magazine
+      {
+        Cell<Type>*           objects[ MAGAZINE_SIZE ] ;
+        unsigned              count = 0 ;
+        std::atomic<unsigned> next      ;
+      };
       
-      template<typename Key, typename Type2>
-      friend class Manager ;
+      /** Counters of a single thread. Only written by their owning thread, so updating them never contends.
+       */
+      struct Counters
+      {
+        std::atomic<std::uint64_t> created   { 0 } ; ///< The amount of objects created.
+        std::atomic<std::uint64_t> destroyed { 0 } ; ///< The amount of objects destroyed.
+        std::atomic<std::uint64_t> misses    { 0 } ; ///< The amount of creates that went to the depot.
+        std::atomic<std::uint64_t> time      { 0 } ; ///< The nanoseconds spent exchanging magazines with the depot.
+      };
       
-      /** Privated constructor so only the factory can create copies of this object.
+      /** Per-thread cache of magazines. Most creates & destroys only ever touch this.
        */
-      Data() ;
+      struct Cache
+      {
+        unsigned loaded   ; ///< The magazine objects are taken from & put into.
+        unsigned previous ; ///< The last loaded magazine, kept to avoid thrashing the depot at magazine boundaries.
+        unsigned epoch    ; ///< The cleanup epoch this cache last synchronized with.
+        Counters counters ; ///< The counters of this cache's thread.
+        Cache*   before   ; ///< The cache registered before this one.
+        Cache*   after    ; ///< The cache registered after this one.
+        
+        /** Default constructor.
+         */
+        Cache() ;
+        
+        /** Deconstructor. Returns this thread's magazines to the depot on thread exit.
+         */
+        ~Cache() ;
+      };
       
-      /** Underlying shared pointer holding this object's data.
+      /** Alias for the end of a free list.
        */
-      std::shared_ptr<Type> m_ptr ;
-  };
-  
-  /** Static template object for cacheing objects in RAM.
-   * @tparam Type The type of factory to access.
-   */
-  template<typename Type>
-  class Factory
-  {
-    public:
+      static constexpr unsigned END = FreeList<Magazine>::END ;
       
-      /** Static method for retrieving an object from the factory.
-       * @param params The parameters to use for initializing the retrieved object.
-       * @return A Wrapped up reference to the created object.
+      /** Helper method to take a cell out of the calling thread's cache.
+       * @return A cell holding a pooled object & one reference.
        */
-      template<typename ... Parameters>
-      static Data<Type> create( Parameters... params ) ;
+      static Cell<Type>* acquire() ;
       
-      /** Static method for destroying/reusing an object from the factory.
-       * @param data The data reference to put back into the factory.
+      /** Helper method to retire a cell's object and put the cell back into the calling thread's cache.
+       * @param cell The cell to put back, along with one of its references.
        */
-      static void destroy( Data<Type>& data ) ;
+      static void recycle( Cell<Type>* cell ) ;
       
-      /** Static method to cleanup the factory.
-       * @Note Usage of this should be use sparingly, as it frees all allocated data of the factory and returns it to minimum settings.
-       *       For example, if you use a LOT of factory objects in a scene, but use next to none in the next scene, the previous cache will exist if cleanup is not called.
+      /** Helper method to retrieve the calling thread's cache, synchronized with the last cleanup.
+       * @return Reference to the calling thread's cache.
        */
-      static void cleanup() ;
-    private :
-
-      /** The base, minimum size of the underlying stack.
+      static Cache& local() ;
+      
+      /** Helper method to return all of a cache's magazines to the depot.
+       * @param cache The cache to flush.
+       */
+      static void flush( Cache& cache ) ;
+      
+      /** Helper method to place a magazine into the depot.
+       * @param index The index of the magazine to place.
+       */
+      static void deposit( unsigned index ) ;
+      
+      /** Helper method to retrieve an empty magazine.
+       * @return The index of an empty magazine.
+       */
+      static unsigned empty() ;
+      
+      /** Helper method to retrieve a magazine with objects in it. Refills from the slab if the depot is empty.
+       * @return The index of a magazine holding at least one object.
+       */
+      static unsigned stock() ;
+      
+      /** Helper method to allocate new objects, growing the size of each following refill.
+       * @return The index of a magazine holding some of the new objects. The rest are placed into the depot.
+       */
+      static unsigned refill() ;
+      
+      /** Helper method to fill a magazine with newly allocated objects.
+       * @param index The index of the magazine to fill.
+       * @param count The most objects to allocate.
+       * @return The amount of objects allocated.
+       */
+      static unsigned fill( unsigned index, unsigned count ) ;
+      
+      /** Helper method to update the high water mark of objects out of the depot.
+       */
+      static void mark() ;
+      
+      /** Dense list of every live object, for factories whose policy asks for one.
+       */
+      struct Live
+      {
+        std::vector<Cell<Type>*> cells ; ///< Every live object, packed.
+        std::mutex               lock  ; ///< Lock for the list. Only taken by types with the policy's dense.
+      };
+      
+      /** Helper method to retrieve the dense list of live objects.
+       * @return Reference to the dense list of live objects.
+       */
+      static Live& live() ;
+      
+      /** Helper method to add an object to the dense list of live objects. Does nothing unless the policy asks for a dense list.
+       * @param cell The cell of the object to add. The list takes a reference to it.
        */
-      static constexpr unsigned MIN_SIZE = 10 ;
+      static void track( Cell<Type>* cell ) ;
       
-      /** Alias for a stack.
+      /** Helper method to add many objects to the dense list of live objects at once. Does nothing unless the policy asks for a dense list.
+       * @param data The data of the objects to add. The list takes a reference to each.
+       * @param count The amount of objects.
        */
-      using DataStack  = std::stack<Data<Type>> ;
+      static void track( const Data<Type>* data, unsigned count ) ;
       
-      /** The stack to use for containing the cache.
+      /** Helper method to swap-remove an object from the dense list of live objects. Does nothing unless the policy asks for a dense list.
+       * @param cell The cell of the object to remove. The list's reference to it is dropped.
        */
-      static DataStack  stack ;
+      static void untrack( Cell<Type>* cell ) ;
       
-      /** The mutex to ensure thread safety.
+      /** Helper method to check whether data refers to an object of this factory, rather than being empty or of an instanced pool.
+       * @param data The data to check.
+       * @return Whether or not the data's object lives in the global slab.
        */
-      static std::mutex stack_lock ;
+      static bool owns( const Data<Type>& data ) ;
+      
+      /** Helper method to swap-remove many objects from the dense list of live objects at once. Does nothing unless the policy asks for a dense list.
+       * @param data The data of the objects to remove. The list's reference to each is dropped.
+       * @param count The amount of objects.
+       */
+      static void untrack( const Data<Type>* data, unsigned count ) ;
+      
+      /** Helper method to add an object to the dense list of live objects. The list's lock must be held.
+       * @param live The dense list of live objects.
+       * @param cell The cell of the object to add.
+       */
+      static void insert( Live& live, Cell<Type>* cell ) ;
+      
+      /** Helper method to swap-remove an object from the dense list of live objects. The list's lock must be held.
+       * @param live The dense list of live objects.
+       * @param cell The cell of the object to remove.
+       */
+      static void remove( Live& live, Cell<Type>* cell ) ;
+      
+      /** Helper method to add to a counter owned by the calling thread. A plain load & store, since no other thread writes it.
+       * @param counter The counter to add to.
+       * @param amount The amount to add.
+       */
+      static void count( std::atomic<std::uint64_t>& counter, std::uint64_t amount ) ;
+      
+      /** Helper method to retrieve the current time for measuring depot exchanges.
+       * @return The current time in nanoseconds.
+       */
+      static std::uint64_t now() ;
+      
+      /** Helper method to add this factory to the global registry the first time it is used.
+       */
+      static void enroll() ;
+      
+      /** Keeper of the default pool, putting objects whose last Data was dropped without being destroyed back into the calling thread's cache.
+       */
+      struct Returns : Keeper<Type>
+      {
+        /** Method called once the last Data of an object is dropped without being destroyed.
+         * @param cell The cell of the object, holding one reference.
+         */
+        void keep( Cell<Type>* cell ) override { Factory<Type>::recycle( cell ) ; } ;
+      };
+      
+      /** The keeper of the default pool.
+       */
+      static Returns returns ;
+      
+      /** The default pool this factory caches objects of. Allocates out of the global slab, and keeps track of allocation & refill growth.
+       */
+      static Pool<Type> pool ;
+      
+      /** The reclaim queue of objects destroyed, but not yet reset.
+       */
+      static FreeList<Cell<Type>> pending ;
+      
+      /** The amount of objects reset by reclaim.
+       */
+      static std::atomic<std::uint64_t> reclaimed ;
+      
+      /** The storage of every magazine used by the factory.
+       */
+      static Chunks<Magazine> magazines ;
+      
+      /** The depot of magazines holding pooled objects.
+       */
+      static FreeList<Magazine> stocked ;
+      
+      /** The depot of magazines holding nothing.
+       */
+      static FreeList<Magazine> empties ;
+      
+      /** The amount of objects currently in the depot. Does not include objects cached by threads.
+       */
+      static std::atomic<unsigned> available ;
+      
+      /** The most objects that were out of the depot at once since the last cleanup.
+       */
+      static std::atomic<unsigned> peak ;
+      
+      /** The cleanup epoch. Threads flush their caches to the depot when they see this change.
+       */
+      static std::atomic<unsigned> epoch ;
+      
+      /** The counters of every thread that has exited.
+       */
+      static Counters retired ;
+      
+      /** The list of every live thread's cache, so their counters can be gathered.
+       */
+      static Cache* caches ;
+      
+      /** Lock for the list of caches. Only taken on thread start & exit, and when gathering counters.
+       */
+      static std::mutex caches_lock ;
+      
+      /** The calling thread's cache.
+       */
+      static thread_local Cache cache ;
       
       /** Constructing is disallowed.
        */
@@ -165,118 +392,687 @@ namespace mars
   };
   
   template<typename Type>
-  std::stack<Data<Type>> Factory<Type>::stack ;
+  typename Factory<Type>::Returns Factory<Type>::returns ;
+  
+  template<typename Type>
+  Pool<Type> Factory<Type>::pool( Slab<Type>::global, Factory<Type>::returns ) ;
+  
+  template<typename Type>
+  FreeList<Cell<Type>> Factory<Type>::pending( Slab<Type>::global.storage() ) ;
+  
+  template<typename Type>
+  std::atomic<std::uint64_t> Factory<Type>::reclaimed( 0 ) ;
+  
+  template<typename Type>
+  Chunks<typename Factory<Type>::Magazine> Factory<Type>::magazines ;
+  
+  template<typename Type>
+  FreeList<typename Factory<Type>::Magazine> Factory<Type>::stocked( Factory<Type>::magazines ) ;
+  
+  template<typename Type>
+  FreeList<typename Factory<Type>::Magazine> Factory<Type>::empties( Factory<Type>::magazines ) ;
+  
+  template<typename Type>
+  std::atomic<unsigned> Factory<Type>::available( 0 ) ;
+  
+  template<typename Type>
+  std::atomic<unsigned> Factory<Type>::peak( 0 ) ;
+  
+  template<typename Type>
+  std::atomic<unsigned> Factory<Type>::epoch( 0 ) ;
+  
+  template<typename Type>
+  typename Factory<Type>::Counters Factory<Type>::retired ;
+  
+  template<typename Type>
+  typename Factory<Type>::Cache* Factory<Type>::caches = nullptr ;
+  
+  template<typename Type>
+  std::mutex Factory<Type>::caches_lock ;
+  
+  template<typename Type>
+  thread_local typename Factory<Type>::Cache Factory<Type>::cache ;
+  
+  template<typename Type>
+  Factory<Type>::Cache::Cache()
+  {
+    this->loaded   = END ;
+    this->previous = END ;
+    this->epoch    = Factory<Type>::epoch.load( std::memory_order_relaxed ) ;
+    this->before   = nullptr ;
+    
+    Factory<Type>::enroll() ;
+    
+    std::lock_guard<std::mutex> lock( Factory<Type>::caches_lock ) ;
+    
+    this->after = Factory<Type>::caches ;
+    if( this->after ) this->after->before = this ;
+    Factory<Type>::caches = this ;
+  }
+  
+  template<typename Type>
+  Factory<Type>::Cache::~Cache()
+  {
+    Factory<Type>::flush( *this ) ;
+    
+    std::lock_guard<std::mutex> lock( Factory<Type>::caches_lock ) ;
+    
+    Factory<Type>::retired.created  .fetch_add( this->counters.created  .load( std::memory_order_relaxed ), std::memory_order_relaxed ) ;
+    Factory<Type>::retired.destroyed.fetch_add( this->counters.destroyed.load( std::memory_order_relaxed ), std::memory_order_relaxed ) ;
+    Factory<Type>::retired.misses   .fetch_add( this->counters.misses   .load( std::memory_order_relaxed ), std::memory_order_relaxed ) ;
+    Factory<Type>::retired.time     .fetch_add( this->counters.time     .load( std::memory_order_relaxed ), std::memory_order_relaxed ) ;
+    
+    if( this->before ) this->before->after = this->after  ;
+    else               Factory<Type>::caches = this->after ;
+    if( this->after  ) this->after->before = this->before ;
+  }
+  
+  template<typename Type>
+  void Factory<Type>::count( std::atomic<std::uint64_t>& counter, std::uint64_t amount )
+  {
+    counter.store( counter.load( std::memory_order_relaxed ) + amount, std::memory_order_relaxed ) ;
+  }
+  
+  template<typename Type>
+  std::uint64_t Factory<Type>::now()
+  {
+    return static_cast<std::uint64_t>( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() ) ;
+  }
+  
+  template<typename Type>
+  void Factory<Type>::enroll()
+  {
+    static const bool enrolled = ( mars::registerFactory( &Factory<Type>::stats ), true ) ;
+    
+    static_cast<void>( enrolled ) ;
+  }
+  
+  template<typename Type>
+  typename Factory<Type>::Cache& Factory<Type>::local()
+  {
+    Cache&         cache   = Factory<Type>::cache ;
+    const unsigned current = Factory<Type>::epoch.load( std::memory_order_relaxed ) ;
+    
+    if( cache.epoch != current )
+    {
+      Factory<Type>::flush( cache ) ;
+      cache.epoch = current ;
+    }
+    
+    return cache ;
+  }
+  
+  template<typename Type>
+  void Factory<Type>::flush( Cache& cache )
+  {
+    for( unsigned* index : { &cache.loaded, &cache.previous } )
+    {
+      if( *index != END ) Factory<Type>::deposit( *index ) ;
+      *index = END ;
+    }
+  }
+  
+  template<typename Type>
+  void Factory<Type>::deposit( unsigned index )
+  {
+    Magazine& magazine = Factory<Type>::magazines[ index ] ;
+    
+    while( magazine.count != 0 && static_cast<std::uint64_t>( Factory<Type>::available.load( std::memory_order_relaxed ) ) + magazine.count > Policy::maximum )
+    {
+      Factory<Type>::pool.free( magazine.objects[ --magazine.count ] ) ;
+    }
+    
+    if( magazine.count != 0 )
+    {
+      Factory<Type>::available.fetch_add( magazine.count, std::memory_order_relaxed ) ;
+      Factory<Type>::stocked.push( index ) ;
+    }
+    else
+    {
+      Factory<Type>::empties.push( index ) ;
+    }
+  }
+  
+  template<typename Type>
+  unsigned Factory<Type>::empty()
+  {
+    const unsigned index = Factory<Type>::empties.pop() ;
+    
+    return index != END ? index : Factory<Type>::magazines.allocate() ;
+  }
+  
+  template<typename Type>
+  unsigned Factory<Type>::stock()
+  {
+    const unsigned index = Factory<Type>::stocked.pop() ;
+    
+    if( index == END ) return Factory<Type>::refill() ;
+    
+    Factory<Type>::available.fetch_sub( Factory<Type>::magazines[ index ].count, std::memory_order_relaxed ) ;
+    Factory<Type>::mark() ;
+    
+    return index ;
+  }
+  
+  template<typename Type>
+  unsigned Factory<Type>::refill()
+  {
+    unsigned       amount = Factory<Type>::pool.grow() ;
+    const unsigned index  = Factory<Type>::empty()     ;
+    
+    amount -= Factory<Type>::fill( index, amount ) ;
+    
+    while( amount != 0 )
+    {
+      const unsigned extra = Factory<Type>::empty() ;
+      
+      amount -= Factory<Type>::fill( extra, amount ) ;
+      Factory<Type>::deposit( extra ) ;
+    }
+    
+    Factory<Type>::mark() ;
+    return index ;
+  }
   
   template<typename Type>
-  std::mutex Factory<Type>::stack_lock ;
+  unsigned Factory<Type>::fill( unsigned index, unsigned count )
+  {
+    Magazine&      magazine = Factory<Type>::magazines[ index ] ;
+    const unsigned start    = magazine.count ;
+    
+    while( magazine.count < Factory<Type>::MAGAZINE_SIZE && magazine.count - start < count )
+    {
+      magazine.objects[ magazine.count++ ] = Factory<Type>::pool.allocate() ;
+    }
+    
+    return magazine.count - start ;
+  }
   
   template<typename Type>
-  Type Data<Type>::dummy ;
+  void Factory<Type>::mark()
+  {
+    const unsigned outstanding = Factory<Type>::pool.allocated.load( std::memory_order_relaxed ) - Factory<Type>::available.load( std::memory_order_relaxed ) ;
+    unsigned       current     = Factory<Type>::peak.load( std::memory_order_relaxed ) ;
+    
+    while( outstanding > current && !Factory<Type>::peak.compare_exchange_weak( current, outstanding, std::memory_order_relaxed ) ) {}
+  }
 
   template<typename Type>
-  template<typename ... Parameters>
-  Data<Type> Factory<Type>::create( Parameters... params )
+  Cell<Type>* Factory<Type>::acquire()
   {
-    Data<Type> data ;
+    Cache& cache = Factory<Type>::local() ;
+    
+    Factory<Type>::count( cache.counters.created, 1 ) ;
     
-    if( Factory<Type>::stack.empty() )
+    if( cache.loaded == END || Factory<Type>::magazines[ cache.loaded ].count == 0 )
     {
-      for( unsigned index = 0; index < Factory<Type>::MIN_SIZE; index++ )
+      if( cache.previous != END && Factory<Type>::magazines[ cache.previous ].count != 0 )
       {
-        data = Data<Type>() ;
-        data.m_ptr = std::make_shared<Type>() ;
-        Factory<Type>::stack.push( data ) ;
+        std::swap( cache.loaded, cache.previous ) ;
+      }
+      else
+      {
+        const std::uint64_t start   = Factory<Type>::now()   ;
+        const unsigned      stocked = Factory<Type>::stock() ;
+        
+        if( cache.previous != END ) Factory<Type>::empties.push( cache.previous ) ;
+        cache.previous = cache.loaded ;
+        cache.loaded   = stocked      ;
+        
+        Factory<Type>::count( cache.counters.misses, 1 ) ;
+        Factory<Type>::count( cache.counters.time, Factory<Type>::now() - start ) ;
+      }
+    }
+    
+    Magazine& magazine = Factory<Type>::magazines[ cache.loaded ] ;
+    return magazine.objects[ --magazine.count ] ;
+  }
+  
+  template<typename Type>
+  void Factory<Type>::recycle( Cell<Type>* cell )
+  {
+    Cache& cache = Factory<Type>::local() ;
+    
+    Factory<Type>::count( cache.counters.destroyed, 1 ) ;
+    
+    if( Policy::deferred_reset )
+    {
+      cell->retire() ;
+      Factory<Type>::pending.push( cell->index() ) ;
+      return ;
+    }
+    
+    cell->object()->reset() ;
+    cell->retire() ;
+    
+    if( cache.loaded == END || Factory<Type>::magazines[ cache.loaded ].count == Factory<Type>::MAGAZINE_SIZE )
+    {
+      if( cache.previous != END && Factory<Type>::magazines[ cache.previous ].count != Factory<Type>::MAGAZINE_SIZE )
+      {
+        std::swap( cache.loaded, cache.previous ) ;
+      }
+      else
+      {
+        const std::uint64_t start = Factory<Type>::now() ;
+        
+        if( cache.previous != END ) Factory<Type>::deposit( cache.previous ) ;
+        cache.previous = cache.loaded ;
+        cache.loaded   = Factory<Type>::empty() ;
+        
+        Factory<Type>::count( cache.counters.time, Factory<Type>::now() - start ) ;
       }
     }
     
-    Factory<Type>::stack_lock.lock() ;
+    Magazine& magazine = Factory<Type>::magazines[ cache.loaded ] ;
+    magazine.objects[ magazine.count++ ] = cell ;
+  }
+
+  template<typename Type>
+  template<typename ... Parameters>
+  Data<Type> Factory<Type>::create( Parameters&&... params )
+  {
+    Data<Type> data ;
     
-    data = Factory<Type>::stack.top() ;
-    Factory<Type>::stack.pop() ;
+    data.m_cell = Factory<Type>::acquire() ;
     
-    Factory<Type>::stack_lock.unlock() ;
+    data->initialize( std::forward<Parameters>( params )... ) ;
+    Factory<Type>::track( data.m_cell ) ;
     
-    data->initialize( params... ) ;
     return data ;
   }
   
   template<typename Type>
   void Factory<Type>::destroy( mars::Data<Type>& data )
   {
-    data->reset() ;
+    // Objects of instanced pools live in the pool's own chunks, so must never end up in the factory's magazines.
+    if( !Factory<Type>::owns( data ) ) 
+    {
+      mars::handleError( __FILE__, __LINE__, mars::Error::InvalidAccess ) ;
+      return ;
+    }
     
-    Factory<Type>::stack_lock.lock() ;
-    Factory<Type>::stack.push( data ) ;
-    Factory<Type>::stack_lock.unlock() ;
+    Factory<Type>::untrack( data.m_cell ) ;
+    Factory<Type>::recycle( data.m_cell ) ;
+    data.m_cell = nullptr ;
+  }
+  
+  template<typename Type>
+  template<typename ... Parameters>
+  Handle<Type> Factory<Type>::createHandle( Parameters&&... params )
+  {
+    Cell<Type>* cell = Factory<Type>::acquire() ;
+    
+    cell->object()->initialize( std::forward<Parameters>( params )... ) ;
+    Factory<Type>::track( cell ) ;
     
-    data.m_ptr = nullptr ;
+    return Handle<Type>( cell ) ;
   }
   
   template<typename Type>
-  void Factory<Type>::cleanup()
+  void Factory<Type>::destroy( Handle<Type> handle )
   {
-    Factory<Type>::stack_lock.lock() ;
-    while( Factory<Type>::stack.size() > Factory<Type>::MIN_SIZE )
+    Cell<Type>* cell = handle.cell() ;
+    
+    if( cell )
     {
-      Factory::stack.pop() ; // Shared pointer should deallocate upon reference loss.
+      Factory<Type>::untrack( cell ) ;
+      Factory<Type>::recycle( cell ) ;
     }
-    Factory<Type>::stack_lock.unlock() ;
   }
-
+  
   template<typename Type>
-  Data<Type>::Data()
+  template<typename ... Parameters>
+  std::vector<Data<Type>> Factory<Type>::createBatch( unsigned count, const Parameters&... params )
   {
-    this->m_ptr = nullptr ;
+    std::vector<Data<Type>> batch ;
+    Cache&                  cache = Factory<Type>::local() ;
+    const std::uint64_t     start = Factory<Type>::now()   ;
+    
+    batch.reserve( count ) ;
+    
+    while( batch.size() < count )
+    {
+      unsigned index = Factory<Type>::stocked.pop() ;
+      
+      if( index != END )
+      {
+        Factory<Type>::available.fetch_sub( Factory<Type>::magazines[ index ].count, std::memory_order_relaxed ) ;
+      }
+      else
+      {
+        index = Factory<Type>::empty() ;
+        Factory<Type>::fill( index, count - static_cast<unsigned>( batch.size() ) ) ;
+      }
+      
+      Magazine& magazine = Factory<Type>::magazines[ index ] ;
+      
+      while( magazine.count != 0 && batch.size() < count )
+      {
+        Data<Type> data ;
+        
+        data.m_cell = magazine.objects[ --magazine.count ] ;
+        batch.push_back( std::move( data ) ) ;
+      }
+      
+      Factory<Type>::deposit( index ) ;
+    }
+    
+    Factory<Type>::mark() ;
+    
+    // Batches bypass the thread's cache, so every object of one counts as a miss.
+    Factory<Type>::count( cache.counters.created, count ) ;
+    Factory<Type>::count( cache.counters.misses , count ) ;
+    Factory<Type>::count( cache.counters.time   , Factory<Type>::now() - start ) ;
+    
+    auto initialize = [ &batch, &params... ]( unsigned begin, unsigned end )
+    {
+      for( unsigned index = begin; index < end; index++ ) batch[ index ]->initialize( params... ) ;
+    };
+    
+    if( Policy::parallel_batch != 0 && count >= Policy::parallel_batch ) mars::parallelFor( count, Policy::parallel_batch, initialize ) ;
+    else                                                                 initialize( 0, count ) ;
+    
+    Factory<Type>::track( batch.data(), count ) ;
+    
+    return batch ;
   }
-
+  
   template<typename Type>
-  Data<Type>::~Data()
+  void Factory<Type>::destroyBatch( Data<Type>* data, unsigned count )
   {
-    this->m_ptr = nullptr ;
+    if( Policy::deferred_reset )
+    {
+      for( unsigned position = 0; position < count; position++ ) Factory<Type>::destroy( data[ position ] ) ;
+      return ;
+    }
+    
+    Factory<Type>::untrack( data, count ) ;
+    
+    auto reset = [ data ]( unsigned begin, unsigned end )
+    {
+      for( unsigned index = begin; index < end; index++ )
+      {
+        if( Factory<Type>::owns( data[ index ] ) ) data[ index ]->reset() ;
+      }
+    };
+    
+    if( Policy::parallel_batch != 0 && count >= Policy::parallel_batch ) mars::parallelFor( count, Policy::parallel_batch, reset ) ;
+    else                                                                 reset( 0, count ) ;
+    
+    Cache&              cache     = Factory<Type>::local() ;
+    const std::uint64_t start     = Factory<Type>::now()   ;
+    unsigned            destroyed = 0                      ;
+    unsigned            index     = Factory<Type>::empty() ;
+    
+    for( unsigned position = 0; position < count; position++ )
+    {
+      Cell<Type>* cell = data[ position ].m_cell ;
+      
+      if( !Factory<Type>::owns( data[ position ] ) )
+      {
+        mars::handleError( __FILE__, __LINE__, mars::Error::InvalidAccess ) ;
+        continue ;
+      }
+      
+      if( Factory<Type>::magazines[ index ].count == Factory<Type>::MAGAZINE_SIZE )
+      {
+        Factory<Type>::deposit( index ) ;
+        index = Factory<Type>::empty() ;
+      }
+      
+      Magazine& magazine = Factory<Type>::magazines[ index ] ;
+      
+      cell->retire() ;
+      magazine.objects[ magazine.count++ ] = cell ;
+      data[ position ].m_cell = nullptr ;
+      destroyed++ ;
+    }
+    
+    Factory<Type>::deposit( index ) ;
+    
+    Factory<Type>::count( cache.counters.destroyed, destroyed ) ;
+    Factory<Type>::count( cache.counters.time, Factory<Type>::now() - start ) ;
   }
   
   template<typename Type>
-  unsigned Data<Type>::count() const
+  void Factory<Type>::destroyBatch( std::vector<Data<Type>>& data )
   {
-    return this->m_ptr.use_count() ;
+    Factory<Type>::destroyBatch( data.data(), static_cast<unsigned>( data.size() ) ) ;
+    data.clear() ;
   }
-
+  
   template<typename Type>
-  Data<Type>::operator bool() const
+  void Factory<Type>::reserve( unsigned count )
   {
-    return this->m_ptr && this->m_ptr->initialized() ;
+    while( Factory<Type>::available.load( std::memory_order_relaxed ) < count )
+    {
+      const unsigned index = Factory<Type>::empty() ;
+      
+      Factory<Type>::fill( index, count - Factory<Type>::available.load( std::memory_order_relaxed ) ) ;
+      Factory<Type>::deposit( index ) ;
+    }
   }
   
   template<typename Type>
-  Type* Data<Type>::operator->()
+  void Factory<Type>::reclaim()
   {
-    if( this->m_ptr ) return this->m_ptr.get() ;
-    mars::handleError( __FILE__, __LINE__, mars::Error::InvalidAccess ) ;
-    return &Data<Type>::dummy ;
+    std::vector<Cell<Type>*> cells ;
+    
+    for( unsigned index = Factory<Type>::pending.detach(); index != END; index = Factory<Type>::pending.follow( index ) )
+    {
+      cells.push_back( &Slab<Type>::global.storage()[ index ] ) ;
+    }
+    
+    if( cells.empty() ) return ;
+    
+    const unsigned count = static_cast<unsigned>( cells.size() ) ;
+    
+    auto reset = [ &cells ]( unsigned begin, unsigned end )
+    {
+      for( unsigned index = begin; index < end; index++ ) cells[ index ]->object()->reset() ;
+    };
+    
+    if( Policy::parallel_batch != 0 && count >= Policy::parallel_batch ) mars::parallelFor( count, Policy::parallel_batch, reset ) ;
+    else                                                                 reset( 0, count ) ;
+    
+    unsigned index = Factory<Type>::empty() ;
+    
+    for( Cell<Type>* cell : cells )
+    {
+      if( Factory<Type>::magazines[ index ].count == Factory<Type>::MAGAZINE_SIZE )
+      {
+        Factory<Type>::deposit( index ) ;
+        index = Factory<Type>::empty() ;
+      }
+      
+      Magazine& magazine = Factory<Type>::magazines[ index ] ;
+      magazine.objects[ magazine.count++ ] = cell ;
+    }
+    
+    Factory<Type>::deposit( index ) ;
+    Factory<Type>::reclaimed.fetch_add( count, std::memory_order_relaxed ) ;
   }
-
+  
   template<typename Type>
-  const Type* Data<Type>::operator->() const
+  template<typename Function>
+  void Factory<Type>::forEach( Function function )
   {
-    if( this->m_ptr ) return this->m_ptr.get() ;
-    mars::handleError( __FILE__, __LINE__, mars::Error::InvalidAccess ) ;
-    return &Data<Type>::dummy ;
+    static_assert( Policy::dense, "forEach needs a dense list of live objects. Enable it with the type's PoolPolicy." ) ;
+    
+    Live&                       live = Factory<Type>::live() ;
+    std::lock_guard<std::mutex> lock( live.lock )            ;
+    
+    for( Cell<Type>* cell : live.cells ) function( *cell->object() ) ;
   }
-
+  
   template<typename Type>
-  Type& Data<Type>::operator*()
+  template<typename Function>
+  void Factory<Type>::parallelForEach( Function function )
   {
-    if( this->m_ptr ) return *this->m_ptr ;
-    mars::handleError( __FILE__, __LINE__, mars::Error::InvalidAccess ) ;
-    return Data<Type>::dummy ;
+    static_assert( Policy::dense, "parallelForEach needs a dense list of live objects. Enable it with the type's PoolPolicy." ) ;
+    
+    // Parts are whole cache lines of the dense list, so threads never share one.
+    constexpr unsigned LINE    = 64 / sizeof( Cell<Type>* ) ;
+    constexpr unsigned MINIMUM = Policy::parallel_batch != 0 ? Policy::parallel_batch : 1024 ;
+    constexpr unsigned GRAIN   = ( MINIMUM + LINE - 1 ) / LINE * LINE ;
+    
+    Live&                       live  = Factory<Type>::live() ;
+    std::lock_guard<std::mutex> lock( live.lock )             ;
+    Cell<Type>* const*          cells = live.cells.data()     ;
+    
+    mars::parallelFor( static_cast<unsigned>( live.cells.size() ), GRAIN, [ cells, &function ]( unsigned begin, unsigned end )
+    {
+      for( unsigned index = begin; index < end; index++ ) function( *cells[ index ]->object() ) ;
+    } ) ;
   }
-
+  
+  template<typename Type>
+  typename Factory<Type>::Live& Factory<Type>::live()
+  {
+    static Live live ;
+    return live ;
+  }
+  
+  template<typename Type>
+  void Factory<Type>::track( Cell<Type>* cell )
+  {
+    if( !Policy::dense ) return ;
+    
+    Live&                       live = Factory<Type>::live() ;
+    std::lock_guard<std::mutex> lock( live.lock )            ;
+    
+    Factory<Type>::insert( live, cell ) ;
+  }
+  
+  template<typename Type>
+  void Factory<Type>::track( const Data<Type>* data, unsigned count )
+  {
+    if( !Policy::dense ) return ;
+    
+    Live&                       live = Factory<Type>::live() ;
+    std::lock_guard<std::mutex> lock( live.lock )            ;
+    
+    live.cells.reserve( live.cells.size() + count ) ;
+    for( unsigned index = 0; index < count; index++ ) if( data[ index ].m_cell ) Factory<Type>::insert( live, data[ index ].m_cell ) ;
+  }
+  
+  template<typename Type>
+  void Factory<Type>::untrack( Cell<Type>* cell )
+  {
+    if( !Policy::dense ) return ;
+    
+    Live&                       live = Factory<Type>::live() ;
+    std::lock_guard<std::mutex> lock( live.lock )            ;
+    
+    Factory<Type>::remove( live, cell ) ;
+  }
+  
+  template<typename Type>
+  void Factory<Type>::untrack( const Data<Type>* data, unsigned count )
+  {
+    if( !Policy::dense ) return ;
+    
+    Live&                       live = Factory<Type>::live() ;
+    std::lock_guard<std::mutex> lock( live.lock )            ;
+    
+    for( unsigned index = 0; index < count; index++ ) if( Factory<Type>::owns( data[ index ] ) ) Factory<Type>::remove( live, data[ index ].m_cell ) ;
+  }
+  
+  template<typename Type>
+  bool Factory<Type>::owns( const Data<Type>& data )
+  {
+    return data.m_cell && data.m_cell->owner() == &Slab<Type>::global ;
+  }
+  
+  template<typename Type>
+  void Factory<Type>::insert( Live& live, Cell<Type>* cell )
+  {
+    cell->reference() ;
+    cell->place( static_cast<unsigned>( live.cells.size() ) ) ;
+    live.cells.push_back( cell ) ;
+  }
+  
+  template<typename Type>
+  void Factory<Type>::remove( Live& live, Cell<Type>* cell )
+  {
+    Cell<Type>* last = live.cells.back() ;
+    
+    live.cells[ cell->slot() ] = last ;
+    last->place( cell->slot() ) ;
+    live.cells.pop_back() ;
+    
+    // The caller still holds a reference, so this never frees the object.
+    cell->dereference() ;
+  }
+  
+  template<typename Type>
+  void Factory<Type>::cleanup()
+  {
+    Factory<Type>::reclaim() ;
+    
+    // Bumping the epoch makes every thread return its magazines to the depot on its next access, so idle caches get trimmed by the following cleanup.
+    Factory<Type>::epoch.fetch_add( 1, std::memory_order_relaxed ) ;
+    Factory<Type>::local() ;
+    
+    const unsigned outstanding = Factory<Type>::pool.allocated.load( std::memory_order_relaxed ) - Factory<Type>::available.load( std::memory_order_relaxed ) ;
+    const unsigned high        = Factory<Type>::peak.exchange( outstanding, std::memory_order_relaxed ) ;
+    const unsigned wanted      = high > outstanding ? high - outstanding : 0 ;
+    const unsigned keep        = wanted > Policy::minimum ? wanted : Policy::minimum ;
+    
+    while( Factory<Type>::available.load( std::memory_order_relaxed ) > keep )
+    {
+      const unsigned index = Factory<Type>::stocked.pop() ;
+      if( index == END ) break ;
+      
+      Magazine& magazine = Factory<Type>::magazines[ index ] ;
+      Factory<Type>::available.fetch_sub( magazine.count, std::memory_order_relaxed ) ;
+      
+      while( magazine.count != 0 && Factory<Type>::available.load( std::memory_order_relaxed ) + magazine.count > keep )
+      {
+        Factory<Type>::pool.free( magazine.objects[ --magazine.count ] ) ;
+      }
+      
+      Factory<Type>::deposit( index ) ;
+    }
+    
+    // The default pool keeps no objects of its own, so this only restarts its refill growth.
+    Factory<Type>::pool.cleanup() ;
+  }
+  
   template<typename Type>
-  const Type& Data<Type>::operator*() const
+  FactoryStats Factory<Type>::stats()
   {
+    FactoryStats stats ;
+    
+    stats.name = mars::typeName<Type>() ;
+    
+    // Read before the destroys, so that the snapshot never has more reclaimed objects than destroyed ones.
+    const std::uint64_t reclaimed = Factory<Type>::reclaimed.load( std::memory_order_relaxed ) ;
+    
+    auto gather = [ &stats ]( const Counters& counters )
+    {
+      // Misses are read before creates, so that a thread's misses never exceed its creates in the snapshot.
+      stats.misses     += counters.misses   .load( std::memory_order_relaxed ) ;
+      stats.created    += counters.created  .load( std::memory_order_relaxed ) ;
+      stats.destroyed  += counters.destroyed.load( std::memory_order_relaxed ) ;
+      stats.depot_time += counters.time     .load( std::memory_order_relaxed ) ;
+    };
+    
+    {
+      std::lock_guard<std::mutex> lock( Factory<Type>::caches_lock ) ;
+      
+      gather( Factory<Type>::retired ) ;
+      for( const Cache* cache = Factory<Type>::caches; cache != nullptr; cache = cache->after ) gather( cache->counters ) ;
+    }
+    
+    stats.hits      = stats.created > stats.misses    ? stats.created - stats.misses    : 0 ;
+    stats.refills   = Factory<Type>::pool.refills  .load( std::memory_order_relaxed ) ;
+    stats.allocated = Factory<Type>::pool.allocated.load( std::memory_order_relaxed ) ;
+    stats.peak      = Factory<Type>::peak     .load( std::memory_order_relaxed ) ;
+    stats.live      = static_cast<unsigned>( stats.created > stats.destroyed ? stats.created - stats.destroyed : 0 ) ;
+    stats.pending   = static_cast<unsigned>( Policy::deferred_reset && stats.destroyed > reclaimed ? stats.destroyed - reclaimed : 0 ) ;
+    stats.pooled    = stats.allocated > stats.live + stats.pending ? stats.allocated - stats.live - stats.pending : 0 ;
     
-    if( this->m_ptr ) return *this->m_ptr ;
-    mars::handleError( __FILE__, __LINE__, mars::Error::InvalidAccess ) ;
-    return Data<Type>::dummy ;
+    return stats ;
   }
 }
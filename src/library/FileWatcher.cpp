@@ -0,0 +1,229 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   FileWatcher.cpp
+ * Author: agent
+ *
+ * Created on October 16, 2026, 7:40 PM
+ */
+
+#include "FileWatcher.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <system_error>
+
+#if defined( __linux__ )
+  #include <poll.h>
+  #include <sys/inotify.h>
+  #include <unistd.h>
+  #define MARS_INOTIFY 1
+#else
+  #define MARS_INOTIFY 0
+#endif
+
+/** The amount of milliseconds between polls of the watcher shared by the library, if it has to poll.
+ */
+#ifndef MARS_FILE_WATCH_INTERVAL
+  #define MARS_FILE_WATCH_INTERVAL 250
+#endif
+
+namespace mars
+{
+  FileWatcher::FileWatcher( unsigned interval, bool polling ) : interval( interval != 0 ? interval : 1 )
+  {
+    #if MARS_INOTIFY
+      if( !polling ) this->notify = inotify_init1( IN_NONBLOCK | IN_CLOEXEC ) ;
+    #else
+      ( void )polling ;
+    #endif
+
+    this->worker = std::thread( &FileWatcher::work, this ) ;
+  }
+
+  FileWatcher::~FileWatcher()
+  {
+    {
+      std::lock_guard<std::mutex> lock( this->lock ) ;
+      this->running = false ;
+    }
+
+    this->wake.notify_all() ;
+    this->worker.join() ;
+
+    #if MARS_INOTIFY
+      if( this->notify != -1 ) ::close( this->notify ) ;
+    #endif
+  }
+
+  FileWatcher& FileWatcher::global()
+  {
+    static FileWatcher watcher( MARS_FILE_WATCH_INTERVAL ) ;
+
+    return watcher ;
+  }
+
+  unsigned FileWatcher::watch( const std::string& path, Callback callback, void* data )
+  {
+    const std::filesystem::path file( path ) ;
+    Watched                     watched      ;
+
+    watched.path      = path                     ;
+    watched.name      = file.filename().string() ;
+    watched.directory = -1                       ;
+    watched.time      = 0                        ;
+    watched.size      = 0                        ;
+    watched.callback  = callback                 ;
+    watched.data      = data                     ;
+
+    FileWatcher::record( watched ) ;
+
+    std::lock_guard<std::mutex> lock( this->lock ) ;
+
+    #if MARS_INOTIFY
+      // Directories are watched instead of files, as editors often save by replacing the file. Files whose directory can't be watched are polled.
+      if( this->notify != -1 )
+      {
+        const std::string directory = file.has_parent_path() ? file.parent_path().string() : std::string( "." ) ;
+
+        watched.directory = inotify_add_watch( this->notify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO ) ;
+      }
+    #endif
+
+    watched.id = ++this->ids ;
+    this->files.push_back( watched ) ;
+
+    return watched.id ;
+  }
+
+  void FileWatcher::unwatch( unsigned id )
+  {
+    std::lock_guard<std::mutex> lock( this->lock ) ;
+
+    auto watched = std::find_if( this->files.begin(), this->files.end(), [ id ]( const Watched& file ) { return file.id == id ; } ) ;
+
+    if( watched == this->files.end() ) return ;
+
+    #if MARS_INOTIFY
+      // Every file of a directory shares its watch, so it is only removed along with the directory's last file.
+      const int  directory = watched->directory ;
+      const auto users     = std::count_if( this->files.begin(), this->files.end(), [ directory ]( const Watched& file ) { return file.directory == directory ; } ) ;
+
+      if( directory != -1 && users == 1 ) inotify_rm_watch( this->notify, directory ) ;
+    #endif
+
+    this->files.erase( watched ) ;
+  }
+
+  bool FileWatcher::polling() const
+  {
+    return this->notify == -1 ;
+  }
+
+  void FileWatcher::work()
+  {
+    std::unique_lock<std::mutex> lock( this->lock ) ;
+
+    while( this->running )
+    {
+      #if MARS_INOTIFY
+        if( this->notify != -1 )
+        {
+          pollfd descriptor = { this->notify, POLLIN, 0 } ;
+
+          // Waits unlocked, so watching & unwatching never wait on a quiet directory.
+          lock.unlock() ;
+          const bool ready = ::poll( &descriptor, 1, static_cast<int>( this->interval ) ) > 0 ;
+          lock.lock() ;
+
+          if( ready ) this->notified() ;
+
+          this->poll() ;
+          continue ;
+        }
+      #endif
+
+      this->wake.wait_for( lock, std::chrono::milliseconds( this->interval ), [ this ] { return !this->running ; } ) ;
+
+      if( this->running ) this->poll() ;
+    }
+  }
+
+  void FileWatcher::notified()
+  {
+    #if MARS_INOTIFY
+      alignas( inotify_event ) char buffer[ 4096 ] ;
+      std::vector<unsigned>         changed        ;
+
+      for( ssize_t length = ::read( this->notify, buffer, sizeof( buffer ) ); length > 0; length = ::read( this->notify, buffer, sizeof( buffer ) ) )
+      {
+        for( ssize_t offset = 0; offset < length; )
+        {
+          const inotify_event* event = reinterpret_cast<const inotify_event*>( buffer + offset ) ;
+
+          offset += static_cast<ssize_t>( sizeof( inotify_event ) + event->len ) ;
+
+          if( event->len == 0 ) continue ;
+
+          for( const Watched& watched : this->files )
+          {
+            if( watched.directory == event->wd && watched.name == event->name && std::find( changed.begin(), changed.end(), watched.id ) == changed.end() ) changed.push_back( watched.id ) ;
+          }
+        }
+      }
+
+      // Saving often takes several events, so every file is called back once per batch of them.
+      for( const Watched& watched : this->files )
+      {
+        if( std::find( changed.begin(), changed.end(), watched.id ) != changed.end() ) watched.callback( watched.data ) ;
+      }
+    #endif
+  }
+
+  void FileWatcher::poll()
+  {
+    for( Watched& watched : this->files )
+    {
+      if( watched.directory == -1 && FileWatcher::record( watched ) ) watched.callback( watched.data ) ;
+    }
+  }
+
+  bool FileWatcher::record( Watched& watched )
+  {
+    std::error_code error ;
+
+    const auto     time  = std::filesystem::last_write_time( watched.path, error ) ;
+    std::int64_t   stamp = error ? 0 : static_cast<std::int64_t>( time.time_since_epoch().count() ) ;
+    std::uintmax_t size  = error ? 0 : std::filesystem::file_size( watched.path, error ) ;
+
+    // Missing files count as empty, so their creation is a change too.
+    if( error )
+    {
+      stamp = 0 ;
+      size  = 0 ;
+    }
+
+    // Sizes are compared too, as modification times can be too coarse to tell quick successive writes apart.
+    const bool changed = stamp != watched.time || size != watched.size ;
+
+    watched.time = stamp ;
+    watched.size = size  ;
+
+    return changed ;
+  }
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   FileWatcher.h
+ * Author: agent
+ *
+ * Created on October 16, 2026, 7:40 PM
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mars
+{
+  /** Object watching files for changes on a thread of its own, e.g. to reload assets while they are edited.
+   * Uses inotify where available, watching the directory of every file so that editors replacing files on save are noticed too.
+   * Otherwise, or when asked to, polls the modification time & size of every file once an interval.
+   */
+  class FileWatcher
+  {
+    public:
+
+      /** Function type called when a watched file changes.
+       */
+      using Callback = void (*)( void* data ) ;
+
+      /** Constructor. Starts the watching thread.
+       * @param interval The amount of milliseconds between polls, and the longest the watcher takes to stop.
+       * @param polling Whether to poll even where inotify is available.
+       */
+      explicit FileWatcher( unsigned interval, bool polling = false ) ;
+
+      /** Deconstructor. Stops & joins the watching thread.
+       */
+      ~FileWatcher() ;
+
+      /** Copying is disallowed.
+       */
+      FileWatcher( const FileWatcher& watcher ) = delete ;
+
+      /** Copying is disallowed.
+       */
+      FileWatcher& operator=( const FileWatcher& watcher ) = delete ;
+
+      /** Static method to retrieve the watcher shared by the library, polling every MARS_FILE_WATCH_INTERVAL milliseconds if it has to.
+       * @return Reference to the shared watcher.
+       */
+      static FileWatcher& global() ;
+
+      /** Method to call a function whenever a file changes. The file does not need to exist yet.
+       * @note The callback runs on the watching thread with the watched files locked, so it must hand work off quickly, and must not watch or unwatch.
+       * @param path The path of the file to watch.
+       * @param callback The function to call when the file changes.
+       * @param data The data to call the function with.
+       * @return The identifier of the watch, to unwatch it with.
+       */
+      unsigned watch( const std::string& path, Callback callback, void* data ) ;
+
+      /** Method to stop watching a file. The callback is not running, and never runs again, once this returns.
+       * @param id The identifier of the watch.
+       */
+      void unwatch( unsigned id ) ;
+
+      /** Method to check whether this watcher polls.
+       * @return Whether or not this watcher polls the watched files, instead of being notified of changes.
+       */
+      bool polling() const ;
+
+    private:
+
+      /** A watched file.
+       */
+      struct Watched
+      {
+        unsigned       id        ; ///< The identifier of the watch.
+        std::string    path      ; ///< The path of the file.
+        std::string    name      ; ///< The name of the file within its directory.
+        int            directory ; ///< The inotify watch of the file's directory. -1 when polling.
+        std::int64_t   time      ; ///< The modification time last seen, when polling.
+        std::uintmax_t size      ; ///< The size last seen, when polling.
+        Callback       callback  ; ///< The function to call when the file changes.
+        void*          data      ; ///< The data to call the function with.
+      };
+
+      /** Helper method run by the watching thread.
+       */
+      void work() ;
+
+      /** Helper method to read pending inotify events, and call back every file they changed once.
+       */
+      void notified() ;
+
+      /** Helper method to check every watched file for changes, calling back the ones that changed. The watched files must be locked.
+       */
+      void poll() ;
+
+      /** Helper method to record the modification time & size of a file, to tell later changes apart.
+       * @param watched The file to record.
+       * @return Whether or not the file changed since it was last recorded.
+       */
+      static bool record( Watched& watched ) ;
+
+      /** The watched files.
+       */
+      std::vector<Watched> files ;
+
+      /** The amount of watches made so far, to identify them by.
+       */
+      unsigned ids = 0 ;
+
+      /** The amount of milliseconds between polls.
+       */
+      unsigned interval ;
+
+      /** The inotify instance. -1 when polling.
+       */
+      int notify = -1 ;
+
+      /** Whether or not the watching thread keeps running.
+       */
+      bool running = true ;
+
+      /** The lock guarding the watched files.
+       */
+      std::mutex lock ;
+
+      /** The condition the watching thread sleeps on between polls.
+       */
+      std::condition_variable wake ;
+
+      /** The watching thread.
+       */
+      std::thread worker ;
+  };
+}
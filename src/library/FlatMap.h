@@ -0,0 +1,711 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   FlatMap.h
+ * Author: agent
+ *
+ * Created on October 16, 2026, 7:04 PM
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <utility>
+#include "Mars.h"
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+  #include <emmintrin.h>
+  #define MARS_GROUP_SSE2 1
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+  #include <arm_neon.h>
+  #define MARS_GROUP_NEON 1
+#endif
+
+#if defined( _MSC_VER )
+  #include <intrin.h>
+#endif
+
+namespace mars
+{
+  /** Static function to mix the bits of a hash, so that both its low & high bits are usable. Standard hashes of integers are often the identity.
+   * @param hash The hash to mix.
+   * @return The mixed hash.
+   */
+  inline std::uint64_t mixHash( std::uint64_t hash )
+  {
+    hash ^= hash >> 33 ;
+    hash *= 0xFF51AFD7ED558CCDull ;
+    hash ^= hash >> 33 ;
+    hash *= 0xC4CEB9FE1A85EC53ull ;
+    hash ^= hash >> 33 ;
+
+    return hash ;
+  }
+
+  /** Static function to hint the processor to start loading memory that is read soon, e.g. the group of the next key of a batched lookup.
+   * @param address The memory read soon. Never faults, even if invalid.
+   */
+  inline void prefetch( const void* address )
+  {
+    #if defined( __GNUC__ ) || defined( __clang__ )
+      __builtin_prefetch( address ) ;
+    #elif defined( _MSC_VER ) && defined( MARS_GROUP_SSE2 )
+      _mm_prefetch( static_cast<const char*>( address ), _MM_HINT_T0 ) ;
+    #else
+      ( void )address ;
+    #endif
+  }
+
+  /** A group of control bytes of a flat table, probed all at once with SSE2 or NEON where available.
+   * Every slot of a table has a control byte: EMPTY, DELETED, or the low 7 bits of its key's hash when full.
+   */
+  class Group
+  {
+    public:
+
+      /** The amount of control bytes in a group.
+       */
+      static constexpr unsigned SIZE = 16 ;
+
+      /** Control byte of a slot that never held an entry. Ends probe sequences.
+       */
+      static constexpr std::uint8_t EMPTY = 0x80 ;
+
+      /** Control byte of a slot whose entry was erased. Probe sequences continue past it.
+       */
+      static constexpr std::uint8_t DELETED = 0xFE ;
+
+      /** Bit mask of slots of a group. Each slot takes STRIDE bits.
+       */
+      using Mask = std::uint64_t ;
+
+      /** Constructor. Loads a group of control bytes.
+       * @param control The first control byte of the group. Must be SIZE bytes.
+       */
+      explicit Group( const std::uint8_t* control ) ;
+
+      /** Constructor. Loads a group of control bytes that other threads may be writing to.
+       * @param control The first control byte of the group. Must be SIZE bytes.
+       */
+      explicit Group( const std::atomic<std::uint8_t>* control ) ;
+
+      /** Method to find the slots of this group whose control byte matches a hash.
+       * @param tag The low 7 bits of the hash to match.
+       * @return The mask of matching slots.
+       */
+      Mask match( std::uint8_t tag ) const ;
+
+      /** Method to find the empty slots of this group.
+       * @return The mask of empty slots.
+       */
+      Mask empty() const ;
+
+      /** Method to find the slots of this group that are empty or deleted.
+       * @return The mask of free slots.
+       */
+      Mask free() const ;
+
+      /** Static method to retrieve the lowest slot of a mask.
+       * @param mask A non-zero mask.
+       * @return The index of the lowest slot in the mask.
+       */
+      static unsigned lowest( Mask mask ) ;
+
+      /** Static method to remove the lowest slot from a mask.
+       * @param mask A non-zero mask.
+       * @return The mask without its lowest slot.
+       */
+      static Mask next( Mask mask ) ;
+
+    private:
+
+      #if defined( MARS_GROUP_SSE2 )
+        /** The amount of mask bits per slot.
+         */
+        static constexpr unsigned STRIDE = 1 ;
+
+        /** The control bytes of this group.
+         */
+        __m128i control ;
+      #elif defined( MARS_GROUP_NEON )
+        static constexpr unsigned STRIDE = 4 ;
+        uint8x16_t control ;
+      #else
+        static constexpr unsigned STRIDE = 1 ;
+        std::uint8_t control[ SIZE ] ;
+      #endif
+  };
+
+  /** Single threaded hash map storing its entries inline, in one flat, open addressed table.
+   * Slots are probed a group at a time by comparing their control bytes in parallel, so most lookups touch a single cache line of control bytes and one entry.
+   * @note Inserting & erasing invalidates iterators & pointers to entries.
+   * @tparam Key The type of key.
+   * @tparam Value The type of value.
+   * @tparam Hash The hash function of keys.
+   */
+  template<typename Key, typename Value, typename Hash = std::hash<Key>>
+  class FlatMap
+  {
+    public:
+
+      /** A key-value pair of the map, named like std::pair.
+       */
+      struct Entry
+      {
+        Key   first  ; ///< The key.
+        Value second ; ///< The value.
+      };
+
+      /** Iterator over the entries of a map, in no particular order.
+       */
+      class Iterator
+      {
+        public:
+
+          /** Constructor.
+           * @param map The map iterated.
+           * @param index The slot to start at. Moved forward to the first full slot.
+           */
+          Iterator( const FlatMap* map, unsigned index ) ;
+
+          /** Arrow overload to access the current entry.
+           * @return Pointer to the current entry.
+           */
+          Entry* operator->() const ;
+
+          /** Star overload to access the current entry.
+           * @return Reference to the current entry.
+           */
+          Entry& operator*() const ;
+
+          /** Method to move to the next entry.
+           * @return Reference to this iterator.
+           */
+          Iterator& operator++() ;
+
+          /** Equality operator.
+           * @param iterator The iterator to compare against.
+           * @return Whether both iterators are at the same slot.
+           */
+          bool operator==( const Iterator& iterator ) const ;
+
+          /** Inequality operator.
+           * @param iterator The iterator to compare against.
+           * @return Whether the iterators are at different slots.
+           */
+          bool operator!=( const Iterator& iterator ) const ;
+
+        private:
+
+          /** Friend declaration so the map can erase through iterators.
+           */
+          friend class FlatMap ;
+
+          /** Helper method to move forward to the next full slot, if the current one is not.
+           */
+          void skip() ;
+
+          /** The map iterated.
+           */
+          const FlatMap* map ;
+
+          /** The slot of the current entry.
+           */
+          unsigned index ;
+      };
+
+      /** Default constructor. Constant, as an empty map allocates nothing.
+       */
+      constexpr FlatMap() : control( nullptr ), entries( nullptr ), capacity( 0 ), count( 0 ), used( 0 ) {} ;
+
+      /** Deconstructor. Destroys every entry.
+       */
+      ~FlatMap() ;
+
+      /** Copying is disallowed.
+       */
+      FlatMap( const FlatMap& map ) = delete ;
+
+      /** Copying is disallowed.
+       */
+      FlatMap& operator=( const FlatMap& map ) = delete ;
+
+      /** Method to look up a key.
+       * @param key The key to look up.
+       * @return An iterator to the key's entry if found. end() otherwise.
+       */
+      Iterator find( const Key& key ) const ;
+
+      /** Method to retrieve the value of a key, inserting a default constructed one if missing.
+       * @param key The key to look up.
+       * @return Reference to the key's value.
+       */
+      Value& operator[]( const Key& key ) ;
+
+      /** Method to insert a key, unless it is already in this map.
+       * @param key The key to insert.
+       * @param value The value to insert with the key.
+       * @return An iterator to the key's entry, and whether it was inserted.
+       */
+      std::pair<Iterator, bool> insert( const Key& key, Value value ) ;
+
+      /** Method to erase the entry of an iterator.
+       * @param iterator An iterator to a valid entry.
+       * @return An iterator to the next entry.
+       */
+      Iterator erase( Iterator iterator ) ;
+
+      /** Method to erase a key.
+       * @param key The key to erase.
+       * @return Whether or not the key was erased.
+       */
+      bool erase( const Key& key ) ;
+
+      /** Method to erase every entry.
+       */
+      void clear() ;
+
+      /** Method to make room for an amount of entries without growing.
+       * @param count The amount of entries.
+       */
+      void reserve( unsigned count ) ;
+
+      /** Method to retrieve the amount of entries in this map.
+       * @return The amount of entries.
+       */
+      unsigned size() const ;
+
+      /** Method to check whether this map is empty.
+       * @return Whether or not this map has no entries.
+       */
+      bool empty() const ;
+
+      /** Method to retrieve an iterator to the first entry.
+       * @return An iterator to the first entry.
+       */
+      Iterator begin() const ;
+
+      /** Method to retrieve the iterator past the last entry.
+       * @return The end iterator.
+       */
+      Iterator end() const ;
+
+    private:
+
+      /** Helper method to find the slot of a key.
+       * @param key The key to find.
+       * @param hash The mixed hash of the key.
+       * @return The slot of the key. capacity if missing.
+       */
+      unsigned locate( const Key& key, std::uint64_t hash ) const ;
+
+      /** Helper method to find the first free slot of a hash's probe sequence.
+       * @param hash The mixed hash of a key.
+       * @return The first free slot.
+       */
+      unsigned vacancy( std::uint64_t hash ) const ;
+
+      /** Helper method to reallocate the table, dropping every deleted slot.
+       * @param capacity The new amount of slots. A multiple of the group size & a power of two.
+       */
+      void rehash( unsigned capacity ) ;
+
+      /** The control byte of every slot.
+       */
+      std::uint8_t* control ;
+
+      /** The storage of every slot.
+       */
+      Entry* entries ;
+
+      /** The amount of slots.
+       */
+      unsigned capacity ;
+
+      /** The amount of entries.
+       */
+      unsigned count ;
+
+      /** The amount of slots that are full or deleted.
+       */
+      unsigned used ;
+  };
+
+  #if defined( MARS_GROUP_SSE2 )
+    inline Group::Group( const std::uint8_t* control )
+    {
+      this->control = _mm_loadu_si128( reinterpret_cast<const __m128i*>( control ) ) ;
+    }
+
+    inline Group::Mask Group::match( std::uint8_t tag ) const
+    {
+      return static_cast<Mask>( _mm_movemask_epi8( _mm_cmpeq_epi8( this->control, _mm_set1_epi8( static_cast<char>( tag ) ) ) ) ) ;
+    }
+
+    inline Group::Mask Group::empty() const
+    {
+      return this->match( EMPTY ) ;
+    }
+
+    inline Group::Mask Group::free() const
+    {
+      // Only EMPTY & DELETED have their high bit set.
+      return static_cast<Mask>( _mm_movemask_epi8( this->control ) ) ;
+    }
+  #elif defined( MARS_GROUP_NEON )
+    inline Group::Group( const std::uint8_t* control )
+    {
+      this->control = vld1q_u8( control ) ;
+    }
+
+    /** Helper function to pack a NEON comparison into a mask of 4 bits per slot.
+     * @param compare The result of a comparison, 0xFF for every matching slot.
+     * @return The mask of matching slots.
+     */
+    inline Group::Mask packNeon( uint8x16_t compare )
+    {
+      return vget_lane_u64( vreinterpret_u64_u8( vshrn_n_u16( vreinterpretq_u16_u8( compare ), 4 ) ), 0 ) ;
+    }
+
+    inline Group::Mask Group::match( std::uint8_t tag ) const
+    {
+      return packNeon( vceqq_u8( this->control, vdupq_n_u8( tag ) ) ) ;
+    }
+
+    inline Group::Mask Group::empty() const
+    {
+      return this->match( EMPTY ) ;
+    }
+
+    inline Group::Mask Group::free() const
+    {
+      return packNeon( vcltq_s8( vreinterpretq_s8_u8( this->control ), vdupq_n_s8( 0 ) ) ) ;
+    }
+  #else
+    inline Group::Group( const std::uint8_t* control )
+    {
+      std::memcpy( this->control, control, SIZE ) ;
+    }
+
+    inline Group::Mask Group::match( std::uint8_t tag ) const
+    {
+      Mask mask = 0 ;
+
+      for( unsigned index = 0; index < SIZE; index++ ) if( this->control[ index ] == tag ) mask |= Mask( 1 ) << index ;
+
+      return mask ;
+    }
+
+    inline Group::Mask Group::empty() const
+    {
+      return this->match( EMPTY ) ;
+    }
+
+    inline Group::Mask Group::free() const
+    {
+      Mask mask = 0 ;
+
+      for( unsigned index = 0; index < SIZE; index++ ) if( this->control[ index ] & 0x80 ) mask |= Mask( 1 ) << index ;
+
+      return mask ;
+    }
+  #endif
+
+  inline Group::Group( const std::atomic<std::uint8_t>* control )
+  {
+    #if defined( MARS_THREAD_SANITIZER )
+      // Thread sanitizer does not understand vector loads of atomics, so the bytes are loaded one by one.
+      std::uint8_t bytes[ SIZE ] ;
+
+      for( unsigned index = 0; index < SIZE; index++ ) bytes[ index ] = control[ index ].load( std::memory_order_acquire ) ;
+
+      *this = Group( bytes ) ;
+    #else
+      // Control bytes are written one at a time with release stores, so a vector load sees each byte either before or after its write.
+      static_assert( sizeof( std::atomic<std::uint8_t> ) == 1, "Control bytes must be single bytes." ) ;
+
+      *this = Group( reinterpret_cast<const std::uint8_t*>( control ) ) ;
+      std::atomic_thread_fence( std::memory_order_acquire ) ;
+    #endif
+  }
+
+  inline unsigned Group::lowest( Mask mask )
+  {
+    #if defined( _MSC_VER )
+      unsigned long index ;
+      _BitScanForward64( &index, mask ) ;
+      return static_cast<unsigned>( index ) / STRIDE ;
+    #else
+      return static_cast<unsigned>( __builtin_ctzll( mask ) ) / STRIDE ;
+    #endif
+  }
+
+  inline Group::Mask Group::next( Mask mask )
+  {
+    return STRIDE == 1 ? mask & ( mask - 1 ) : mask & ~( Mask( ( 1u << STRIDE ) - 1 ) << ( Group::lowest( mask ) * STRIDE ) ) ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  FlatMap<Key, Value, Hash>::Iterator::Iterator( const FlatMap* map, unsigned index )
+  {
+    this->map   = map   ;
+    this->index = index ;
+    this->skip() ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  typename FlatMap<Key, Value, Hash>::Entry* FlatMap<Key, Value, Hash>::Iterator::operator->() const
+  {
+    return &this->map->entries[ this->index ] ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  typename FlatMap<Key, Value, Hash>::Entry& FlatMap<Key, Value, Hash>::Iterator::operator*() const
+  {
+    return this->map->entries[ this->index ] ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  typename FlatMap<Key, Value, Hash>::Iterator& FlatMap<Key, Value, Hash>::Iterator::operator++()
+  {
+    this->index++ ;
+    this->skip() ;
+
+    return *this ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  bool FlatMap<Key, Value, Hash>::Iterator::operator==( const Iterator& iterator ) const
+  {
+    return this->index == iterator.index ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  bool FlatMap<Key, Value, Hash>::Iterator::operator!=( const Iterator& iterator ) const
+  {
+    return this->index != iterator.index ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  void FlatMap<Key, Value, Hash>::Iterator::skip()
+  {
+    while( this->index < this->map->capacity && ( this->map->control[ this->index ] & 0x80 ) ) this->index++ ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  FlatMap<Key, Value, Hash>::~FlatMap()
+  {
+    this->clear() ;
+
+    std::allocator<Entry>().deallocate( this->entries, this->capacity ) ;
+    delete[] this->control ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  typename FlatMap<Key, Value, Hash>::Iterator FlatMap<Key, Value, Hash>::find( const Key& key ) const
+  {
+    return Iterator( this, this->locate( key, mixHash( Hash()( key ) ) ) ) ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  Value& FlatMap<Key, Value, Hash>::operator[]( const Key& key )
+  {
+    return this->insert( key, Value() ).first->second ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  std::pair<typename FlatMap<Key, Value, Hash>::Iterator, bool> FlatMap<Key, Value, Hash>::insert( const Key& key, Value value )
+  {
+    const std::uint64_t hash  = mixHash( Hash()( key ) ) ;
+    const unsigned      found = this->locate( key, hash ) ;
+
+    if( found != this->capacity ) return { Iterator( this, found ), false } ;
+
+    // Grows at 7/8 full, counting deleted slots, which rehashing drops.
+    if( ( this->used + 1 ) * 8 > this->capacity * 7 )
+    {
+      unsigned capacity = this->capacity != 0 ? this->capacity : Group::SIZE ;
+
+      while( ( this->count + 1 ) * 2 > capacity ) capacity *= 2 ;
+
+      this->rehash( capacity ) ;
+    }
+
+    const unsigned index = this->vacancy( hash ) ;
+
+    if( this->control[ index ] == Group::EMPTY ) this->used++ ;
+
+    new ( &this->entries[ index ] ) Entry{ key, std::move( value ) } ;
+    this->control[ index ] = static_cast<std::uint8_t>( hash & 0x7F ) ;
+    this->count++ ;
+
+    return { Iterator( this, index ), true } ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  typename FlatMap<Key, Value, Hash>::Iterator FlatMap<Key, Value, Hash>::erase( Iterator iterator )
+  {
+    this->entries[ iterator.index ].~Entry() ;
+    this->control[ iterator.index ] = Group::DELETED ;
+    this->count-- ;
+
+    return ++iterator ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  bool FlatMap<Key, Value, Hash>::erase( const Key& key )
+  {
+    const Iterator iterator = this->find( key ) ;
+
+    if( iterator == this->end() ) return false ;
+
+    this->erase( iterator ) ;
+    return true ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  void FlatMap<Key, Value, Hash>::clear()
+  {
+    for( unsigned index = 0; index < this->capacity; index++ )
+    {
+      if( !( this->control[ index ] & 0x80 ) ) this->entries[ index ].~Entry() ;
+
+      this->control[ index ] = Group::EMPTY ;
+    }
+
+    this->count = 0 ;
+    this->used  = 0 ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  void FlatMap<Key, Value, Hash>::reserve( unsigned count )
+  {
+    unsigned capacity = this->capacity != 0 ? this->capacity : Group::SIZE ;
+
+    while( count * 8 > capacity * 7 ) capacity *= 2 ;
+
+    if( capacity != this->capacity ) this->rehash( capacity ) ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  unsigned FlatMap<Key, Value, Hash>::size() const
+  {
+    return this->count ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  bool FlatMap<Key, Value, Hash>::empty() const
+  {
+    return this->count == 0 ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  typename FlatMap<Key, Value, Hash>::Iterator FlatMap<Key, Value, Hash>::begin() const
+  {
+    return Iterator( this, 0 ) ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  typename FlatMap<Key, Value, Hash>::Iterator FlatMap<Key, Value, Hash>::end() const
+  {
+    return Iterator( this, this->capacity ) ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  unsigned FlatMap<Key, Value, Hash>::locate( const Key& key, std::uint64_t hash ) const
+  {
+    if( this->capacity == 0 ) return this->capacity ;
+
+    const unsigned     groups = this->capacity / Group::SIZE                  ;
+    const std::uint8_t tag    = static_cast<std::uint8_t>( hash & 0x7F )      ;
+    unsigned           group  = static_cast<unsigned>( hash >> 7 ) & ( groups - 1 ) ;
+
+    // Triangular probing over whole groups visits every group once.
+    for( unsigned probe = 1; probe <= groups; probe++ )
+    {
+      const unsigned base = group * Group::SIZE             ;
+      const Group    bytes( this->control + base )          ;
+
+      for( Group::Mask mask = bytes.match( tag ); mask; mask = Group::next( mask ) )
+      {
+        const unsigned index = base + Group::lowest( mask ) ;
+
+        if( this->entries[ index ].first == key ) return index ;
+      }
+
+      if( bytes.empty() ) return this->capacity ;
+
+      group = ( group + probe ) & ( groups - 1 ) ;
+    }
+
+    return this->capacity ;
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  unsigned FlatMap<Key, Value, Hash>::vacancy( std::uint64_t hash ) const
+  {
+    const unsigned groups = this->capacity / Group::SIZE                       ;
+    unsigned       group  = static_cast<unsigned>( hash >> 7 ) & ( groups - 1 ) ;
+
+    for( unsigned probe = 1; ; probe++ )
+    {
+      const unsigned    base = group * Group::SIZE ;
+      const Group::Mask mask = Group( this->control + base ).free() ;
+
+      if( mask ) return base + Group::lowest( mask ) ;
+
+      group = ( group + probe ) & ( groups - 1 ) ;
+    }
+  }
+
+  template<typename Key, typename Value, typename Hash>
+  void FlatMap<Key, Value, Hash>::rehash( unsigned capacity )
+  {
+    std::uint8_t*  control  = this->control  ;
+    Entry*         entries  = this->entries  ;
+    const unsigned previous = this->capacity ;
+
+    this->control  = new std::uint8_t[ capacity ] ;
+    this->entries  = std::allocator<Entry>().allocate( capacity ) ;
+    this->capacity = capacity ;
+    this->used     = this->count ;
+
+    std::memset( this->control, Group::EMPTY, capacity ) ;
+
+    for( unsigned index = 0; index < previous; index++ )
+    {
+      if( control[ index ] & 0x80 ) continue ;
+
+      Entry&              entry = entries[ index ]                ;
+      const std::uint64_t hash  = mixHash( Hash()( entry.first ) ) ;
+      const unsigned      slot  = this->vacancy( hash )          ;
+
+      new ( &this->entries[ slot ] ) Entry{ std::move( entry ) } ;
+      this->control[ slot ] = static_cast<std::uint8_t>( hash & 0x7F ) ;
+      entry.~Entry() ;
+    }
+
+    std::allocator<Entry>().deallocate( entries, previous ) ;
+    delete[] control ;
+  }
+}
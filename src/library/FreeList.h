@@ -0,0 +1,395 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   FreeList.h
+ * Author: agent
+ *
+ * Created on October 16, 2026, 6:25 PM
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include "Mars.h"
+
+namespace mars
+{
+  /** Stable, chunked storage of nodes addressed by a 32-bit index.
+   * Chunks grow geometrically and are never moved or freed while this object is alive, so an index handed out once stays valid.
+   * Chunks are allocated page-aligned straight from the operating system, using huge pages once they are large enough, unless a memory resource is given.
+   * @tparam Node The type of node to store. Must be default constructible.
+   */
+  template<typename Node>
+  class Chunks
+  {
+    public:
+
+      /** Value used to represent an invalid index.
+       */
+      static constexpr unsigned END = 0xFFFFFFFF ;
+
+      /** Default constructor. Constant so that static instances are initialized before any dynamic initialization runs.
+       */
+      constexpr Chunks() : chunks{}, count( 0 ), resource( nullptr ) {} ;
+
+      /** Constructor. Allocates chunks out of a memory resource instead of the operating system.
+       * @param resource The memory resource to allocate chunks from. Must outlive this object.
+       */
+      constexpr explicit Chunks( std::pmr::memory_resource* resource ) : chunks{}, count( 0 ), resource( resource ) {} ;
+
+      /** Deconstructor. Releases all allocated chunks.
+       */
+      ~Chunks() ;
+
+      /** Method to allocate a new node.
+       * @return The index of the newly allocated node.
+       */
+      unsigned allocate() ;
+
+      /** Method to release every chunk at once, invalidating every index handed out.
+       * @note Not thread safe. Nothing may use this object while it is cleared.
+       */
+      void clear() ;
+
+      /** Method to retrieve the amount of nodes allocated.
+       * @return The amount of nodes allocated by this object.
+       */
+      unsigned size() const ;
+
+      /** Method to access a previously allocated node.
+       * @param index The index of the node to access.
+       * @return Reference to the node at the index.
+       */
+      Node& operator[]( unsigned index ) ;
+
+      /** Method to access a previously allocated node.
+       * @param index The index of the node to access.
+       * @return Const reference to the node at the index.
+       */
+      const Node& operator[]( unsigned index ) const ;
+
+    private:
+
+      /** The amount of nodes in the first chunk. At least one page worth. Every following chunk is double the size of the previous.
+       */
+      static constexpr unsigned BASE = 4096 / sizeof( Node ) > 64 ? static_cast<unsigned>( 4096 / sizeof( Node ) ) : 64 ;
+
+      /** The maximum amount of chunks needed to address every 32-bit index.
+       */
+      static constexpr unsigned MAX_CHUNKS = 27 ;
+
+      /** Helper method to retrieve the chunk an index lives in.
+       * @param index The index to locate.
+       * @return The chunk the index lives in.
+       */
+      static unsigned chunk( unsigned index ) ;
+
+      /** Helper method to retrieve the first index of a chunk.
+       * @param chunk The chunk to locate.
+       * @return The first index stored in the chunk.
+       */
+      static unsigned first( unsigned chunk ) ;
+
+      /** Helper method to retrieve the amount of nodes a chunk holds.
+       * @param chunk The chunk to measure.
+       * @return The amount of nodes in the chunk.
+       */
+      static std::size_t capacity( unsigned chunk ) ;
+
+      /** Helper method to retrieve the amount of bytes a chunk takes up.
+       * @param chunk The chunk to measure.
+       * @return The size of the chunk in bytes.
+       */
+      static std::size_t bytes( unsigned chunk ) ;
+
+      /** Helper method to allocate the memory of a chunk.
+       * @param chunk The chunk to allocate.
+       * @return Pointer to the chunk's memory.
+       */
+      Node* acquire( unsigned chunk ) ;
+
+      /** Helper method to release the memory of a chunk.
+       * @param nodes The chunk's memory.
+       * @param chunk The chunk to release.
+       */
+      void release( Node* nodes, unsigned chunk ) ;
+
+      /** The chunks of nodes allocated by this object.
+       */
+      std::atomic<Node*> chunks[ MAX_CHUNKS ] ;
+
+      /** The amount of nodes allocated by this object.
+       */
+      std::atomic<unsigned> count ;
+
+      /** The memory resource chunks are allocated from. nullptr if chunks come from the operating system.
+       */
+      std::pmr::memory_resource* resource ;
+  };
+
+  /** Lock-free LIFO of node indices ( Treiber stack ) living inside of a Chunks object.
+   * The head is tagged with a counter that is bumped on every operation to protect against ABA.
+   * @tparam Node The type of node to link. Must have a 'std::atomic<unsigned> next' member.
+   */
+  template<typename Node>
+  class FreeList
+  {
+    public:
+
+      /** Value used to represent an empty list.
+       */
+      static constexpr unsigned END = Chunks<Node>::END ;
+
+      /** Constructor.
+       * @param nodes The storage of the nodes linked by this list.
+       */
+      constexpr explicit FreeList( Chunks<Node>& nodes ) : head( END ), nodes( &nodes ) {} ;
+
+      /** Method to push a node onto this list.
+       * @param index The index of the node to push.
+       */
+      void push( unsigned index ) ;
+
+      /** Method to pop a node from this list.
+       * @return The index of the popped node. END if this list was empty.
+       */
+      unsigned pop() ;
+
+      /** Method to take every node off of this list at once.
+       * @return The index of the first node taken. The rest are linked through their 'next' members. END if this list was empty.
+       */
+      unsigned detach() ;
+
+      /** Method to walk a chain of nodes taken with detach.
+       * @param index The index of a detached node.
+       * @return The index of the node linked after it. END at the end of the chain.
+       */
+      unsigned follow( unsigned index ) const ;
+
+      /** Method to check whether this list is empty.
+       * @return Whether or not this list is empty at the time of calling.
+       */
+      bool empty() const ;
+
+      /** Method to forget every node on this list at once.
+       * @note Not thread safe.
+       */
+      void clear() ;
+
+    private:
+
+      /** Helper method to pack an index and tag into a head value.
+       */
+      static std::uint64_t pack( unsigned index, std::uint64_t tag ) ;
+
+      /** The tagged head of this list. The lower 32 bits are the index, the upper 32 bits are the tag.
+       */
+      std::atomic<std::uint64_t> head ;
+
+      /** The storage of the nodes linked by this list.
+       */
+      Chunks<Node>* nodes ;
+  };
+
+  template<typename Node>
+  Chunks<Node>::~Chunks()
+  {
+    this->clear() ;
+  }
+
+  template<typename Node>
+  void Chunks<Node>::clear()
+  {
+    for( unsigned chunk = 0; chunk < Chunks<Node>::MAX_CHUNKS; chunk++ )
+    {
+      Node* nodes = this->chunks[ chunk ].exchange( nullptr, std::memory_order_relaxed ) ;
+      
+      if( nodes != nullptr )
+      {
+        for( std::size_t index = 0; index < Chunks<Node>::capacity( chunk ); index++ ) nodes[ index ].~Node() ;
+        this->release( nodes, chunk ) ;
+      }
+    }
+
+    this->count.store( 0, std::memory_order_relaxed ) ;
+  }
+
+  template<typename Node>
+  Node* Chunks<Node>::acquire( unsigned chunk )
+  {
+    constexpr std::size_t ALIGNMENT = alignof( Node ) > 64 ? alignof( Node ) : 64 ;
+
+    if( this->resource == nullptr ) return static_cast<Node*>( mars::allocatePages( Chunks<Node>::bytes( chunk ) ) ) ;
+    return static_cast<Node*>( this->resource->allocate( Chunks<Node>::bytes( chunk ), ALIGNMENT ) ) ;
+  }
+
+  template<typename Node>
+  void Chunks<Node>::release( Node* nodes, unsigned chunk )
+  {
+    constexpr std::size_t ALIGNMENT = alignof( Node ) > 64 ? alignof( Node ) : 64 ;
+
+    if( this->resource == nullptr ) mars::releasePages( nodes, Chunks<Node>::bytes( chunk ) ) ;
+    else                            this->resource->deallocate( nodes, Chunks<Node>::bytes( chunk ), ALIGNMENT ) ;
+  }
+
+  template<typename Node>
+  unsigned Chunks<Node>::chunk( unsigned index )
+  {
+    const std::uint64_t value = static_cast<std::uint64_t>( index ) / Chunks<Node>::BASE + 1 ;
+    unsigned log = 0 ;
+
+    #if defined( __GNUC__ ) || defined( __clang__ )
+      log = 63u - static_cast<unsigned>( __builtin_clzll( value ) ) ;
+    #else
+      while( ( value >> ( log + 1 ) ) != 0 ) log++ ;
+    #endif
+
+    return log ;
+  }
+
+  template<typename Node>
+  unsigned Chunks<Node>::first( unsigned chunk )
+  {
+    return Chunks<Node>::BASE * ( ( 1u << chunk ) - 1 ) ;
+  }
+
+  template<typename Node>
+  std::size_t Chunks<Node>::capacity( unsigned chunk )
+  {
+    return static_cast<std::size_t>( Chunks<Node>::BASE ) << chunk ;
+  }
+
+  template<typename Node>
+  std::size_t Chunks<Node>::bytes( unsigned chunk )
+  {
+    return sizeof( Node ) * Chunks<Node>::capacity( chunk ) ;
+  }
+
+  template<typename Node>
+  unsigned Chunks<Node>::allocate()
+  {
+    const unsigned index = this->count.fetch_add( 1, std::memory_order_relaxed ) ;
+    const unsigned chunk = Chunks<Node>::chunk( index ) ;
+
+    if( this->chunks[ chunk ].load( std::memory_order_acquire ) == nullptr )
+    {
+      Node* fresh    = this->acquire( chunk ) ;
+      Node* expected = nullptr ;
+      
+      for( std::size_t node = 0; node < Chunks<Node>::capacity( chunk ); node++ ) new ( fresh + node ) Node() ;
+
+      if( !this->chunks[ chunk ].compare_exchange_strong( expected, fresh, std::memory_order_acq_rel ) )
+      {
+        for( std::size_t node = 0; node < Chunks<Node>::capacity( chunk ); node++ ) fresh[ node ].~Node() ;
+        this->release( fresh, chunk ) ;
+      }
+    }
+
+    return index ;
+  }
+
+  template<typename Node>
+  unsigned Chunks<Node>::size() const
+  {
+    return this->count.load( std::memory_order_relaxed ) ;
+  }
+
+  template<typename Node>
+  Node& Chunks<Node>::operator[]( unsigned index )
+  {
+    const unsigned chunk = Chunks<Node>::chunk( index ) ;
+    return this->chunks[ chunk ].load( std::memory_order_acquire )[ index - Chunks<Node>::first( chunk ) ] ;
+  }
+
+  template<typename Node>
+  const Node& Chunks<Node>::operator[]( unsigned index ) const
+  {
+    const unsigned chunk = Chunks<Node>::chunk( index ) ;
+    return this->chunks[ chunk ].load( std::memory_order_acquire )[ index - Chunks<Node>::first( chunk ) ] ;
+  }
+
+  template<typename Node>
+  std::uint64_t FreeList<Node>::pack( unsigned index, std::uint64_t tag )
+  {
+    return ( tag << 32 ) | static_cast<std::uint64_t>( index ) ;
+  }
+
+  template<typename Node>
+  void FreeList<Node>::push( unsigned index )
+  {
+    Node&         node    = ( *this->nodes )[ index ] ;
+    std::uint64_t current = this->head.load( std::memory_order_relaxed ) ;
+    std::uint64_t next    = 0 ;
+
+    do
+    {
+      node.next.store( static_cast<unsigned>( current ), std::memory_order_relaxed ) ;
+      next = FreeList<Node>::pack( index, ( current >> 32 ) + 1 ) ;
+    } while( !this->head.compare_exchange_weak( current, next, std::memory_order_release, std::memory_order_relaxed ) ) ;
+  }
+
+  template<typename Node>
+  unsigned FreeList<Node>::pop()
+  {
+    std::uint64_t current = this->head.load( std::memory_order_acquire ) ;
+    std::uint64_t next    = 0 ;
+    unsigned      index   = END ;
+
+    do
+    {
+      index = static_cast<unsigned>( current ) ;
+      if( index == END ) return END ;
+
+      // The node may be popped and re-pushed by another thread while we read it. Nodes are never freed, and the tag makes the exchange fail in that case.
+      next = FreeList<Node>::pack( ( *this->nodes )[ index ].next.load( std::memory_order_relaxed ), ( current >> 32 ) + 1 ) ;
+    } while( !this->head.compare_exchange_weak( current, next, std::memory_order_acquire, std::memory_order_acquire ) ) ;
+
+    return index ;
+  }
+
+  template<typename Node>
+  unsigned FreeList<Node>::detach()
+  {
+    std::uint64_t current = this->head.load( std::memory_order_acquire ) ;
+
+    while( static_cast<unsigned>( current ) != END && !this->head.compare_exchange_weak( current, FreeList<Node>::pack( END, ( current >> 32 ) + 1 ), std::memory_order_acquire, std::memory_order_acquire ) ) {}
+
+    return static_cast<unsigned>( current ) ;
+  }
+
+  template<typename Node>
+  unsigned FreeList<Node>::follow( unsigned index ) const
+  {
+    return ( *this->nodes )[ index ].next.load( std::memory_order_relaxed ) ;
+  }
+
+  template<typename Node>
+  void FreeList<Node>::clear()
+  {
+    this->head.store( END, std::memory_order_relaxed ) ;
+  }
+
+  template<typename Node>
+  bool FreeList<Node>::empty() const
+  {
+    return static_cast<unsigned>( this->head.load( std::memory_order_relaxed ) ) == END ;
+  }
+}
@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Handle.h
+ * Author: agent
+ *
+ * Created on October 16, 2026, 6:29 PM
+ */
+
+#pragma once
+
+#include "Slab.h"
+#include "Mars.h"
+
+namespace mars
+{
+  /** Forward declare for handle friendship.
+   */
+  template<typename Type>
+  class Factory ;
+
+  /** Forward declare for handle friendship.
+   */
+  template<typename Key, typename Type>
+  class Manager ;
+
+  /** Forward declare for handle friendship.
+   */
+  template<typename Type>
+  class Data ;
+
+  /** Forward declare for handle friendship.
+   */
+  template<typename Type>
+  class WeakReference ;
+
+  /** Lightweight, non-owning handle to an object living in a slab.
+   * A handle is a 32-bit index plus the generation of the object it was made for. It is trivially copyable, and becomes invalid once its object is destroyed.
+   * @note Handles do not keep their object alive. Use Data if shared ownership is needed.
+   *       Handles resolve against the global slab shared by Factory & Manager. Instanced pools hand out Pool::Handle instead, which carries its pool's slab.
+   * @tparam Type The type of object referenced.
+   */
+  template<typename Type>
+  class Handle
+  {
+    public:
+
+      /** Default constructor. Creates an invalid handle.
+       */
+      Handle() = default ;
+
+      /** Method to check whether this handle still refers to the object it was made for.
+       * @return Whether or not this handle is valid.
+       */
+      bool valid() const ;
+
+      /** Conversion operator to boolean to check for validation.
+       * @return Whether or not this handle is valid.
+       */
+      explicit operator bool() const ;
+
+      /** Method to retrieve the object this handle refers to.
+       * @return Pointer to the object if this handle is valid. nullptr otherwise.
+       */
+      Type* get() const ;
+
+      /** Arrow overload to access the referenced object.
+       * @return Pointer to the referenced object. With MARS_CHECKED_ACCESS, a dummy object on invalid access.
+       * @note Forwards a Mars library error on invalid access. Without MARS_CHECKED_ACCESS, the generation is only checked by MARS_ASSERT.
+       */
+      Type* operator->() const ;
+
+      /** Star overload to access the referenced object.
+       * @return Reference to the referenced object.
+       * @note Forwards a Mars library error on invalid access.
+       */
+      Type& operator*() const ;
+
+      /** Method to retrieve the slab index of this handle.
+       * @return The index this handle refers to.
+       */
+      unsigned index() const ;
+
+      /** Method to retrieve the generation of this handle.
+       * @return The generation this handle was made for.
+       */
+      unsigned generation() const ;
+
+      /** Equality operator.
+       * @param handle The handle to compare against.
+       * @return Whether or not both handles refer to the same object.
+       */
+      bool operator==( const Handle<Type>& handle ) const ;
+
+      /** Inequality operator.
+       * @param handle The handle to compare against.
+       * @return Whether or not the handles refer to different objects.
+       */
+      bool operator!=( const Handle<Type>& handle ) const ;
+
+    private:
+
+      /** Friend declarations so the library can create handles.
+       */
+      template<typename Type2>
+      friend class Factory ;
+
+      template<typename Key, typename Type2>
+      friend class Manager ;
+
+      template<typename Type2>
+      friend class Data ;
+
+      template<typename Type2>
+      friend class WeakReference ;
+
+      /** Constructor. Creates a handle to the object currently in a cell.
+       * @param cell The cell to create a handle to.
+       */
+      explicit Handle( const Cell<Type>* cell ) ;
+
+      /** Helper method to retrieve the cell this handle refers to.
+       * @return The cell this handle refers to if valid. nullptr otherwise.
+       */
+      Cell<Type>* cell() const ;
+
+      /** The slab index of the object.
+       */
+      unsigned m_index = Chunks<Cell<Type>>::END ;
+
+      /** The generation of the object.
+       */
+      unsigned m_generation = 0 ;
+  };
+
+  template<typename Type>
+  Handle<Type>::Handle( const Cell<Type>* cell )
+  {
+    this->m_index      = cell->index()      ;
+    this->m_generation = cell->generation() ;
+  }
+
+  template<typename Type>
+  Cell<Type>* Handle<Type>::cell() const
+  {
+    Cell<Type>* cell = Slab<Type>::global.at( this->m_index ) ;
+
+    return cell && cell->generation() == this->m_generation ? cell : nullptr ;
+  }
+
+  template<typename Type>
+  bool Handle<Type>::valid() const
+  {
+    return this->cell() != nullptr ;
+  }
+
+  template<typename Type>
+  Handle<Type>::operator bool() const
+  {
+    return this->valid() ;
+  }
+
+  template<typename Type>
+  Type* Handle<Type>::get() const
+  {
+    Cell<Type>* cell = this->cell() ;
+
+    return cell ? cell->object() : nullptr ;
+  }
+
+  template<typename Type>
+  Type* Handle<Type>::operator->() const
+  {
+    #if MARS_CHECKED_ACCESS
+      Type* object = this->get() ;
+
+      if( object ) return object ;
+      mars::handleError( __FILE__, __LINE__, mars::Error::InvalidAccess ) ;
+      return &mars::dummy<Type>() ;
+    #else
+      MARS_ASSERT( this->valid() ) ;
+      return Slab<Type>::global.storage()[ this->m_index ].object() ;
+    #endif
+  }
+
+  template<typename Type>
+  Type& Handle<Type>::operator*() const
+  {
+    return *this->operator->() ;
+  }
+
+  template<typename Type>
+  unsigned Handle<Type>::index() const
+  {
+    return this->m_index ;
+  }
+
+  template<typename Type>
+  unsigned Handle<Type>::generation() const
+  {
+    return this->m_generation ;
+  }
+
+  template<typename Type>
+  bool Handle<Type>::operator==( const Handle<Type>& handle ) const
+  {
+    return this->m_index == handle.m_index && this->m_generation == handle.m_generation ;
+  }
+
+  template<typename Type>
+  bool Handle<Type>::operator!=( const Handle<Type>& handle ) const
+  {
+    return !( *this == handle ) ;
+  }
+}
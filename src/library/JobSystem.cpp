@@ -0,0 +1,326 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   JobSystem.cpp
+ * Author: agent
+ *
+ * Created on October 16, 2026, 6:55 PM
+ */
+
+#include "JobSystem.h"
+
+namespace mars
+{
+  /** The amount of times an idle worker looks for work before going to sleep.
+   */
+  static constexpr unsigned SPINS = 64 ;
+
+  /** The job system the calling thread is a worker of. nullptr if it is not a worker.
+   */
+  static thread_local const JobSystem* current = nullptr ;
+
+  /** The worker index of the calling thread in its job system.
+   */
+  static thread_local unsigned current_index = 0 ;
+
+  unsigned Counter::value() const
+  {
+    return this->count.load( std::memory_order_acquire ) ;
+  }
+
+  bool Counter::done() const
+  {
+    return this->value() == 0 ;
+  }
+
+  bool JobSystem::Deque::push( Cell<Job>* job )
+  {
+    const std::int64_t bottom = this->bottom.load( std::memory_order_relaxed ) ;
+    const std::int64_t top    = this->top   .load( std::memory_order_acquire ) ;
+
+    if( bottom - top >= CAPACITY ) return false ;
+
+    this->jobs[ bottom & ( CAPACITY - 1 ) ].store( job, std::memory_order_release ) ;
+    this->bottom.store( bottom + 1, std::memory_order_release ) ;
+
+    return true ;
+  }
+
+  Cell<JobSystem::Job>* JobSystem::Deque::pop()
+  {
+    const std::int64_t bottom = this->bottom.load( std::memory_order_relaxed ) - 1 ;
+
+    #if defined( MARS_THREAD_SANITIZER )
+      // Thread sanitizer can not model the fence, so the store & load are sequentially consistent themselves.
+      this->bottom.store( bottom, std::memory_order_seq_cst ) ;
+
+      std::int64_t top = this->top.load( std::memory_order_seq_cst ) ;
+    #else
+      this->bottom.store( bottom, std::memory_order_relaxed ) ;
+      std::atomic_thread_fence( std::memory_order_seq_cst ) ;
+
+      std::int64_t top = this->top.load( std::memory_order_relaxed ) ;
+    #endif
+
+    if( top > bottom )
+    {
+      this->bottom.store( bottom + 1, std::memory_order_relaxed ) ;
+      return nullptr ;
+    }
+
+    Cell<Job>* job = this->jobs[ bottom & ( CAPACITY - 1 ) ].load( std::memory_order_acquire ) ;
+
+    // The last job may be stolen at the same time, so whoever moves top first wins it.
+    if( top == bottom )
+    {
+      if( !this->top.compare_exchange_strong( top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) ) job = nullptr ;
+      this->bottom.store( bottom + 1, std::memory_order_relaxed ) ;
+    }
+
+    return job ;
+  }
+
+  Cell<JobSystem::Job>* JobSystem::Deque::steal()
+  {
+    #if defined( MARS_THREAD_SANITIZER )
+      std::int64_t top = this->top.load( std::memory_order_seq_cst ) ;
+
+      const std::int64_t bottom = this->bottom.load( std::memory_order_seq_cst ) ;
+    #else
+      std::int64_t top = this->top.load( std::memory_order_acquire ) ;
+
+      std::atomic_thread_fence( std::memory_order_seq_cst ) ;
+
+      const std::int64_t bottom = this->bottom.load( std::memory_order_acquire ) ;
+    #endif
+
+    if( top >= bottom ) return nullptr ;
+
+    Cell<Job>* job = this->jobs[ top & ( CAPACITY - 1 ) ].load( std::memory_order_acquire ) ;
+
+    if( !this->top.compare_exchange_strong( top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) ) return nullptr ;
+
+    return job ;
+  }
+
+  JobSystem::JobSystem( unsigned workers )
+  {
+    this->deques.reserve( workers ) ;
+    for( unsigned index = 0; index < workers; index++ ) this->deques.push_back( new Deque() ) ;
+
+    // Every deque exists before any worker starts stealing.
+    this->threads.reserve( workers ) ;
+    for( unsigned index = 0; index < workers; index++ ) this->threads.emplace_back( [ this, index ]() { this->work( index ) ; } ) ;
+  }
+
+  JobSystem::~JobSystem()
+  {
+    {
+      std::lock_guard<std::mutex> lock( this->sleep_lock ) ;
+      this->running.store( false ) ;
+    }
+
+    this->wake.notify_all() ;
+
+    for( auto& thread : this->threads ) thread.join() ;
+
+    // Jobs queued before shutdown still run, on the destroying thread.
+    while( Cell<Job>* job = this->take() ) this->execute( job ) ;
+
+    for( Deque* deque : this->deques ) delete deque ;
+  }
+
+  JobSystem& JobSystem::global()
+  {
+    static JobSystem system( std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 0 ) ;
+
+    return system ;
+  }
+
+  void JobSystem::wait( Counter& counter )
+  {
+    while( !counter.done() )
+    {
+      Cell<Job>* job = this->take() ;
+
+      if( job ) this->execute( job ) ;
+      else      std::this_thread::yield() ;
+    }
+
+    // The last job may still be releasing the jobs waiting on the counter.
+    while( counter.busy.load( std::memory_order_acquire ) != 0 ) std::this_thread::yield() ;
+  }
+
+  unsigned JobSystem::workers() const
+  {
+    return static_cast<unsigned>( this->threads.size() ) ;
+  }
+
+  void JobSystem::schedule( Cell<Job>* job, Counter* after )
+  {
+    Counter* signal = job->object()->signal ;
+
+    if( signal ) signal->count.fetch_add( 1, std::memory_order_relaxed ) ;
+
+    if( after )
+    {
+      std::lock_guard<std::mutex> lock( after->lock ) ;
+
+      if( !after->done() )
+      {
+        after->waiters.push_back( job ) ;
+        return ;
+      }
+    }
+
+    this->push( job ) ;
+  }
+
+  void JobSystem::push( Cell<Job>* job )
+  {
+    const unsigned index = this->self() ;
+
+    if( index != NONE )
+    {
+      if( !this->deques[ index ]->push( job ) )
+      {
+        this->execute( job ) ;
+        return ;
+      }
+    }
+    else
+    {
+      std::lock_guard<std::mutex> lock( this->shared_lock ) ;
+      this->shared.push_back( job ) ;
+    }
+
+    this->queued.fetch_add( 1 ) ;
+
+    if( this->sleeping.load() != 0 )
+    {
+      std::lock_guard<std::mutex> lock( this->sleep_lock ) ;
+      this->wake.notify_one() ;
+    }
+  }
+
+  Cell<JobSystem::Job>* JobSystem::take()
+  {
+    const unsigned index  = this->self()                                   ;
+    const unsigned amount = static_cast<unsigned>( this->deques.size() ) ;
+    Cell<Job>*     job    = nullptr                                        ;
+
+    if( this->queued.load( std::memory_order_relaxed ) == 0 ) return nullptr ;
+
+    if( index != NONE ) job = this->deques[ index ]->pop() ;
+
+    if( !job )
+    {
+      std::lock_guard<std::mutex> lock( this->shared_lock ) ;
+
+      if( !this->shared.empty() )
+      {
+        job = this->shared.back() ;
+        this->shared.pop_back() ;
+      }
+    }
+
+    // Victims are visited starting after the thief, so thieves spread out over the workers.
+    for( unsigned offset = 1; !job && offset <= amount; offset++ )
+    {
+      const unsigned victim = ( ( index != NONE ? index : 0 ) + offset ) % amount ;
+
+      if( victim != index ) job = this->deques[ victim ]->steal() ;
+    }
+
+    if( job ) this->queued.fetch_sub( 1 ) ;
+
+    return job ;
+  }
+
+  void JobSystem::execute( Cell<Job>* job )
+  {
+    Job&     work   = *job->object() ;
+    Counter* signal = work.signal    ;
+
+    work.call( work.payload ) ;
+    job->dereference() ;
+
+    if( signal ) this->finish( signal ) ;
+  }
+
+  void JobSystem::finish( Counter* counter )
+  {
+    counter->busy.fetch_add( 1, std::memory_order_relaxed ) ;
+
+    if( counter->count.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+    {
+      std::vector<void*> waiters ;
+
+      {
+        std::lock_guard<std::mutex> lock( counter->lock ) ;
+        waiters.swap( counter->waiters ) ;
+      }
+
+      for( void* waiter : waiters ) this->push( static_cast<Cell<Job>*>( waiter ) ) ;
+    }
+
+    // Last touch of the counter. Waiters may destroy it from here on.
+    counter->busy.fetch_sub( 1, std::memory_order_release ) ;
+  }
+
+  void JobSystem::work( unsigned index )
+  {
+    current       = this  ;
+    current_index = index ;
+
+    unsigned idle = 0 ;
+
+    while( this->running.load( std::memory_order_relaxed ) )
+    {
+      Cell<Job>* job = this->take() ;
+
+      if( job )
+      {
+        this->execute( job ) ;
+        idle = 0 ;
+        continue ;
+      }
+
+      if( ++idle < SPINS )
+      {
+        std::this_thread::yield() ;
+        continue ;
+      }
+
+      std::unique_lock<std::mutex> lock( this->sleep_lock ) ;
+
+      this->sleeping.fetch_add( 1 ) ;
+      this->wake.wait( lock, [ this ]() { return this->queued.load() != 0 || !this->running.load() ; } ) ;
+      this->sleeping.fetch_sub( 1 ) ;
+
+      idle = 0 ;
+    }
+
+    current = nullptr ;
+  }
+
+  unsigned JobSystem::self() const
+  {
+    return current == this ? current_index : NONE ;
+  }
+}
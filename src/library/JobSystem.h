@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   JobSystem.h
+ * Author: agent
+ *
+ * Created on October 16, 2026, 6:55 PM
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "Slab.h"
+
+namespace mars
+{
+  /** Forward declare for counter friendship.
+   */
+  class JobSystem ;
+
+  /** Object counting the unfinished jobs of a group, e.g. to wait on them or to start other jobs once they are done.
+   * @note A counter must not be destroyed while jobs signal it or wait on it. Waiting on it with JobSystem::wait guarantees this.
+   *       Counters can be reused once they reached zero.
+   */
+  class Counter
+  {
+    public:
+
+      /** Default constructor.
+       */
+      Counter() = default ;
+
+      /** Copying is disallowed.
+       */
+      Counter( const Counter& counter ) = delete ;
+
+      /** Copying is disallowed.
+       */
+      Counter& operator=( const Counter& counter ) = delete ;
+
+      /** Method to retrieve the amount of unfinished jobs signalling this counter.
+       * @return The amount of unfinished jobs.
+       */
+      unsigned value() const ;
+
+      /** Method to check whether every job signalling this counter is finished.
+       * @return Whether or not every job is finished.
+       */
+      bool done() const ;
+
+    private:
+
+      /** Friend declaration so the job system can count jobs.
+       */
+      friend class JobSystem ;
+
+      /** The amount of unfinished jobs.
+       */
+      std::atomic<unsigned> count = { 0 } ;
+
+      /** The amount of threads still finishing a job of this counter. Keeps the counter alive until they are done with it.
+       */
+      std::atomic<unsigned> busy = { 0 } ;
+
+      /** The lock guarding the jobs waiting on this counter.
+       */
+      std::mutex lock ;
+
+      /** The jobs to start once this counter reaches zero.
+       */
+      std::vector<void*> waiters ;
+  };
+
+  /** Object running jobs on a fixed set of worker threads.
+   * Every worker owns a Chase-Lev deque. Workers push & pop their own jobs at the bottom of their deque, and steal jobs from the top of other workers' deques once theirs is empty.
+   * Jobs submitted from threads that are not workers of this system go through a shared queue.
+   * Threads waiting on a counter help run jobs until it reaches zero, so jobs can wait on other jobs without blocking a worker.
+   */
+  class JobSystem
+  {
+    public:
+
+      /** Constructor.
+       * @param workers The amount of worker threads to start. 0 runs every job on the threads waiting for them.
+       */
+      explicit JobSystem( unsigned workers ) ;
+
+      /** Deconstructor. Runs every job still queued, then stops & joins the workers.
+       */
+      ~JobSystem() ;
+
+      /** Copying is disallowed.
+       */
+      JobSystem( const JobSystem& system ) = delete ;
+
+      /** Copying is disallowed.
+       */
+      JobSystem& operator=( const JobSystem& system ) = delete ;
+
+      /** Static method to retrieve the job system shared by the library, with a worker for every hardware thread but the calling one.
+       * @return Reference to the shared job system.
+       */
+      static JobSystem& global() ;
+
+      /** Method to run a job on this system.
+       * @param function The function to run. Called with no arguments. Must fit a job's payload, so capture large state by pointer.
+       * @param signal The counter to count the job on until it finished. May be nullptr.
+       * @param after The counter to wait on before the job starts. May be nullptr.
+       */
+      template<typename Function>
+      void run( Function function, Counter* signal = nullptr, Counter* after = nullptr ) ;
+
+      /** Method to wait until every job of a counter finished, running other jobs meanwhile.
+       * @param counter The counter to wait on.
+       */
+      void wait( Counter& counter ) ;
+
+      /** Method to split a range of work across this system's threads. The calling thread helps, and returns once every part is done.
+       * @param count The amount of items in the range.
+       * @param grain The least amount of items worth giving to a single job.
+       * @param function The function to call for each part of the range. Called as function( begin, end ).
+       */
+      template<typename Function>
+      void parallelFor( unsigned count, unsigned grain, Function function ) ;
+
+      /** Method to retrieve the amount of worker threads of this system.
+       * @return The amount of worker threads.
+       */
+      unsigned workers() const ;
+
+    private:
+
+      /** A single unit of work.
+       */
+      struct Job
+      {
+        /** The amount of bytes a job's function can take up.
+         */
+        static constexpr std::size_t PAYLOAD = 64 ;
+
+        alignas( std::max_align_t ) unsigned char payload[ PAYLOAD ] ; ///< The storage of the job's function.
+        void    ( *call )( void* payload ) = nullptr                    ; ///< Runs & destroys the job's function.
+        Counter* signal                    = nullptr                    ; ///< The counter to signal once the job finished.
+      };
+
+      /** Fixed size Chase-Lev work stealing deque of jobs.
+       */
+      class Deque
+      {
+        public:
+
+          /** The most jobs a deque holds. Jobs pushed to a full deque are run straight away.
+           */
+          static constexpr std::int64_t CAPACITY = 4096 ;
+
+          /** Method to push a job at the bottom of this deque. Only called by the owning worker.
+           * @param job The job to push.
+           * @return Whether or not the job fit into this deque.
+           */
+          bool push( Cell<Job>* job ) ;
+
+          /** Method to pop the job at the bottom of this deque. Only called by the owning worker.
+           * @return The popped job. nullptr if this deque is empty.
+           */
+          Cell<Job>* pop() ;
+
+          /** Method to steal the job at the top of this deque. Called by any thread.
+           * @return The stolen job. nullptr if this deque is empty or another thread won the job.
+           */
+          Cell<Job>* steal() ;
+
+        private:
+
+          /** The end thieves steal from. On its own cache line so thieves do not slow down the owner.
+           */
+          alignas( 64 ) std::atomic<std::int64_t> top = { 0 } ;
+
+          /** The end the owner pushes & pops at.
+           */
+          alignas( 64 ) std::atomic<std::int64_t> bottom = { 0 } ;
+
+          /** The ring of jobs.
+           */
+          std::atomic<Cell<Job>*> jobs[ CAPACITY ] = {} ;
+      };
+
+      /** Value used to represent a thread that is not a worker.
+       */
+      static constexpr unsigned NONE = 0xFFFFFFFF ;
+
+      /** Helper method to count & queue a job, or park it on the counter it waits on.
+       * @param job The job to schedule.
+       * @param after The counter to wait on before the job starts. May be nullptr.
+       */
+      void schedule( Cell<Job>* job, Counter* after ) ;
+
+      /** Helper method to queue a job that is ready to run.
+       * @param job The job to queue.
+       */
+      void push( Cell<Job>* job ) ;
+
+      /** Helper method to take a job to run, from the calling worker's deque, the shared queue, or another worker.
+       * @return The job to run. nullptr if there is no work.
+       */
+      Cell<Job>* take() ;
+
+      /** Helper method to run a job, signal its counter, and free it.
+       * @param job The job to run.
+       */
+      void execute( Cell<Job>* job ) ;
+
+      /** Helper method to signal that a job of a counter finished, starting the jobs waiting on it once it reaches zero.
+       * @param counter The counter to signal.
+       */
+      void finish( Counter* counter ) ;
+
+      /** Helper method run by every worker thread.
+       * @param index The index of the worker.
+       */
+      void work( unsigned index ) ;
+
+      /** Helper method to retrieve the worker index of the calling thread in this system.
+       * @return The index of the calling worker. NONE if the calling thread is not a worker of this system.
+       */
+      unsigned self() const ;
+
+      /** The storage of every job.
+       */
+      Slab<Job> jobs ;
+
+      /** The deque of every worker.
+       */
+      std::vector<Deque*> deques ;
+
+      /** The worker threads.
+       */
+      std::vector<std::thread> threads ;
+
+      /** The queue of jobs submitted by threads that are not workers.
+       */
+      std::vector<Cell<Job>*> shared ;
+
+      /** The lock guarding the shared queue.
+       */
+      std::mutex shared_lock ;
+
+      /** The amount of jobs queued but not yet taken. Lets idle workers sleep.
+       */
+      std::atomic<unsigned> queued = { 0 } ;
+
+      /** The amount of workers asleep.
+       */
+      std::atomic<unsigned> sleeping = { 0 } ;
+
+      /** The lock idle workers sleep on.
+       */
+      std::mutex sleep_lock ;
+
+      /** The condition idle workers sleep on.
+       */
+      std::condition_variable wake ;
+
+      /** Whether or not the workers keep running.
+       */
+      std::atomic<bool> running = { true } ;
+  };
+
+  template<typename Function>
+  void JobSystem::run( Function function, Counter* signal, Counter* after )
+  {
+    static_assert( sizeof( Function ) <= Job::PAYLOAD && alignof( Function ) <= alignof( std::max_align_t ), "Job functions must fit a job's payload. Capture large state by pointer." ) ;
+
+    Cell<Job>* cell = this->jobs.allocate() ;
+    Job&       job  = *cell->object()       ;
+
+    new ( job.payload ) Function( std::move( function ) ) ;
+
+    job.signal = signal ;
+    job.call   = []( void* payload )
+    {
+      Function* function = static_cast<Function*>( payload ) ;
+
+      ( *function )() ;
+      function->~Function() ;
+    };
+
+    this->schedule( cell, after ) ;
+  }
+
+  template<typename Function>
+  void JobSystem::parallelFor( unsigned count, unsigned grain, Function function )
+  {
+    // A few parts per thread, so threads that finish early can steal the rest.
+    const unsigned threads = ( this->workers() + 1 ) * 4                                ;
+    const unsigned parts   = grain != 0 ? ( count + grain - 1 ) / grain : count       ;
+    const unsigned amount  = threads < parts ? threads : parts                        ;
+
+    if( amount <= 1 )
+    {
+      if( count != 0 ) function( 0u, count ) ;
+      return ;
+    }
+
+    const unsigned size = ( count + amount - 1 ) / amount ;
+    Counter        counter                                ;
+
+    for( unsigned begin = size; begin < count; begin += size )
+    {
+      const unsigned end = begin + size < count ? begin + size : count ;
+
+      this->run( [ &function, begin, end ]() { function( begin, end ) ; }, &counter ) ;
+    }
+
+    function( 0u, size ) ;
+
+    this->wait( counter ) ;
+  }
+}
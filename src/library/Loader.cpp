@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Loader.cpp
+ * Author: agent
+ *
+ * Created on October 16, 2026, 7:11 PM
+ */
+
+#include "Loader.h"
+
+/** The amount of threads of the loader shared by the library. Loads mostly wait on I/O, so a few suffice.
+ */
+#ifndef MARS_LOADER_THREADS
+  #define MARS_LOADER_THREADS 2
+#endif
+
+namespace mars
+{
+  Loader::Loader( unsigned threads )
+  {
+    if( threads == 0 ) threads = 1 ;
+
+    this->workers.reserve( threads ) ;
+
+    for( unsigned index = 0; index < threads; index++ ) this->workers.emplace_back( &Loader::work, this ) ;
+  }
+
+  Loader::~Loader()
+  {
+    {
+      std::lock_guard<std::mutex> lock( this->lock ) ;
+      this->running = false ;
+    }
+
+    this->wake.notify_all() ;
+
+    for( auto& thread : this->workers ) thread.join() ;
+  }
+
+  Loader& Loader::global()
+  {
+    static Loader loader( MARS_LOADER_THREADS ) ;
+
+    return loader ;
+  }
+
+  void Loader::submit( Task* task, int priority )
+  {
+    {
+      std::lock_guard<std::mutex> lock( this->lock ) ;
+
+      task->priority = priority       ;
+      task->order    = this->queued++ ;
+
+      this->heap.push_back( task ) ;
+      this->place( this->heap.size() - 1, task ) ;
+      this->raise( task->slot ) ;
+      this->active++ ;
+    }
+
+    this->wake.notify_one() ;
+  }
+
+  bool Loader::prioritize( Task* task, int priority )
+  {
+    std::lock_guard<std::mutex> lock( this->lock ) ;
+
+    if( task->slot == Task::UNQUEUED ) return false ;
+
+    const int previous = task->priority ;
+
+    task->priority = priority ;
+
+    if( priority > previous ) this->raise( task->slot ) ;
+    else                      this->lower( task->slot ) ;
+
+    return true ;
+  }
+
+  bool Loader::cancel( Task* task )
+  {
+    {
+      std::lock_guard<std::mutex> lock( this->lock ) ;
+
+      if( task->slot == Task::UNQUEUED ) return false ;
+
+      this->remove( task->slot ) ;
+
+      if( --this->active != 0 ) return true ;
+    }
+
+    this->drained.notify_all() ;
+
+    return true ;
+  }
+
+  void Loader::wait()
+  {
+    std::unique_lock<std::mutex> lock( this->lock ) ;
+
+    this->drained.wait( lock, [ this ]() { return this->active == 0 ; } ) ;
+  }
+
+  unsigned Loader::threads() const
+  {
+    return static_cast<unsigned>( this->workers.size() ) ;
+  }
+
+  void Loader::work()
+  {
+    std::unique_lock<std::mutex> lock( this->lock ) ;
+
+    while( true )
+    {
+      // Tasks queued before shutdown still run.
+      this->wake.wait( lock, [ this ]() { return !this->heap.empty() || !this->running ; } ) ;
+
+      if( this->heap.empty() ) return ;
+
+      Task* task = this->heap.front() ;
+
+      this->remove( 0 ) ;
+
+      lock.unlock() ;
+      task->run() ;
+      lock.lock() ;
+
+      if( --this->active == 0 ) this->drained.notify_all() ;
+    }
+  }
+
+  bool Loader::before( const Task* first, const Task* second )
+  {
+    return first->priority != second->priority ? first->priority > second->priority : first->order < second->order ;
+  }
+
+  void Loader::raise( std::size_t slot )
+  {
+    Task* task = this->heap[ slot ] ;
+
+    while( slot != 0 )
+    {
+      const std::size_t parent = ( slot - 1 ) / 2 ;
+
+      if( !Loader::before( task, this->heap[ parent ] ) ) break ;
+
+      this->place( slot, this->heap[ parent ] ) ;
+      slot = parent ;
+    }
+
+    this->place( slot, task ) ;
+  }
+
+  void Loader::lower( std::size_t slot )
+  {
+    Task*             task = this->heap[ slot ] ;
+    const std::size_t size = this->heap.size()  ;
+
+    while( true )
+    {
+      std::size_t child = slot * 2 + 1 ;
+
+      if( child >= size ) break ;
+      if( child + 1 < size && Loader::before( this->heap[ child + 1 ], this->heap[ child ] ) ) child++ ;
+      if( !Loader::before( this->heap[ child ], task ) ) break ;
+
+      this->place( slot, this->heap[ child ] ) ;
+      slot = child ;
+    }
+
+    this->place( slot, task ) ;
+  }
+
+  void Loader::place( std::size_t slot, Task* task )
+  {
+    this->heap[ slot ] = task ;
+    task->slot         = slot ;
+  }
+
+  void Loader::remove( std::size_t slot )
+  {
+    Task* task = this->heap[ slot ] ;
+    Task* last = this->heap.back()  ;
+
+    this->heap.pop_back() ;
+    task->slot = Task::UNQUEUED ;
+
+    if( task == last ) return ;
+
+    // The last task fills the hole, then moves whichever way restores the order.
+    this->place( slot, last ) ;
+    this->raise( slot ) ;
+    this->lower( last->slot ) ;
+  }
+
+  Dispatcher::~Dispatcher()
+  {
+    this->dispatch() ;
+  }
+
+  void Dispatcher::post( Task* task )
+  {
+    std::lock_guard<std::mutex> lock( this->lock ) ;
+
+    task->next = nullptr ;
+
+    if( this->tail ) this->tail->next = task ;
+    else             this->head       = task ;
+
+    this->tail = task ;
+  }
+
+  unsigned Dispatcher::dispatch()
+  {
+    Task*    task  = nullptr ;
+    unsigned count = 0       ;
+
+    {
+      std::lock_guard<std::mutex> lock( this->lock ) ;
+
+      task       = this->head ;
+      this->head = nullptr    ;
+      this->tail = nullptr    ;
+    }
+
+    // Tasks posted while dispatching run on the next dispatch.
+    while( task )
+    {
+      Task* next = task->next ;
+
+      task->run() ;
+      task = next ;
+      count++ ;
+    }
+
+    return count ;
+  }
+}
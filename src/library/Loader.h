@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Loader.h
+ * Author: agent
+ *
+ * Created on October 16, 2026, 7:11 PM
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mars
+{
+  /** A single unit of work run by a loader or a dispatcher. Keeps its own queue state, so queueing it allocates no node.
+   */
+  class Task
+  {
+    public:
+
+      /** Virtual deconstructor.
+       */
+      virtual ~Task() {} ;
+
+      /** Method to run this task. The task may free itself once done.
+       */
+      virtual void run() = 0 ;
+
+    private:
+
+      /** Friend declarations so queues can link tasks.
+       */
+      friend class Loader     ;
+      friend class Dispatcher ;
+
+      /** Value of a task's slot while it is not queued on a loader.
+       */
+      static constexpr std::size_t UNQUEUED = static_cast<std::size_t>( -1 ) ;
+
+      /** The next task in the dispatcher this task waits in.
+       */
+      Task* next = nullptr ;
+
+      /** The priority of this task on a loader. Higher runs first.
+       */
+      int priority = 0 ;
+
+      /** The order this task was queued in on a loader, so tasks of the same priority run first come, first served.
+       */
+      std::uint64_t order = 0 ;
+
+      /** The position of this task in its loader's heap. UNQUEUED if not waiting on a loader.
+       */
+      std::size_t slot = UNQUEUED ;
+  };
+
+  /** Object running tasks on a fixed set of threads dedicated to loading, e.g. file I/O & decoding.
+   * Kept apart from the JobSystem, so blocking loads never stall the workers running frame work.
+   * Queued tasks wait in a binary heap, so the highest priority task always runs next. Their priority can change, and they can be cancelled, until they run.
+   */
+  class Loader
+  {
+    public:
+
+      /** Constructor.
+       * @param threads The amount of loader threads to start. At least one is started.
+       */
+      explicit Loader( unsigned threads ) ;
+
+      /** Deconstructor. Runs every task still queued, then stops & joins the loader threads.
+       */
+      ~Loader() ;
+
+      /** Copying is disallowed.
+       */
+      Loader( const Loader& loader ) = delete ;
+
+      /** Copying is disallowed.
+       */
+      Loader& operator=( const Loader& loader ) = delete ;
+
+      /** Static method to retrieve the loader shared by the library, with MARS_LOADER_THREADS threads.
+       * @return Reference to the shared loader.
+       */
+      static Loader& global() ;
+
+      /** Method to queue a task to run on a loader thread.
+       * @param task The task to run. Must stay alive until it ran or got cancelled.
+       * @param priority The priority of the task. Higher runs first.
+       */
+      void submit( Task* task, int priority = 0 ) ;
+
+      /** Method to change the priority of a queued task.
+       * @param task The task to change the priority of.
+       * @param priority The new priority of the task. Higher runs first.
+       * @return Whether or not the task still was queued. Tasks already taken by a loader thread keep running.
+       */
+      bool prioritize( Task* task, int priority ) ;
+
+      /** Method to take a queued task off this loader, before it ran.
+       * @param task The task to cancel.
+       * @return Whether or not the task still was queued, and got cancelled. The caller owns cancelled tasks.
+       */
+      bool cancel( Task* task ) ;
+
+      /** Method to wait until every task queued so far ran, including tasks they queued meanwhile.
+       * @note Must not be called from a loader thread.
+       */
+      void wait() ;
+
+      /** Method to retrieve the amount of loader threads.
+       * @return The amount of loader threads.
+       */
+      unsigned threads() const ;
+
+    private:
+
+      /** Helper method run by every loader thread.
+       */
+      void work() ;
+
+      /** Helper method to check whether a task should run before another.
+       * @param first The task to check.
+       * @param second The task to check against.
+       * @return Whether or not the first task runs before the second.
+       */
+      static bool before( const Task* first, const Task* second ) ;
+
+      /** Helper method to move a task towards the top of the heap, until it is in order.
+       * @param slot The position of the task.
+       */
+      void raise( std::size_t slot ) ;
+
+      /** Helper method to move a task towards the bottom of the heap, until it is in order.
+       * @param slot The position of the task.
+       */
+      void lower( std::size_t slot ) ;
+
+      /** Helper method to place a task at a position of the heap.
+       * @param slot The position to place the task at.
+       * @param task The task to place.
+       */
+      void place( std::size_t slot, Task* task ) ;
+
+      /** Helper method to take a task off the heap.
+       * @param slot The position of the task.
+       */
+      void remove( std::size_t slot ) ;
+
+      /** The loader threads.
+       */
+      std::vector<std::thread> workers ;
+
+      /** The heap of tasks waiting to run, highest priority first.
+       */
+      std::vector<Task*> heap ;
+
+      /** The amount of tasks queued so far. Orders tasks of the same priority.
+       */
+      std::uint64_t queued = 0 ;
+
+      /** The amount of tasks queued or running.
+       */
+      unsigned active = 0 ;
+
+      /** Whether or not the loader threads keep running.
+       */
+      bool running = true ;
+
+      /** The lock guarding the queue.
+       */
+      std::mutex lock ;
+
+      /** The condition loader threads sleep on.
+       */
+      std::condition_variable wake ;
+
+      /** The condition threads waiting for the queue to drain sleep on.
+       */
+      std::condition_variable drained ;
+  };
+
+  /** Object collecting tasks from any thread, to run them on a thread of the caller's choosing, e.g. the main thread once a frame.
+   */
+  class Dispatcher
+  {
+    public:
+
+      /** Default constructor.
+       */
+      Dispatcher() = default ;
+
+      /** Deconstructor. Runs every task still posted on the destroying thread.
+       */
+      ~Dispatcher() ;
+
+      /** Copying is disallowed.
+       */
+      Dispatcher( const Dispatcher& dispatcher ) = delete ;
+
+      /** Copying is disallowed.
+       */
+      Dispatcher& operator=( const Dispatcher& dispatcher ) = delete ;
+
+      /** Method to post a task to run on the next dispatch. Safe to call from any thread.
+       * @param task The task to run. Must stay alive until it ran.
+       */
+      void post( Task* task ) ;
+
+      /** Method to run every task posted so far, in posting order, on the calling thread.
+       * @return The amount of tasks ran.
+       */
+      unsigned dispatch() ;
+
+    private:
+
+      /** The first task posted.
+       */
+      Task* head = nullptr ;
+
+      /** The last task posted.
+       */
+      Task* tail = nullptr ;
+
+      /** The lock guarding the posted tasks.
+       */
+      std::mutex lock ;
+  };
+}
@@ -27,8 +27,40 @@
 /** Shouldn't have to worry about ABI because this is header only... I think.
  */
 #include "Factory.h"
+#include "ConcurrentMap.h"
+#include "Epoch.h"
+#include "FileWatcher.h"
+#include "FlatMap.h"
+#include "Loader.h"
 #include "Mars.h"
-#include <unordered_map>
+#include "WeakReference.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/** Whether the coroutine API of the manager is available. Requires building with C++20 or newer, see CXX_STANDARD.
+ */
+#ifndef MARS_COROUTINES
+  #if defined( __cpp_impl_coroutine ) && defined( __has_include )
+    #if __has_include( <coroutine> )
+      #define MARS_COROUTINES 1
+    #endif
+  #endif
+#endif
+
+#ifndef MARS_COROUTINES
+  #define MARS_COROUTINES 0
+#endif
+
+#if MARS_COROUTINES
+  #include <coroutine>
+#endif
 
 namespace mars
 {
@@ -37,8 +69,40 @@ namespace mars
   template<typename Type>
   using Reference = Data<Type> ;
   
+  /** Traits object measuring the memory an object held by a Manager takes up, to keep the manager within its budget.
+   * Uses the object's byteSize() method if it has one, e.g. to count texture memory, and sizeof otherwise.
+   * @tparam Type The type of object measured.
+   */
+  template<typename Type, typename = void>
+  struct ByteSize
+  {
+    /** Static method to measure an object.
+     * @return The amount of bytes the object takes up.
+     */
+    static std::size_t of( const Type& ) { return sizeof( Type ) ; } ;
+  };
+  
+  /** Traits object measuring the memory of objects with a byteSize() method.
+   */
+  template<typename Type>
+  struct ByteSize<Type, std::void_t<decltype( std::declval<const Type&>().byteSize() )>>
+  {
+    /** Static method to measure an object.
+     * @param object The object to measure.
+     * @return The amount of bytes the object takes up.
+     */
+    static std::size_t of( const Type& object ) { return static_cast<std::size_t>( object.byteSize() ) ; } ;
+  };
+  
   
   /** Static template object for containing and referencing data.
+   * Safe to use from any thread. Lookups through reference, handle & has take no lock, and concurrent creates of the same key resolve to a single object.
+   * Requests load asynchronously: fulfillers run on the shared Loader's threads, and their results are published into this manager before callbacks are delivered.
+   * Requests of a key already loading join the load in flight, so a key is fulfilled once however many times it is requested.
+   * Loads run highest priority first. A load takes the highest priority of the requests waiting on it, which tickets can change or cancel until delivered.
+   * Unreferenced data stays resident until cleanup needs the room to keep every key within the budget, see setBudget.
+   * Data tells the manager once its last reference outside of the manager is removed, so cleanup only ever visits data nobody references.
+   * Keys can be reloaded in place, e.g. when their file changes. The reloaded data replaces the key's data atomically, so lookups never wait on a reload.
    * @tparam Type The type of data to manage.
    */
   template<typename Key, typename Type>
@@ -88,6 +152,37 @@ namespace mars
           FCallback m_callback ;
       };
       
+      /** Weak reference to the data of a key, that follows the key across reloads.
+       * Locking looks the key up again, a single lock-free probe, so holders retrieve the reloaded data on their next lock, where a Reference keeps the data it was made for.
+       * @note Does not keep the key's data alive, nor keep cleanup from releasing it.
+       */
+      class KeyReference
+      {
+        public:
+          /** Constructor.
+           * @param key The key to reference the data of.
+           */
+          explicit KeyReference( const Key& key ) : m_key( key ) {}
+          
+          /** Method to retrieve a reference to the key's current data.
+           * @return A reference to the data of the key. Empty if the key is not in the manager.
+           */
+          Reference<Type> lock() const { return Manager<Key, Type>::lookup( this->m_key ) ; } ;
+          
+          /** Method to check whether the key left the manager.
+           * @return Whether or not the key has no data.
+           */
+          bool expired() const { return !Manager<Key, Type>::has( this->m_key ) ; } ;
+          
+          /** Method to retrieve the key referenced.
+           * @return The key this object references the data of.
+           */
+          const Key& key() const { return this->m_key ; } ;
+          
+        private:
+          Key m_key ; ///< The key to reference the data of.
+      };
+      
       /** Static method to retrieve a reference of the value of this object at the specified key.
        * @note Forwards a library warning on invalid access.
        * @param key The key to retrieve the reference of.
@@ -95,25 +190,124 @@ namespace mars
        */
       static Reference<Type> reference( const Key& key ) ;
       
+      /** Static method to retrieve a lightweight handle of the value of this object at the specified key.
+       * @note Forwards a library warning on invalid access. The handle stays valid while the value is held by this manager, and is not followed across reloads, see KeyReference.
+       * @param key The key to retrieve the handle of.
+       * @return The handle of the key if it exists; an invalid handle otherwise.
+       */
+      static Handle<Type> handle( const Key& key ) ;
+      
+      /** Static method to retrieve the references of many keys at once, e.g. every asset of a scene being instantiated.
+       * Takes a single probe per key, pins the epoch once for the whole batch, and prefetches the upcoming keys' buckets while resolving the current one.
+       * @note Forwards a library error once if any key is missing, like reference.
+       * @param keys The keys to retrieve the references of.
+       * @param count The amount of keys.
+       * @return The reference of every key, in order. Empty for keys that do not exist.
+       */
+      static std::vector<Reference<Type>> referenceMany( const Key* keys, unsigned count ) ;
+      
+      /** Static method to retrieve the references of many keys at once, e.g. every asset of a scene being instantiated.
+       * @note Forwards a library error once if any key is missing, like reference.
+       * @param keys The keys to retrieve the references of.
+       * @return The reference of every key, in order. Empty for keys that do not exist.
+       */
+      static std::vector<Reference<Type>> referenceMany( const std::vector<Key>& keys ) ;
+      
+      /** Static method to retrieve the references of many keys at once, creating the data of the keys that do not exist yet.
+       * Takes a single probe per key, and locks every part of the manager once for all of its keys in the batch.
+       * @param keys The keys to retrieve or create the references of. Keys appearing more than once are created once.
+       * @param count The amount of keys.
+       * @param params The parameters to use for initializing every created object. Passed by reference to every initialize call.
+       * @return The reference of every key, in order.
+       */
+      template<typename ... Parameters>
+      static std::vector<Reference<Type>> getOrCreateMany( const Key* keys, unsigned count, const Parameters&... params ) ;
+      
+      /** Static method to retrieve the references of many keys at once, creating the data of the keys that do not exist yet.
+       * @param keys The keys to retrieve or create the references of. Keys appearing more than once are created once.
+       * @param params The parameters to use for initializing every created object. Passed by reference to every initialize call.
+       * @return The reference of every key, in order.
+       */
+      template<typename ... Parameters>
+      static std::vector<Reference<Type>> getOrCreateMany( const std::vector<Key>& keys, const Parameters&... params ) ;
+      
       /** Static method to check and see if a type is in the manager.
        * @param key The key to look for.
        * @return Whether or not there is a value at the key.
        */
       static bool has( const Key& key ) ;
       
-      /** Static method to request data to be loaded to the manager.
+      /** Object identifying a request, to change its priority or cancel it while it waits. Cheap to copy, and safe to use once the request is delivered.
+       */
+      class Ticket
+      {
+        public:
+          /** Default constructor. Creates a ticket of no request.
+           */
+          Ticket() ;
+          
+          /** Method to change the priority of the request. The load of its key is moved accordingly, unless it already started.
+           * @param priority The new priority of the request. Higher loads first.
+           * @return Whether or not the request still waited on its load.
+           */
+          bool prioritize( int priority ) const ;
+          
+          /** Method to cancel the request. Its callback will not be called. The load of its key is cancelled too once no request waits on it, unless it already started.
+           * @return Whether or not the request still waited on its load, and got cancelled.
+           */
+          bool cancel() const ;
+          
+        private:
+          /** Friend declaration so the manager can hand out tickets.
+           */
+          friend class Manager<Key, Type> ;
+          
+          /** Constructor.
+           * @param key The key the request waits on.
+           * @param id The identifier of the request.
+           */
+          Ticket( Key key, std::uint64_t id ) ;
+          
+          Key           key ; ///< The key the request waits on.
+          std::uint64_t id  ; ///< The identifier of the request. 0 for no request.
+      };
+      
+      /** Static method to request data to be loaded to the manager. Returns straight away, the first fulfiller runs on a loader thread.
+       * @note Keys already in the manager are delivered without fulfilling them again. The reference is empty if there is no fulfiller, or it failed.
        * @param object The object the callback belongs to.
        * @param callback The callback to call when the request has been fulfilled.
        * @param key The key to load.
+       * @param dispatcher The dispatcher to deliver the callback through, on the thread dispatching it. nullptr calls it on the loader thread.
+       * @param priority The priority of the request. Higher loads first.
+       * @return The ticket of the request.
        */
       template<typename Object>
-      static void request( Object* object, void (Object::*callback)( Key, mars::Reference<Type> ), Key key ) ;
+      static Ticket request( Object* object, void (Object::*callback)( Key, mars::Reference<Type> ), Key key, Dispatcher* dispatcher = nullptr, int priority = 0 ) ;
       
-      /** Static method to request data to be loaded to the manager.
+      /** Static method to request data to be loaded to the manager. Returns straight away, the first fulfiller runs on a loader thread.
+       * @note Keys already in the manager are delivered without fulfilling them again. The reference is empty if there is no fulfiller, or it failed.
        * @param callback The callback to call when the request has been fulfilled.
        * @param key The key to load.
+       * @param dispatcher The dispatcher to deliver the callback through, on the thread dispatching it. nullptr calls it on the loader thread.
+       * @param priority The priority of the request. Higher loads first.
+       * @return The ticket of the request.
+       */
+      static Ticket request( void (*callback)( Key, mars::Reference<Type> ), Key key, Dispatcher* dispatcher = nullptr, int priority = 0 ) ;
+      
+      #if MARS_COROUTINES
+      /** Awaitable load of a key, see load.
+       */
+      class Loading ;
+      
+      /** Static method to load data to the manager from a coroutine, as co_await Manager::load( key ). Starts loading straight away, so loads created before awaiting run concurrently.
+       * @note Keys already in the manager complete without suspending. The loaded reference is empty if there is no fulfiller, or it failed.
+       * @param key The key to load.
+       * @param executor The dispatcher to resume the awaiting coroutine through. nullptr resumes it on the loader thread.
+       * @param priority The priority of the load. Higher loads first.
+       * @return The load to co_await the reference of.
        */
-      static void request( void (*callback)( Key, mars::Reference<Type> ), Key key ) ;
+      static Loading load( const Key& key, Dispatcher* executor = nullptr, int priority = 0 ) ;
+      #endif
       
       /** Static method to add a callback to use to fullfill requests to the manager.
        * @param object The object the callback belongs to.
@@ -130,22 +324,78 @@ namespace mars
       static void addFulfiller( void (*callback)( Key, Callback* ), Key key ) ;
       
       /** Static method to remove a fulfiller.
+       * @note Requests still loading may be using it, see Loader::wait.
        * @param key The key representing the fulfiller to remove.
        */
       static void removeFulfiller( Key key ) ;
       
+      /** Static method to load the data of a key again, e.g. after its source file changed. Returns straight away, the first fulfiller runs on a loader thread.
+       * Once loaded, the reloaded data replaces the key's data atomically. Lookups & KeyReference locks retrieve the reloaded data from then on.
+       * References & handles already handed out keep the data they were made for, which is reset & released by cleanup once its last reference is gone.
+       * @note Keys not in the manager are not reloaded. Fulfillers must create through make to reload, as creating through the key retrieves the key's current data. Requests publish made data just the same.
+       * @param key The key to reload.
+       * @param priority The priority of the reload. Higher loads first.
+       */
+      static void reload( const Key& key, int priority = 0 ) ;
+      
+      /** Static method to reload a key whenever a file changes, e.g. the file the key's data is loaded from. See reload.
+       * @note Changes are picked up by the shared FileWatcher. Watching a key again replaces the file it is watched through.
+       * @param key The key to reload.
+       * @param path The path of the file to watch.
+       */
+      static void watch( const Key& key, const std::string& path ) ;
+      
+      /** Static method to stop reloading a key when its file changes.
+       * @param key The key to stop watching.
+       */
+      static void unwatch( const Key& key ) ;
+      
       /** Static method to create an object and insert it into this object.
        * @param key The key to insert the object into, if possible.
-       * @param params The parameters to use for initializing the object.
+       * @param params The parameters to use for initializing the object. Forwarded as-is, so temporaries are moved into initialize.
+       * @return A reference to the created object.
+       */
+      template<typename ... Parameters>
+      static Reference<Type> create( const Key& key, Parameters&&... params ) ;
+      
+      /** Static method to construct an object directly from the parameters and insert it into this object.
+       * Skips default construction & initialize, for types that can be fully constructed from their parameters.
+       * @param key The key to insert the object into, if possible.
+       * @param params The parameters to construct the object with. Forwarded as-is.
+       * @return A reference to the created object.
+       */
+      template<typename ... Parameters>
+      static Reference<Type> emplace( const Key& key, Parameters&&... params ) ;
+      
+      /** Static method to create an object outside of any key, e.g. for a fulfiller to load or reload a key with.
+       * The object is released along with its last reference, unless it replaced the data of a key.
+       * @param params The parameters to use for initializing the object. Forwarded as-is.
        * @return A reference to the created object.
        */
       template<typename ... Parameters>
-      static Reference<Type> create( const Key& key, Parameters... params ) ;
+      static Reference<Type> make( Parameters&&... params ) ;
       
       /** Static method to cleanup this object's leftover data.
-       * Any data with no references will be reset and released.
+       * Data with no references is reset and released, least recently unreferenced first, until the data of every key fits the budget.
+       * Only data unreferenced since the previous cleanup, and the data released, is visited. Referenced data costs nothing however much of it there is.
+       * Lookups racing with cleanup either retrieve a reference that keeps the data alive, or find nothing. Weak references to released data fail to lock.
        */
       static void cleanup() ;
+      
+      /** Static method to set the amount of memory the data of every key may take up before cleanup releases unreferenced data.
+       * @param bytes The budget, as measured by ByteSize. 0, the default, releases all unreferenced data on every cleanup.
+       */
+      static void setBudget( std::size_t bytes ) ;
+      
+      /** Static method to retrieve the amount of memory the data of every key may take up before cleanup releases unreferenced data.
+       * @return The budget, as measured by ByteSize.
+       */
+      static std::size_t budget() ;
+      
+      /** Static method to retrieve the amount of memory the data of every key takes up.
+       * @return The resident bytes, as measured by ByteSize when the data was inserted.
+       */
+      static std::size_t residentBytes() ;
 
       /** Class for publishing data through function pointers AKA 'getters'.
        */
@@ -156,9 +406,10 @@ namespace mars
            */
           virtual ~Fulfiller() {} ;
           
-          /** Method to 
-           * @param index The index to use for publishing.
-           * @return The internal function's published data.
+          /** Method to load the data of a key. Runs on a loader thread.
+           * @note The callback must be called exactly once, with the loaded reference or an empty one on failure. It may be called later, from any thread.
+           * @param key The key to load.
+           * @param callback The callback to publish the loaded data through.
            */
           virtual void fulfill( Key key, Callback* callback ) = 0 ;
       };
@@ -182,7 +433,7 @@ namespace mars
       class FunctionFulfiller : public Fulfiller
       {
         public:
-          using FCallback = void(*)( Key, mars::Reference<Type> ) ;
+          using FCallback = void(*)( Key, Callback* ) ;
           
           FunctionFulfiller( FCallback cb ) ;
           
@@ -191,17 +442,309 @@ namespace mars
           FCallback callback ;
       };
       
-      /** Static member to contain this object's data.
+      /** Forward declare for waiter friendship.
+       */
+      class Load ;
+      
+      /** A request waiting for its key to load. Delivers the loaded reference on the loader thread, or through a dispatcher.
+       */
+      class Waiter : public Task
+      {
+        public:
+          /** Constructor.
+           * @param key The key waited on.
+           * @param dispatcher The dispatcher to deliver through. nullptr delivers on the loader thread.
+           * @param priority The priority of the request.
+           */
+          Waiter( Key key, Dispatcher* dispatcher, int priority ) ;
+          
+          /** Method to hand over the loaded reference, and deliver it.
+           * @param reference The loaded reference. Empty if loading failed.
+           */
+          void complete( Reference<Type> reference ) ;
+          
+          /** Method to free this request once cancelled.
+           */
+          virtual void discard() ;
+          
+        protected:
+          /** Friend declarations so loads can chain their requests, & the manager can hand out tickets.
+           */
+          friend class Manager<Key, Type>::Load ;
+          friend class Manager<Key, Type>       ;
+          
+          Key             key        ; ///< The key waited on.
+          Reference<Type> result     ; ///< The loaded reference.
+          Dispatcher*     dispatcher ; ///< The dispatcher to deliver through. May be nullptr.
+          Waiter*         sibling    ; ///< The next request waiting on the same load.
+          int             priority   ; ///< The priority of the request.
+          std::uint64_t   id         ; ///< The identifier of the request, as handed out by its ticket.
+      };
+      
+      /** A request delivering to a callback held by value, so a request takes a single allocation. Frees itself once delivered.
+       * @tparam Delivery The callback to deliver to, a MethodCallback or FunctionCallback.
+       */
+      template<typename Delivery>
+      class Request : public Waiter
+      {
+        public:
+          /** Constructor.
+           * @param key The key waited on.
+           * @param dispatcher The dispatcher to deliver through. nullptr delivers on the loader thread.
+           * @param priority The priority of the request.
+           * @param delivery The callback to deliver to.
+           */
+          Request( Key key, Dispatcher* dispatcher, int priority, Delivery delivery ) ;
+          
+          /** Method to deliver the loaded reference to the callback, then free this request.
+           */
+          void run() override ;
+          
+        private:
+          Delivery delivery ; ///< The callback to deliver to.
+      };
+      
+      /** The load of a key, run on a loader thread. Handed to the fulfiller as its callback, and frees itself once called back.
+       */
+      class Load : public Task, public Callback
+      {
+        public:
+          /** Constructor.
+           * @param key The key to load.
+           * @param waiter The first request waiting on the load.
+           */
+          Load( Key key, Waiter* waiter ) ;
+          
+          /** Method to add a request to the ones waiting on this load. Only called with the pending loads locked.
+           * @param waiter The request to add.
+           */
+          void join( Waiter* waiter ) ;
+          
+          /** Method to change the priority of a request waiting on this load, and move the load accordingly. Only called with the pending loads locked.
+           * @param id The identifier of the request.
+           * @param priority The new priority of the request.
+           * @return Whether or not the request waits on this load.
+           */
+          bool prioritize( std::uint64_t id, int priority ) ;
+          
+          /** Method to take a request off this load, and free it. Frees the load too once no request waits on it, unless it already started. Only called with the pending loads locked.
+           * @param id The identifier of the request.
+           * @return Whether or not the request waited on this load.
+           */
+          bool cancel( std::uint64_t id ) ;
+          
+          /** Method to retrieve the highest priority of the requests waiting on this load.
+           * @return The priority of this load.
+           */
+          int priority() const ;
+          
+          /** Method to load the key, unless it already is in the manager.
+           */
+          void run() override ;
+          
+          /** Method called by the fulfiller once loaded. Publishes the reference, then completes every waiting request with it.
+           * @param key The key loaded.
+           * @param reference The loaded reference. Empty if loading failed.
+           */
+          void callback( Key key, mars::Reference<Type> reference ) override ;
+          
+        private:
+          Key     key    ; ///< The key to load.
+          Waiter* first  ; ///< The first request waiting on the load.
+          Waiter* last   ; ///< The last request waiting on the load.
+      };
+      
+      /** The reload of a key, run on a loader thread. Handed to the fulfiller as its callback, and frees itself once called back.
+       */
+      class Reload : public Task, public Callback
+      {
+        public:
+          /** Constructor.
+           * @param key The key to reload.
+           */
+          Reload( Key key ) ;
+          
+          /** Method to load the key again, unless it left the manager meanwhile.
+           */
+          void run() override ;
+          
+          /** Method called by the fulfiller once loaded. Replaces the key's data with the reloaded reference.
+           * @param key The key reloaded.
+           * @param reference The reloaded reference. Empty if loading failed, in which case the key keeps its data.
+           */
+          void callback( Key key, mars::Reference<Type> reference ) override ;
+          
+        private:
+          Key key ; ///< The key to reload.
+      };
+      
+      /** A key reloaded when its file changes.
+       */
+      struct Watch
+      {
+        Key      key ; ///< The key to reload.
+        unsigned id  ; ///< The identifier of the file's watch.
+      };
+      
+      /** Static helper method to retrieve the fulfiller to load keys with.
+       * @return The first fulfiller. nullptr if there is none.
+       */
+      static Fulfiller* fulfiller() ;
+      
+      /** Static helper method called by the file watcher when the file of a key changes.
+       * @param watch The Watch of the key.
+       */
+      static void changed( void* watch ) ;
+      
+      /** Static helper method to queue the load of a key on the shared loader, or join the load of the key in flight.
+       * @param key The key to load.
+       * @param waiter The request waiting on the load.
+       * @return The ticket of the request.
+       */
+      static Ticket enqueue( Key key, Waiter* waiter ) ;
+      
+      /** Static helper method to publish a loaded reference into this manager, unless the key already holds an object.
+       * @param key The key of the reference.
+       * @param reference The loaded reference.
+       * @return The reference held by this manager at the key. Empty if the loaded reference is.
+       */
+      static Reference<Type> publish( const Key& key, Reference<Type> reference ) ;
+      
+      /** Static helper method to replace the data of a key with a reloaded reference, unless the key left the manager.
+       * @param key The key of the reference.
+       * @param reference The reloaded reference.
+       */
+      static void replace( const Key& key, Reference<Type> reference ) ;
+      
+      /** The data of a key, along with its place in the order data was last unreferenced in. Watches the data's cell to learn when it is unreferenced.
+       */
+      struct Resident : public Watcher
+      {
+        /** Flags of a resident's state.
+         */
+        enum State : unsigned
+        {
+          Queued  = 1, ///< The resident is in the orphans, waiting for cleanup.
+          Evicted = 2, ///< The data was released. The resident is freed by whoever takes it out of the orphans last.
+        };
+        
+        /** Method called once the data is only referenced by the manager. Queues the resident for cleanup, unless it already is.
+         */
+        void orphaned() override ;
+        
+        /** Method to retrieve a reference to the data, unless it is being released. Lock-free, even while the data is being replaced.
+         * @return A reference to the data if it is still alive. An empty reference otherwise.
+         */
+        Reference<Type> acquire() const ;
+        
+        Key                        key    ; ///< The key of the data.
+        std::atomic<Handle<Type>>  handle ; ///< The handle of the data. The manager holds a reference to it. Swapped when reloaded, with the residency lock held.
+        std::size_t                cost   ; ///< The amount of bytes the data takes up. Guarded by the residency lock once linked.
+        std::atomic<unsigned>      state  ; ///< The State flags of the resident.
+        Resident*                  next   ; ///< The next resident in the orphans.
+        bool                       stale  ; ///< Whether the data was replaced by a reload, so it is released once unreferenced instead of staying resident.
+        bool                       idle   ; ///< Whether the resident is in the least recently unreferenced order. Guarded by the residency lock.
+        Resident*                  hotter ; ///< The next more recently unreferenced data. Guarded by the residency lock.
+        Resident*                  colder ; ///< The next less recently unreferenced data. Guarded by the residency lock.
+      };
+      
+      /** Static helper method to look up a key.
+       * @param key The key to look up.
+       * @return A reference to the data of the key. Empty if missing or being released.
+       */
+      static Reference<Type> lookup( const Key& key ) ;
+      
+      /** Static helper method to create the resident of new data, watching its cell, and hand out a reference to it. Called with the key's shard locked.
+       * @param key The key of the data.
+       * @param cell The cell of the data, holding the manager's reference.
+       * @param ref The reference to hand out.
+       * @return The resident of the data.
+       */
+      static Resident* admit( const Key& key, Cell<Type>* cell, Reference<Type>& ref ) ;
+      
+      /** Static helper method to insert the data of a key, unless the key already holds data.
+       * @param key The key to insert.
+       * @param make The function to create the data with, called as make() with the key's shard locked. Returns a cell holding the manager's reference.
+       * @param warn Whether to forward a library warning if the key already holds data.
+       * @return A reference to the data of the key, inserted or not.
+       */
+      template<typename Make>
+      static Reference<Type> insert( const Key& key, Make make, bool warn ) ;
+      
+      /** Static helper method to move the data unreferenced since the previous cleanup into the least recently unreferenced order. The residency lock must be held.
+       */
+      static void adopt() ;
+      
+      /** Static helper method to place data at the recently unreferenced end. The residency lock must be held.
+       * @param resident The data to place.
+       */
+      static void link( Resident* resident ) ;
+      
+      /** Static helper method to take data out of the least recently unreferenced order. The residency lock must be held.
+       * @param resident The data to take out.
+       */
+      static void unlink( Resident* resident ) ;
+      
+      /** Static helper method to free evicted data's bookkeeping, once no lookup can see it anymore.
+       * @param resident The resident to free.
+       */
+      static void destroy( void* resident ) ;
+      
+      /** Static member to contain this object's data. Holds a reference to every object in it.
+       */
+      static ConcurrentMap<Key, Resident*> map ;
+      
+      /** Static member to contain the data unreferenced since the previous cleanup, most recently unreferenced first. Lock-free, as data is unreferenced from any thread.
+       */
+      static std::atomic<Resident*> orphans ;
+      
+      /** Static member to contain the most recently unreferenced data.
+       */
+      static Resident* hottest ;
+      
+      /** Static member to contain the least recently unreferenced data, the first to be evicted.
+       */
+      static Resident* coldest ;
+      
+      /** Static member to count the bytes of the data of every key.
+       */
+      static std::size_t resident_bytes ;
+      
+      /** Static member to contain the budget of the resident bytes.
+       */
+      static std::size_t budget_bytes ;
+      
+      /** Static member to guard the least recently unreferenced order & budget.
        */
-      static std::unordered_map<Key, Reference<Type>> map ;
+      static std::mutex residency_lock ;
       
       /** Static member to contain fulfillers to fulfill requests.
        */
-      static std::unordered_map<Key, Manager<Key, Type>::Fulfiller*> fullfillers ;
+      static FlatMap<Key, Manager<Key, Type>::Fulfiller*> fullfillers ;
+      
+      /** Static member to guard the fulfillers.
+       */
+      static std::mutex fulfiller_lock ;
+      
+      /** Static member to contain the loads in flight, for requests of the same key to join.
+       */
+      static FlatMap<Key, Manager<Key, Type>::Load*> pending ;
+      
+      /** Static member to guard the loads in flight.
+       */
+      static std::mutex pending_lock ;
+      
+      /** Static member to count the requests made, to identify them by. Guarded by the pending lock.
+       */
+      static std::uint64_t requests ;
+      
+      /** Static member to contain the keys reloaded when their file changes.
+       */
+      static FlatMap<Key, Manager<Key, Type>::Watch*> watches ;
       
-      /** Static member to ensure thread safety.
+      /** Static member to guard the watched keys.
        */
-      static std::mutex map_lock ;
+      static std::mutex watch_lock ;
       
       /** Creation is disallowed.
        */
@@ -212,40 +755,422 @@ namespace mars
       ~Manager() ;
   };
   
+  #if MARS_COROUTINES
+  /** Awaitable load of a key. Lives in the awaiting coroutine's frame, so loading takes no callback allocation.
+   * @note Must be awaited. Destroying a load that was not awaited cancels it, or waits for it to be delivered if it already is.
+   */
+  template<typename Key, typename Type>
+  class [[nodiscard]] Manager<Key, Type>::Loading : public Manager<Key, Type>::Waiter
+  {
+    public:
+      /** Constructor. Starts loading the key, unless it already is in the manager.
+       * @param key The key to load.
+       * @param executor The dispatcher to resume the awaiting coroutine through. nullptr resumes it on the loader thread.
+       * @param priority The priority of the load.
+       */
+      Loading( const Key& key, Dispatcher* executor, int priority ) ;
+      
+      /** Deconstructor. Cancels the load if it was not awaited.
+       */
+      ~Loading() ;
+      
+      /** Copying is disallowed, as the load is waited on by address.
+       */
+      Loading( const Loading& loading ) = delete ;
+      
+      /** Copying is disallowed, as the load is waited on by address.
+       */
+      Loading& operator=( const Loading& loading ) = delete ;
+      
+      /** Method to check whether the load already completed, so the coroutine does not suspend.
+       * @return Whether or not the load completed.
+       */
+      bool await_ready() const noexcept ;
+      
+      /** Method to suspend the awaiting coroutine until the load completes.
+       * @param handle The awaiting coroutine.
+       * @return Whether or not the coroutine stays suspended. False if the load completed meanwhile.
+       */
+      bool await_suspend( std::coroutine_handle<> handle ) noexcept ;
+      
+      /** Method to retrieve the loaded reference once resumed.
+       * @return The loaded reference. Empty if loading failed.
+       */
+      Reference<Type> await_resume() ;
+      
+      /** Method called once loaded, on the loader thread or the executor. Resumes the awaiting coroutine if it is suspended.
+       */
+      void run() override ;
+      
+      /** Method called once cancelled. The load is owned by its coroutine, so nothing is freed.
+       */
+      void discard() override ;
+      
+    private:
+      /** States of a load.
+       */
+      enum State : unsigned
+      {
+        Pending   = 0, ///< The key is loading, and nothing awaits it yet.
+        Suspended = 1, ///< The key is loading, and a coroutine awaits it.
+        Done      = 2, ///< The key is loaded.
+      };
+      
+      std::coroutine_handle<> handle ; ///< The awaiting coroutine.
+      std::atomic<unsigned>   state  ; ///< The state of this load.
+      Ticket                  ticket ; ///< The ticket of this load, to cancel it.
+  };
+  #endif
+  
   template<typename Key, typename Type>
   using Fullfiller = typename Manager<Key, Type>::Fulfiller ;
   
   template<typename Key, typename Type>
-  std::unordered_map<Key, Reference<Type>> Manager<Key, Type>::map ;
+  ConcurrentMap<Key, typename Manager<Key, Type>::Resident*> Manager<Key, Type>::map ;
+  
+  template<typename Key, typename Type>
+  std::atomic<typename Manager<Key, Type>::Resident*> Manager<Key, Type>::orphans = { nullptr } ;
+  
+  template<typename Key, typename Type>
+  typename Manager<Key, Type>::Resident* Manager<Key, Type>::hottest = nullptr ;
+  
+  template<typename Key, typename Type>
+  typename Manager<Key, Type>::Resident* Manager<Key, Type>::coldest = nullptr ;
+  
+  template<typename Key, typename Type>
+  std::size_t Manager<Key, Type>::resident_bytes = 0 ;
+  
+  template<typename Key, typename Type>
+  std::size_t Manager<Key, Type>::budget_bytes = 0 ;
+  
+  template<typename Key, typename Type>
+  std::mutex Manager<Key, Type>::residency_lock ;
+  
+  template<typename Key, typename Type>
+  FlatMap<Key, Fullfiller<Key, Type>*> Manager<Key, Type>::fullfillers ;
+  
+  template<typename Key, typename Type>
+  std::mutex Manager<Key, Type>::fulfiller_lock ;
+  
+  template<typename Key, typename Type>
+  FlatMap<Key, typename Manager<Key, Type>::Load*> Manager<Key, Type>::pending ;
+  
+  template<typename Key, typename Type>
+  std::mutex Manager<Key, Type>::pending_lock ;
+  
+  template<typename Key, typename Type>
+  std::uint64_t Manager<Key, Type>::requests = 0 ;
   
   template<typename Key, typename Type>
-  std::unordered_map<Key, Fullfiller<Key, Type>*> Manager<Key, Type>::fullfillers ;
+  FlatMap<Key, typename Manager<Key, Type>::Watch*> Manager<Key, Type>::watches ;
   
   template<typename Key, typename Type>
-  std::mutex Manager<Key, Type>::map_lock ;
+  std::mutex Manager<Key, Type>::watch_lock ;
   
   template<typename Key, typename Type>
   Reference<Type> Manager<Key, Type>::reference( const Key& key )
   {
     using Manager = Manager<Key, Type> ;
-    Reference<Type> ref ;
-    
-    const auto iter = Manager::map.find( key ) ;
+    Reference<Type> ref = Manager::lookup( key ) ;
     
-    if( iter != Manager::map.end() )
-    {
-      ref = iter->second ;
-      
-      if( !ref ) mars::handleError( __FILE__, __LINE__, mars::Error::InvalidReference ) ;
-    }
-    else
-    {
-      mars::handleError( __FILE__, __LINE__, mars::Error::InvalidReference ) ;
-    }
+    if( !ref ) mars::handleError( __FILE__, __LINE__, mars::Error::InvalidReference ) ;
     
     return ref ;
   }
   
+  template<typename Key, typename Type>
+  std::vector<Reference<Type>> Manager<Key, Type>::referenceMany( const Key* keys, unsigned count )
+  {
+    using Manager = Manager<Key, Type> ;
+    std::vector<Reference<Type>> references( count, Reference<Type>() ) ;
+    unsigned                     found = 0                              ;
+    
+    Manager::map.findMany( keys, count, [ &references, &found ]( unsigned index, Resident* const& resident )
+    {
+      references[ index ] = resident->acquire() ;
+      
+      if( references[ index ] ) found++ ;
+    } ) ;
+    
+    if( found != count ) mars::handleError( __FILE__, __LINE__, mars::Error::InvalidReference ) ;
+    
+    return references ;
+  }
+  
+  template<typename Key, typename Type>
+  std::vector<Reference<Type>> Manager<Key, Type>::referenceMany( const std::vector<Key>& keys )
+  {
+    return Manager<Key, Type>::referenceMany( keys.data(), static_cast<unsigned>( keys.size() ) ) ;
+  }
+  
+  template<typename Key, typename Type>
+  template<typename ... Parameters>
+  std::vector<Reference<Type>> Manager<Key, Type>::getOrCreateMany( const Key* keys, unsigned count, const Parameters&... params )
+  {
+    using Manager = Manager<Key, Type> ;
+    std::vector<Reference<Type>> references( count, Reference<Type>() ) ;
+    std::size_t                  bytes = 0                              ;
+    
+    auto make = [ keys, &references, &bytes, &params... ]( unsigned index )
+    {
+      Cell<Type>* cell = Slab<Type>::global.allocate() ;
+      
+      cell->object()->initialize( params... ) ;
+      
+      Resident* resident = Manager::admit( keys[ index ], cell, references[ index ] ) ;
+      
+      bytes += resident->cost ;
+      
+      return resident ;
+    };
+    
+    // Data is only claimed by cleanup with its shard locked, so existing data always locks here.
+    auto visit = [ &references ]( unsigned index, Resident* const& resident )
+    {
+      if( !references[ index ].m_cell ) references[ index ] = resident->acquire() ;
+    };
+    
+    Manager::map.insertMany( keys, count, make, visit ) ;
+    
+    // Counted once the shards are unlocked, as cleanup locks shards with the residency lock held.
+    if( bytes != 0 )
+    {
+      std::lock_guard<std::mutex> lock( Manager::residency_lock ) ;
+      
+      Manager::resident_bytes += bytes ;
+    }
+    
+    return references ;
+  }
+  
+  template<typename Key, typename Type>
+  template<typename ... Parameters>
+  std::vector<Reference<Type>> Manager<Key, Type>::getOrCreateMany( const std::vector<Key>& keys, const Parameters&... params )
+  {
+    return Manager<Key, Type>::getOrCreateMany( keys.data(), static_cast<unsigned>( keys.size() ), params... ) ;
+  }
+  
+  template<typename Key, typename Type>
+  Handle<Type> Manager<Key, Type>::handle( const Key& key )
+  {
+    using Manager = Manager<Key, Type> ;
+    Epoch::Guard guard              ;
+    Resident*    resident = nullptr ;
+    
+    if( Manager::map.find( key, resident ) ) return resident->handle.load( std::memory_order_acquire ) ;
+    
+    mars::handleError( __FILE__, __LINE__, mars::Error::InvalidReference ) ;
+    return Handle<Type>() ;
+  }
+  
+  template<typename Key, typename Type>
+  Reference<Type> Manager<Key, Type>::lookup( const Key& key )
+  {
+    using Manager = Manager<Key, Type> ;
+    Epoch::Guard    guard              ;
+    Reference<Type> ref                ;
+    Resident*       resident = nullptr ;
+    
+    // Residents are retired through the epoch, so the one found stays readable even if it is evicted meanwhile.
+    if( Manager::map.find( key, resident ) ) ref = resident->acquire() ;
+    
+    return ref ;
+  }
+  
+  template<typename Key, typename Type>
+  typename Manager<Key, Type>::Resident* Manager<Key, Type>::admit( const Key& key, Cell<Type>* cell, Reference<Type>& ref )
+  {
+    Resident* resident = new Resident() ;
+    
+    resident->key    = key                                   ;
+    resident->cost   = ByteSize<Type>::of( *cell->object() ) ;
+    resident->next   = nullptr                               ;
+    resident->idle   = false                                 ;
+    resident->stale  = false                                 ;
+    resident->handle.store( Handle<Type>( cell ), std::memory_order_relaxed ) ;
+    resident->state .store( 0                   , std::memory_order_relaxed ) ;
+    
+    // Watched before the reference leaves, so the data is queued for cleanup once it is let go.
+    cell->reference() ;
+    cell->watch( resident ) ;
+    ref.m_cell = cell ;
+    
+    return resident ;
+  }
+  
+  template<typename Key, typename Type>
+  template<typename Make>
+  Reference<Type> Manager<Key, Type>::insert( const Key& key, Make make, bool warn )
+  {
+    using Manager = Manager<Key, Type> ;
+    Epoch::Guard    guard              ;
+    Reference<Type> ref                ;
+    Resident*       resident = nullptr ;
+    
+    // The data is created with the key's shard locked, so only one of any concurrent inserts of a key succeeds.
+    auto admit = [ &key, &make, &ref ]() { return Manager::admit( key, make(), ref ) ; } ;
+    
+    // An existing object may be cleaned up before it is retained, in which case the key is free again.
+    while( !Manager::map.insert( key, admit, resident ) )
+    {
+      if( warn ) mars::handleError( __FILE__, __LINE__, mars::Error::DoubleReference ) ;
+      
+      ref = resident->acquire() ;
+      
+      if( ref ) return ref ;
+    }
+    
+    // Counted once the shard is unlocked, as cleanup locks shards with the residency lock held.
+    std::lock_guard<std::mutex> lock( Manager::residency_lock ) ;
+    
+    Manager::resident_bytes += resident->cost ;
+    
+    return ref ;
+  }
+  
+  template<typename Key, typename Type>
+  void Manager<Key, Type>::Resident::orphaned()
+  {
+    using Manager = Manager<Key, Type> ;
+    
+    // Queued at most once between cleanups, and never once released, as the resident is on its way to be freed.
+    if( this->state.fetch_or( State::Queued, std::memory_order_acq_rel ) != 0 ) return ;
+    
+    this->next = Manager::orphans.load( std::memory_order_relaxed ) ;
+    
+    while( !Manager::orphans.compare_exchange_weak( this->next, this, std::memory_order_release, std::memory_order_relaxed ) ) ;
+  }
+  
+  template<typename Key, typename Type>
+  Reference<Type> Manager<Key, Type>::Resident::acquire() const
+  {
+    Handle<Type> handle = this->handle.load( std::memory_order_acquire ) ;
+    
+    // A reload may release the data between loading its handle & locking it, in which case the reloaded data is locked instead.
+    while( true )
+    {
+      Reference<Type>    ref     = WeakReference<Type>( handle ).lock()              ;
+      const Handle<Type> current = this->handle.load( std::memory_order_acquire ) ;
+      
+      if( ref || current == handle ) return ref ;
+      
+      handle = current ;
+    }
+  }
+  
+  template<typename Key, typename Type>
+  void Manager<Key, Type>::adopt()
+  {
+    using Manager = Manager<Key, Type> ;
+    Resident* orphan  = Manager::orphans.exchange( nullptr, std::memory_order_acquire ) ;
+    Resident* ordered = nullptr                                                          ;
+    
+    // Reversed, so the data unreferenced first is placed first.
+    while( orphan )
+    {
+      Resident* next = orphan->next ;
+      
+      orphan->next = ordered ;
+      ordered      = orphan  ;
+      orphan       = next    ;
+    }
+    
+    while( ordered )
+    {
+      Resident* resident = ordered ;
+      
+      // Read before the resident is dequeued, as it may be queued again straight after.
+      ordered = resident->next ;
+      
+      if( resident->state.fetch_and( ~unsigned( Resident::Queued ), std::memory_order_acq_rel ) & Resident::Evicted )
+      {
+        Epoch::retire( resident, &Manager::destroy ) ;
+        continue ;
+      }
+      
+      // Replaced data is released as soon as it is let go, outside of the budget. Referenced again, it is queued again once let go.
+      if( resident->stale )
+      {
+        Cell<Type>* cell = resident->handle.load( std::memory_order_relaxed ).cell() ;
+        
+        if( cell->claim() )
+        {
+          cell->watch( nullptr ) ;
+          cell->object()->reset() ;
+          Slab<Type>::global.release( cell ) ;
+          
+          if( !( resident->state.fetch_or( Resident::Evicted, std::memory_order_acq_rel ) & Resident::Queued ) ) Epoch::retire( resident, &Manager::destroy ) ;
+        }
+        
+        continue ;
+      }
+      
+      if( resident->idle ) Manager::unlink( resident ) ;
+      
+      // Data referenced again is queued again once let go.
+      if( resident->handle.load( std::memory_order_relaxed ).cell()->count() == 1 ) Manager::link( resident ) ;
+    }
+  }
+  
+  template<typename Key, typename Type>
+  void Manager<Key, Type>::link( Resident* resident )
+  {
+    using Manager = Manager<Key, Type> ;
+    
+    resident->idle   = true    ;
+    resident->hotter = nullptr ;
+    resident->colder = Manager::hottest ;
+    
+    if( Manager::hottest ) Manager::hottest->hotter = resident ;
+    else                   Manager::coldest         = resident ;
+    
+    Manager::hottest = resident ;
+  }
+  
+  template<typename Key, typename Type>
+  void Manager<Key, Type>::unlink( Resident* resident )
+  {
+    using Manager = Manager<Key, Type> ;
+    
+    resident->idle = false ;
+    
+    if( resident->hotter ) resident->hotter->colder = resident->colder ;
+    else                   Manager::hottest         = resident->colder ;
+    
+    if( resident->colder ) resident->colder->hotter = resident->hotter ;
+    else                   Manager::coldest         = resident->hotter ;
+  }
+  
+  template<typename Key, typename Type>
+  void Manager<Key, Type>::destroy( void* resident )
+  {
+    delete static_cast<Resident*>( resident ) ;
+  }
+  
+  template<typename Key, typename Type>
+  void Manager<Key, Type>::setBudget( std::size_t bytes )
+  {
+    std::lock_guard<std::mutex> lock( Manager<Key, Type>::residency_lock ) ;
+    
+    Manager<Key, Type>::budget_bytes = bytes ;
+  }
+  
+  template<typename Key, typename Type>
+  std::size_t Manager<Key, Type>::budget()
+  {
+    std::lock_guard<std::mutex> lock( Manager<Key, Type>::residency_lock ) ;
+    
+    return Manager<Key, Type>::budget_bytes ;
+  }
+  
+  template<typename Key, typename Type>
+  std::size_t Manager<Key, Type>::residentBytes()
+  {
+    std::lock_guard<std::mutex> lock( Manager<Key, Type>::residency_lock ) ;
+    
+    return Manager<Key, Type>::resident_bytes ;
+  }
+  
   template<typename Key, typename Type>
   template<typename Object>
   Manager<Key, Type>::MethodCallback<Object>::MethodCallback( Object* obj, MCallback cb )
@@ -303,28 +1228,342 @@ namespace mars
   }
 
   template<typename Key, typename Type>
-  template<typename Object>
-  void Manager<Key, Type>::request( Object* object, void (Object::*callback)( Key, mars::Reference<Type> ), Key key )
+  Manager<Key, Type>::Ticket::Ticket() : key(), id( 0 )
+  {
+  }
+  
+  template<typename Key, typename Type>
+  Manager<Key, Type>::Ticket::Ticket( Key key, std::uint64_t id ) : key( key ), id( id )
+  {
+  }
+  
+  template<typename Key, typename Type>
+  bool Manager<Key, Type>::Ticket::prioritize( int priority ) const
+  {
+    using Manager = Manager<Key, Type> ;
+    std::lock_guard<std::mutex> lock( Manager::pending_lock ) ;
+    
+    auto iter = Manager::pending.find( this->key ) ;
+    
+    return this->id != 0 && iter != Manager::pending.end() && iter->second->prioritize( this->id, priority ) ;
+  }
+  
+  template<typename Key, typename Type>
+  bool Manager<Key, Type>::Ticket::cancel() const
+  {
+    using Manager = Manager<Key, Type> ;
+    std::lock_guard<std::mutex> lock( Manager::pending_lock ) ;
+    
+    auto iter = Manager::pending.find( this->key ) ;
+    
+    return this->id != 0 && iter != Manager::pending.end() && iter->second->cancel( this->id ) ;
+  }
+  
+  template<typename Key, typename Type>
+  Manager<Key, Type>::Waiter::Waiter( Key key, Dispatcher* dispatcher, int priority ) : key( key ), dispatcher( dispatcher ), sibling( nullptr ), priority( priority ), id( 0 )
+  {
+  }
+  
+  template<typename Key, typename Type>
+  void Manager<Key, Type>::Waiter::complete( Reference<Type> reference )
+  {
+    this->result = reference ;
+    
+    if( this->dispatcher ) this->dispatcher->post( this ) ;
+    else                   this->run() ;
+  }
+  
+  template<typename Key, typename Type>
+  void Manager<Key, Type>::Waiter::discard()
   {
-    using FCallback = Manager<Key, Type>::MethodCallback<Object> ;
-    if( !Manager<Key, Type>::fullfillers.empty() )
+    delete this ;
+  }
+  
+  template<typename Key, typename Type>
+  template<typename Delivery>
+  Manager<Key, Type>::Request<Delivery>::Request( Key key, Dispatcher* dispatcher, int priority, Delivery delivery ) : Waiter( key, dispatcher, priority ), delivery( delivery )
+  {
+  }
+  
+  template<typename Key, typename Type>
+  template<typename Delivery>
+  void Manager<Key, Type>::Request<Delivery>::run()
+  {
+    this->delivery.callback( this->key, this->result ) ;
+    
+    delete this ;
+  }
+  
+  template<typename Key, typename Type>
+  Manager<Key, Type>::Load::Load( Key key, Waiter* waiter ) : key( key ), first( waiter ), last( waiter )
+  {
+  }
+  
+  template<typename Key, typename Type>
+  void Manager<Key, Type>::Load::join( Waiter* waiter )
+  {
+    if( this->last ) this->last->sibling = waiter ;
+    else             this->first         = waiter ;
+    
+    this->last = waiter ;
+  }
+  
+  template<typename Key, typename Type>
+  bool Manager<Key, Type>::Load::prioritize( std::uint64_t id, int priority )
+  {
+    for( Waiter* waiter = this->first; waiter; waiter = waiter->sibling )
     {
-      FCallback* cb = new FCallback( object, callback ) ;
+      if( waiter->id == id )
+      {
+        waiter->priority = priority ;
+        Loader::global().prioritize( this, this->priority() ) ;
+        
+        return true ;
+      }
+    }
+    
+    return false ;
+  }
+  
+  template<typename Key, typename Type>
+  bool Manager<Key, Type>::Load::cancel( std::uint64_t id )
+  {
+    using Manager = Manager<Key, Type> ;
+    Waiter* previous = nullptr ;
+    
+    for( Waiter* waiter = this->first; waiter; previous = waiter, waiter = waiter->sibling )
+    {
+      if( waiter->id != id ) continue ;
+      
+      if( previous ) previous->sibling = waiter->sibling ;
+      else           this->first       = waiter->sibling ;
+      
+      if( this->last == waiter ) this->last = previous ;
+      
+      waiter->discard() ;
+      
+      // A load that started keeps running, and publishes its key for later requests.
+      if( !this->first && Loader::global().cancel( this ) )
+      {
+        Manager::pending.erase( this->key ) ;
+        delete this ;
+      }
+      else if( this->first )
+      {
+        Loader::global().prioritize( this, this->priority() ) ;
+      }
+      
+      return true ;
+    }
+    
+    return false ;
+  }
+  
+  template<typename Key, typename Type>
+  int Manager<Key, Type>::Load::priority() const
+  {
+    int priority = this->first ? this->first->priority : 0 ;
+    
+    for( Waiter* waiter = this->first; waiter; waiter = waiter->sibling ) if( waiter->priority > priority ) priority = waiter->priority ;
+    
+    return priority ;
+  }
+  
+  template<typename Key, typename Type>
+  void Manager<Key, Type>::Load::run()
+  {
+    using Manager = Manager<Key, Type> ;
+    Reference<Type> ref = Manager::lookup( this->key ) ;
+    
+    if( ref )
+    {
+      this->callback( this->key, ref ) ;
+      return ;
+    }
+    
+    Fulfiller* fulfiller = Manager::fulfiller() ;
+    
+    // The fulfiller may call back straight away, freeing this load, so nothing touches it afterwards.
+    if( fulfiller ) fulfiller->fulfill( this->key, this ) ;
+    else            this->callback( this->key, Reference<Type>() ) ;
+  }
+  
+  template<typename Key, typename Type>
+  void Manager<Key, Type>::Load::callback( Key key, mars::Reference<Type> reference )
+  {
+    using Manager = Manager<Key, Type> ;
+    
+    // Published before the load stops accepting requests, so requests arriving later find the key loaded instead of loading it again.
+    Reference<Type> published = Manager::publish( key, reference ) ;
+    Waiter*         waiter    = nullptr                             ;
+    
+    {
+      std::lock_guard<std::mutex> lock( Manager::pending_lock ) ;
       
-      Manager<Key, Type>::fullfillers.begin()->second->fulfill( key, cb ) ;
+      Manager::pending.erase( this->key ) ;
+      waiter = this->first ;
+    }
+    
+    while( waiter )
+    {
+      // Completing may free the request, so its sibling is read first.
+      Waiter* sibling = waiter->sibling ;
+      
+      waiter->complete( published ) ;
+      waiter = sibling ;
+    }
+    
+    delete this ;
+  }
+  
+  template<typename Key, typename Type>
+  Manager<Key, Type>::Reload::Reload( Key key ) : key( key )
+  {
+  }
+  
+  template<typename Key, typename Type>
+  void Manager<Key, Type>::Reload::run()
+  {
+    using Manager = Manager<Key, Type> ;
+    Fulfiller* fulfiller = Manager::has( this->key ) ? Manager::fulfiller() : nullptr ;
+    
+    // The fulfiller may call back straight away, freeing this reload, so nothing touches it afterwards.
+    if( fulfiller ) fulfiller->fulfill( this->key, this ) ;
+    else            delete this ;
+  }
+  
+  template<typename Key, typename Type>
+  void Manager<Key, Type>::Reload::callback( Key key, mars::Reference<Type> reference )
+  {
+    if( reference ) Manager<Key, Type>::replace( key, reference ) ;
+    
+    delete this ;
+  }
+  
+  template<typename Key, typename Type>
+  typename Manager<Key, Type>::Fulfiller* Manager<Key, Type>::fulfiller()
+  {
+    std::lock_guard<std::mutex> lock( Manager<Key, Type>::fulfiller_lock ) ;
+    
+    return Manager<Key, Type>::fullfillers.empty() ? nullptr : Manager<Key, Type>::fullfillers.begin()->second ;
+  }
+  
+  template<typename Key, typename Type>
+  void Manager<Key, Type>::changed( void* watch )
+  {
+    Manager<Key, Type>::reload( static_cast<Watch*>( watch )->key ) ;
+  }
+  
+  template<typename Key, typename Type>
+  void Manager<Key, Type>::replace( const Key& key, Reference<Type> reference )
+  {
+    using Manager = Manager<Key, Type> ;
+    Epoch::Guard                guard                           ;
+    Resident*                   resident = nullptr              ;
+    Cell<Type>*                 cell     = reference.m_cell     ;
+    std::lock_guard<std::mutex> lock( Manager::residency_lock ) ;
+    
+    // Cleanup only evicts with the residency lock held, so the resident found stays in the manager until the swap is done.
+    if( !Manager::map.find( key, resident ) ) return ;
+    
+    Cell<Type>* previous = resident->handle.load( std::memory_order_relaxed ).cell() ;
+    
+    if( cell == previous ) return ;
+    
+    const std::size_t cost = ByteSize<Type>::of( *cell->object() ) ;
+    const std::size_t old  = resident->cost                        ;
+    
+    cell->reference() ;
+    cell->watch( resident ) ;
+    
+    // Lookups retrieve either the previous or the reloaded data, and never wait, see Resident::acquire.
+    resident->handle.store( Handle<Type>( cell ), std::memory_order_release ) ;
+    
+    Manager::resident_bytes += cost ;
+    Manager::resident_bytes -= old  ;
+    resident->cost = cost ;
+    
+    if( previous->claim() )
+    {
+      previous->watch( nullptr ) ;
+      previous->object()->reset() ;
+      Slab<Type>::global.release( previous ) ;
+      return ;
     }
+    
+    // The previous data stays alive for as long as it is referenced. A stale resident takes over watching it, so cleanup resets & releases it once let go.
+    Resident* stale = new Resident() ;
+    
+    stale->key    = key     ;
+    stale->cost   = old     ;
+    stale->next   = nullptr ;
+    stale->idle   = false   ;
+    stale->stale  = true    ;
+    stale->handle.store( Handle<Type>( previous ), std::memory_order_relaxed ) ;
+    stale->state .store( 0                       , std::memory_order_relaxed ) ;
+    
+    previous->watch( stale ) ;
+    
+    // Queued straight away, as the last holder may have let go before the stale resident watched the data.
+    stale->orphaned() ;
   }
   
   template<typename Key, typename Type>
-  void Manager<Key, Type>::request( void (*callback)( Key, mars::Reference<Type> ), Key key )
+  typename Manager<Key, Type>::Ticket Manager<Key, Type>::enqueue( Key key, Waiter* waiter )
   {
-    using FCallback = Manager<Key, Type>::FunctionCallback ;
-    if( !Manager<Key, Type>::fullfillers.empty() )
+    using Manager = Manager<Key, Type> ;
+    std::lock_guard<std::mutex> lock( Manager::pending_lock ) ;
+    
+    auto iter = Manager::pending.find( key ) ;
+    
+    waiter->id = ++Manager::requests ;
+    
+    if( iter != Manager::pending.end() )
+    {
+      iter->second->join( waiter ) ;
+      Loader::global().prioritize( iter->second, iter->second->priority() ) ;
+    }
+    else
     {
-      FCallback* cb = new FCallback( callback ) ;
+      // Submitted with the pending loads locked, so a cancel never sees a load that is not queued yet.
+      Load* load = new Load( key, waiter ) ;
       
-      Manager<Key, Type>::fullfillers.begin()->second->fulfill( key, cb ) ;
+      Manager::pending.insert( key, load ) ;
+      Loader::global().submit( load, waiter->priority ) ;
     }
+    
+    return Ticket( key, waiter->id ) ;
+  }
+  
+  template<typename Key, typename Type>
+  Reference<Type> Manager<Key, Type>::publish( const Key& key, Reference<Type> reference )
+  {
+    if( !reference ) return reference ;
+    
+    // Fulfillers creating through this manager already published their object, which is found here instead.
+    return Manager<Key, Type>::insert( key, [ &reference ]()
+    {
+      reference.m_cell->reference() ;
+      
+      return reference.m_cell ;
+    }, false ) ;
+  }
+  
+  template<typename Key, typename Type>
+  template<typename Object>
+  typename Manager<Key, Type>::Ticket Manager<Key, Type>::request( Object* object, void (Object::*callback)( Key, mars::Reference<Type> ), Key key, Dispatcher* dispatcher, int priority )
+  {
+    using Delivery = Manager<Key, Type>::MethodCallback<Object> ;
+    
+    return Manager<Key, Type>::enqueue( key, new Request<Delivery>( key, dispatcher, priority, Delivery( object, callback ) ) ) ;
+  }
+  
+  template<typename Key, typename Type>
+  typename Manager<Key, Type>::Ticket Manager<Key, Type>::request( void (*callback)( Key, mars::Reference<Type> ), Key key, Dispatcher* dispatcher, int priority )
+  {
+    using Delivery = Manager<Key, Type>::FunctionCallback ;
+    
+    return Manager<Key, Type>::enqueue( key, new Request<Delivery>( key, dispatcher, priority, Delivery( callback ) ) ) ;
   }
   
   template<typename Key, typename Type>
@@ -332,6 +1571,8 @@ namespace mars
   void Manager<Key, Type>::addFulfiller( Object* object, void (Object::*callback)( Key, Callback* ), Key key )
   {
     Manager<Key, Type>::Fulfiller* fullfiller = new Manager<Key, Type>::MethodFulfiller<Object>( object, callback ) ;
+    std::lock_guard<std::mutex> lock( Manager<Key, Type>::fulfiller_lock ) ;
+    
     auto iter = Manager<Key, Type>::fullfillers.find( key ) ;
     if( iter != Manager<Key, Type>::fullfillers.end() )
     {
@@ -345,6 +1586,8 @@ namespace mars
   void Manager<Key, Type>::addFulfiller( void (*callback)( Key, Callback* ), Key key )
   {
     Manager<Key, Type>::Fulfiller* fullfiller = new Manager<Key, Type>::FunctionFulfiller( callback ) ;
+    std::lock_guard<std::mutex> lock( Manager<Key, Type>::fulfiller_lock ) ;
+    
     auto iter = Manager<Key, Type>::fullfillers.find( key ) ;
     if( iter != Manager<Key, Type>::fullfillers.end() )
     {
@@ -357,6 +1600,8 @@ namespace mars
   template<typename Key, typename Type>
   void Manager<Key, Type>::removeFulfiller( Key key )
   {
+    std::lock_guard<std::mutex> lock( Manager<Key, Type>::fulfiller_lock ) ;
+    
     auto iter = Manager<Key, Type>::fullfillers.find( key ) ;
     if( iter != Manager<Key, Type>::fullfillers.end() )
     {
@@ -366,58 +1611,188 @@ namespace mars
   }
   
   template<typename Key, typename Type>
-  bool Manager<Key, Type>::has( const Key& key )
+  void Manager<Key, Type>::reload( const Key& key, int priority )
+  {
+    Loader::global().submit( new Reload( key ), priority ) ;
+  }
+  
+  template<typename Key, typename Type>
+  void Manager<Key, Type>::watch( const Key& key, const std::string& path )
   {
     using Manager = Manager<Key, Type> ;
-    Reference<Type> ref ;
     
-    const auto iter = Manager::map.find( key ) ;
+    Manager::unwatch( key ) ;
     
-    if( iter != Manager::map.end() )
-    {
-      return true ;
-    }
-    else
+    // The loader is created first, so it outlives the watcher submitting reloads to it.
+    Loader::global() ;
+    
+    Watch*                      watch = new Watch{ key, 0 }                  ;
+    std::lock_guard<std::mutex> lock( Manager::watch_lock )                  ;
+    
+    watch->id = FileWatcher::global().watch( path, &Manager::changed, watch ) ;
+    Manager::watches[ key ] = watch ;
+  }
+  
+  template<typename Key, typename Type>
+  void Manager<Key, Type>::unwatch( const Key& key )
+  {
+    using Manager = Manager<Key, Type> ;
+    std::lock_guard<std::mutex> lock( Manager::watch_lock ) ;
+    
+    auto iter = Manager::watches.find( key ) ;
+    
+    if( iter != Manager::watches.end() )
     {
-      return false ;
+      // The watcher never calls back once unwatched, so the watch can be freed.
+      FileWatcher::global().unwatch( iter->second->id ) ;
+      delete iter->second ;
+      Manager::watches.erase( iter ) ;
     }
   }
   
   template<typename Key, typename Type>
-  template<typename ... Parameters>
-  Reference<Type> Manager<Key, Type>::create( const Key& key, Parameters ... params )
+  bool Manager<Key, Type>::has( const Key& key )
   {
     using Manager = Manager<Key, Type> ;
-    const auto iter = Manager::map.find( key ) ;
-    Reference<Type> ref ;
     
-    if( iter != Manager::map.end() )
+    return Manager::map.contains( key ) ;
+  }
+  
+  template<typename Key, typename Type>
+  template<typename ... Parameters>
+  Reference<Type> Manager<Key, Type>::create( const Key& key, Parameters&&... params )
+  {
+    return Manager<Key, Type>::insert( key, [ &params... ]()
     {
-      mars::handleError( __FILE__, __LINE__, mars::Error::DoubleReference ) ;
-      ref = iter->second ;
-    }
-    else
+      Cell<Type>* cell = Slab<Type>::global.allocate() ;
+      
+      cell->object()->initialize( std::forward<Parameters>( params )... ) ;
+      
+      return cell ;
+    }, true ) ;
+  }
+  
+  template<typename Key, typename Type>
+  template<typename ... Parameters>
+  Reference<Type> Manager<Key, Type>::emplace( const Key& key, Parameters&&... params )
+  {
+    return Manager<Key, Type>::insert( key, [ &params... ]()
     {
-      ref.m_ptr = std::make_shared<Type>() ;
-      ref.m_ptr->initialize( params... ) ;
-      Manager::map.insert( iter, { key, ref } ) ;
-    }
-
+      return Slab<Type>::global.allocate( std::forward<Parameters>( params )... ) ;
+    }, true ) ;
+  }
+  
+  template<typename Key, typename Type>
+  template<typename ... Parameters>
+  Reference<Type> Manager<Key, Type>::make( Parameters&&... params )
+  {
+    Reference<Type> ref                                ;
+    Cell<Type>*     cell = Slab<Type>::global.allocate() ;
+    
+    cell->object()->initialize( std::forward<Parameters>( params )... ) ;
+    ref.m_cell = cell ;
+    
     return ref ;
   }
   
+  #if MARS_COROUTINES
+  template<typename Key, typename Type>
+  typename Manager<Key, Type>::Loading Manager<Key, Type>::load( const Key& key, Dispatcher* executor, int priority )
+  {
+    return Loading( key, executor, priority ) ;
+  }
+  
+  template<typename Key, typename Type>
+  Manager<Key, Type>::Loading::Loading( const Key& key, Dispatcher* executor, int priority ) : Waiter( key, executor, priority ), handle(), state( State::Pending )
+  {
+    using Manager = Manager<Key, Type> ;
+    
+    this->result = Manager::lookup( key ) ;
+    
+    if( this->result ) this->state.store( State::Done, std::memory_order_relaxed ) ;
+    else               this->ticket = Manager::enqueue( key, this ) ;
+  }
+  
+  template<typename Key, typename Type>
+  Manager<Key, Type>::Loading::~Loading()
+  {
+    if( this->state.load( std::memory_order_acquire ) == State::Done || this->ticket.cancel() ) return ;
+    
+    // Already being delivered, e.g. by a loader thread, which still references this load.
+    while( this->state.load( std::memory_order_acquire ) != State::Done ) std::this_thread::yield() ;
+  }
+  
+  template<typename Key, typename Type>
+  bool Manager<Key, Type>::Loading::await_ready() const noexcept
+  {
+    return this->state.load( std::memory_order_acquire ) == State::Done ;
+  }
+  
+  template<typename Key, typename Type>
+  bool Manager<Key, Type>::Loading::await_suspend( std::coroutine_handle<> handle ) noexcept
+  {
+    unsigned expected = State::Pending ;
+    
+    this->handle = handle ;
+    
+    // Fails if the load completed since await_ready, in which case the coroutine continues straight away.
+    return this->state.compare_exchange_strong( expected, State::Suspended, std::memory_order_acq_rel ) ;
+  }
+  
+  template<typename Key, typename Type>
+  Reference<Type> Manager<Key, Type>::Loading::await_resume()
+  {
+    return this->result ;
+  }
+  
+  template<typename Key, typename Type>
+  void Manager<Key, Type>::Loading::run()
+  {
+    // The resumed coroutine may destroy this load, so nothing touches it afterwards.
+    if( this->state.exchange( State::Done, std::memory_order_acq_rel ) == State::Suspended ) this->handle.resume() ;
+  }
+  
+  template<typename Key, typename Type>
+  void Manager<Key, Type>::Loading::discard()
+  {
+  }
+  #endif
+  
   template<typename Key, typename Type>
   void Manager<Key, Type>::cleanup()
   {
     using Manager = Manager<Key, Type> ;
     
-    for( auto entry = Manager::map.begin(); entry != Manager::map.end(); ++entry )
     {
-      if( entry->second.count() <= 1 )
+      std::lock_guard<std::mutex> lock( Manager::residency_lock ) ;
+      
+      Manager::adopt() ;
+      
+      // Walks from the least recently unreferenced end, so only the data released or referenced again since is visited.
+      while( Manager::resident_bytes > Manager::budget_bytes && Manager::coldest )
       {
-        entry->second->reset() ;
-        Manager::map.erase( entry ) ;
+        Resident*   resident = Manager::coldest        ;
+        Cell<Type>* cell     = resident->handle.load( std::memory_order_relaxed ).cell() ;
+        
+        // Claiming fails if anyone, including a racing lookup or weak reference, still holds a reference.
+        auto claim = [ resident, cell ]( const Key&, Resident* const& entry ) { return entry == resident && cell->claim() ; } ;
+        
+        Manager::unlink( resident ) ;
+        
+        if( cell->count() == 1 && Manager::map.eraseIf( resident->key, claim ) )
+        {
+          cell->watch( nullptr ) ;
+          cell->object()->reset() ;
+          Slab<Type>::global.release( cell ) ;
+          
+          Manager::resident_bytes -= resident->cost ;
+          
+          // A resident queued right before being claimed is freed by the next cleanup taking it out of the orphans instead.
+          if( !( resident->state.fetch_or( Resident::Evicted, std::memory_order_acq_rel ) & Resident::Queued ) ) Epoch::retire( resident, &Manager::destroy ) ;
+        }
       }
     }
+    
+    Epoch::collect() ;
   }
 }
@@ -26,6 +26,16 @@
 #include "Manager.h"
 #include <iostream>
 
+#if defined( __unix__ ) || defined( __APPLE__ )
+  #include <sys/mman.h>
+  #include <unistd.h>
+#elif defined( _WIN32 )
+  #include <windows.h>
+#else
+  #include <new>
+  #include <cstring>
+#endif
+
 namespace mars
 {
   #if defined ( __unix__ ) || defined( _WIN32 )
@@ -44,6 +54,10 @@ namespace mars
     constexpr const char* COLOR_WHITE  = "" ;
   #endif
 
+  /** The size of a huge page. Allocations at least this large are rounded up to a multiple of it.
+   */
+  constexpr std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024 ;
+
   /** The structure to contain all of the global nyx library data.
    */
   struct NyxData
@@ -155,6 +169,9 @@ namespace mars
       case mars::Error::InvalidReference : return "An invalid reference was requested."                   ;
       case mars::Error::DoubleReference  : return "An reference was requested to be created twice."       ;
       case mars::Error::InvalidAccess    : return "An invalid access of a reference/data object occured." ;
+      case mars::Error::OutOfMemory      : return "The operating system could not provide more memory."    ;
+      case mars::Error::KeyCollision     : return "Two different asset paths hashed to the same key."      ;
+      case mars::Error::LiveRelease      : return "A pool was released while objects of it were still alive." ;
       default : return "Unknown Error" ;
     }
   }
@@ -166,10 +183,17 @@ namespace mars
       case mars::Error::DoubleReference  : return mars::Severity::Warning ;
       case mars::Error::InvalidReference : return mars::Severity::Fatal   ;
       case mars::Error::InvalidAccess    : return mars::Severity::Fatal   ;
+      case mars::Error::OutOfMemory      : return mars::Severity::Fatal   ;
+      case mars::Error::KeyCollision     : return mars::Severity::Warning ;
+      case mars::Error::LiveRelease      : return mars::Severity::Fatal   ;
       default : return mars::Severity::Fatal ;
     }
   }
 
+  mars::ErrorHandler::~ErrorHandler()
+  {
+  }
+
   void handleError(  const char* file, unsigned line, mars::Error error )
   {
     if( error != mars::Error::Success )
@@ -185,13 +209,86 @@ namespace mars
       }
     }
   }
-  void setErrorHandler( void ( *error_handler )( const char*, unsigned, mars::Error ) )
+  mars::ErrorCallback setErrorHandler( mars::ErrorCallback error_handler )
   {
+    mars::ErrorCallback previous = data.error_cb ;
+    
     data.error_cb = error_handler ;
+    return previous ;
   }
   
-  void setErrorHandler( mars::ErrorHandler* handler )
+  mars::ErrorHandler* setErrorHandler( mars::ErrorHandler* handler )
   {
+    mars::ErrorHandler* previous = data.handler ;
+    
     data.handler = handler ;
+    return previous ;
+  }
+  
+  /** Helper function to round an allocation up to the size the operating system will hand out.
+   * @param size The requested size.
+   * @return The size that is actually allocated.
+   */
+  static std::size_t pageSize( std::size_t size )
+  {
+    #if defined( __unix__ ) || defined( __APPLE__ )
+      const std::size_t page = static_cast<std::size_t>( sysconf( _SC_PAGESIZE ) ) ;
+    #else
+      const std::size_t page = 4096 ;
+    #endif
+    const std::size_t granularity = size >= mars::HUGE_PAGE_SIZE ? mars::HUGE_PAGE_SIZE : page ;
+    
+    return ( size + granularity - 1 ) / granularity * granularity ;
+  }
+  
+  void* allocatePages( std::size_t size )
+  {
+    const std::size_t amount = mars::pageSize( size ) ;
+    void*             memory = nullptr ;
+    
+    #if defined( __unix__ ) || defined( __APPLE__ )
+      #if defined( MAP_HUGETLB )
+        if( amount >= mars::HUGE_PAGE_SIZE )
+        {
+          memory = mmap( nullptr, amount, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 ) ;
+          if( memory == MAP_FAILED ) memory = nullptr ;
+        }
+      #endif
+      
+      if( memory == nullptr )
+      {
+        memory = mmap( nullptr, amount, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 ) ;
+        if( memory == MAP_FAILED ) memory = nullptr ;
+        
+        #if defined( MADV_HUGEPAGE )
+          // No reserved huge pages, so ask for transparent ones instead.
+          if( memory != nullptr && amount >= mars::HUGE_PAGE_SIZE ) madvise( memory, amount, MADV_HUGEPAGE ) ;
+        #endif
+      }
+    #elif defined( _WIN32 )
+      memory = VirtualAlloc( nullptr, amount, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE ) ;
+    #else
+      memory = ::operator new( amount, std::align_val_t( 4096 ), std::nothrow ) ;
+      if( memory != nullptr ) std::memset( memory, 0, amount ) ;
+    #endif
+    
+    if( memory == nullptr ) mars::handleError( __FILE__, __LINE__, mars::Error::OutOfMemory ) ;
+    
+    return memory ;
+  }
+  
+  void releasePages( void* memory, std::size_t size )
+  {
+    if( memory == nullptr ) return ;
+    
+    #if defined( __unix__ ) || defined( __APPLE__ )
+      munmap( memory, mars::pageSize( size ) ) ;
+    #elif defined( _WIN32 )
+      static_cast<void>( size ) ;
+      VirtualFree( memory, 0, MEM_RELEASE ) ;
+    #else
+      static_cast<void>( size ) ;
+      ::operator delete( memory, std::align_val_t( 4096 ) ) ;
+    #endif
   }
 }
@@ -24,6 +24,37 @@
 
 #pragma once
 
+#include <cassert>
+#include <cstddef>
+
+/** Whether accesses through Data & Handle are checked. Checked accesses forward a library error and return a dummy object on invalid access.
+ * Unchecked accesses compile down to a raw dereference guarded only by MARS_ASSERT. Defaults to checked, unless NDEBUG is defined.
+ * @note Must be defined the same for every translation unit of a program.
+ */
+#ifndef MARS_CHECKED_ACCESS
+  #ifdef NDEBUG
+    #define MARS_CHECKED_ACCESS 0
+  #else
+    #define MARS_CHECKED_ACCESS 1
+  #endif
+#endif
+
+/** Hook called with the validity of every unchecked access. Defaults to assert. Define it before including the library to use a custom assertion.
+ */
+#ifndef MARS_ASSERT
+  #define MARS_ASSERT( condition ) assert( condition )
+#endif
+
+/** Defined when building with thread sanitizer. It can not model standalone fences or vector loads of atomics, so lock-free code swaps them for plain atomic operations.
+ */
+#if defined( __SANITIZE_THREAD__ )
+  #define MARS_THREAD_SANITIZER 1
+#elif defined( __has_feature )
+  #if __has_feature( thread_sanitizer )
+    #define MARS_THREAD_SANITIZER 1
+  #endif
+#endif
+
 namespace mars
 {
   /** Reflective enumeration for a library error severity.
@@ -93,6 +124,9 @@ namespace mars
         InvalidReference, ///< There was a request for an invalid reference.
         InvalidAccess,    ///< There was an invalid access of a reference/data object.
         DoubleReference,  ///< There was a request to create a reference that already exists.
+        OutOfMemory,      ///< The operating system could not provide more memory.
+        KeyCollision,     ///< Two different asset paths hashed to the same key.
+        LiveRelease,      ///< A pool was released while objects of it were still alive.
       };
 
       /** Default constructor.
@@ -153,19 +187,50 @@ namespace mars
       virtual ~ErrorHandler() ;
   };
   
+  /** Type of a function handling library errors.
+   */
+  typedef void ( *ErrorCallback )( const char*, unsigned, mars::Error ) ;
+
   /** Static function to allow a custom error handler to be set for this library.
    * @param error_handler The error handler to be used by this library.
+   * @return The error handler used before, so that it can be restored.
    */
-  void setErrorHandler( void ( *error_handler )( const char*, unsigned, mars::Error ) ) ;
+  mars::ErrorCallback setErrorHandler( mars::ErrorCallback error_handler ) ;
 
   /** Static function to allow a custom error handler to be set for this library.
    * @param handler The error handler to be used by this library.
+   * @return The error handler object used before, so that it can be restored.
    */
-  void setErrorHandler( mars::ErrorHandler* handler ) ;
+  mars::ErrorHandler* setErrorHandler( mars::ErrorHandler* handler ) ;
   
   /** Static function to handle a library error.
    * @param error
    */
   void handleError( const char* file, unsigned line, mars::Error error ) ;
+  
+  /** Static function to allocate page-aligned memory directly from the operating system.
+   * Allocations of at least a huge page are backed by huge pages where the system supports them.
+   * @param size The amount of bytes to allocate.
+   * @return Pointer to the zeroed memory. Forwards a library error and returns nullptr on failure.
+   */
+  void* allocatePages( std::size_t size ) ;
+  
+  /** Static function to release memory allocated with allocatePages.
+   * @param memory The memory to release.
+   * @param size The amount of bytes that were requested when allocating.
+   */
+  void releasePages( void* memory, std::size_t size ) ;
+  
+  /** Static function to retrieve the dummy object that checked accesses return on invalid access, instead of dereferencing nothing.
+   * Only constructed on the first invalid access, and only used by checked builds.
+   * @tparam Type The type of object accessed.
+   * @return Reference to the dummy object.
+   */
+  template<typename Type>
+  Type& dummy()
+  {
+    static Type dummy ;
+    return dummy ;
+  }
 }
 
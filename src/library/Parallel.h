@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Parallel.h
+ * Author: agent
+ *
+ * Created on October 16, 2026, 6:32 PM
+ */
+
+#pragma once
+
+#include "JobSystem.h"
+
+namespace mars
+{
+  /** Static function to split a range of work across the hardware threads of the system, using the shared job system.
+   * The calling thread helps with the work, and returns once every part is done. Safe to call from inside of jobs.
+   * @param count The amount of items in the range.
+   * @param grain The least amount of items worth giving to a single thread.
+   * @param function The function to call for each part of the range. Called as function( begin, end ).
+   */
+  template<typename Function>
+  void parallelFor( unsigned count, unsigned grain, Function function )
+  {
+    JobSystem::global().parallelFor( count, grain, std::move( function ) ) ;
+  }
+}
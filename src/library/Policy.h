@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Policy.h
+ * Author: agent
+ *
+ * Created on October 16, 2026, 6:31 PM
+ */
+
+#pragma once
+
+namespace mars
+{
+  /** Traits object describing how the factory pool of a type grows & shrinks.
+   * Specialize this for a type to change its pool's behaviour. E.g.
+   *
+   * template<>
+   * struct mars::PoolPolicy<Particle> : mars::PoolPolicy<void>
+   * {
+   *   static constexpr unsigned initial = 4096 ;
+   * };
+   *
+   * @tparam Type The type of object pooled.
+   */
+  template<typename Type>
+  struct PoolPolicy
+  {
+    /** The amount of objects allocated by the first refill of an empty pool.
+     */
+    static constexpr unsigned initial = 10 ;
+
+    /** The factor each following refill is grown by, until the pool is cleaned up.
+     */
+    static constexpr unsigned growth = 2 ;
+
+    /** The most objects a single refill allocates.
+     */
+    static constexpr unsigned maximum_refill = 4096 ;
+
+    /** The most objects kept in the pool. Objects destroyed past this are freed instead.
+     */
+    static constexpr unsigned maximum = 0xFFFFFFFF ;
+
+    /** The least objects cleanup trims the pool down to.
+     */
+    static constexpr unsigned minimum = 10 ;
+
+    /** The least objects a batch needs for it to be initialized & reset across threads. 0 always runs batches on the calling thread.
+     * @note Only enable this for types whose initialize & reset are safe to call on different objects concurrently.
+     */
+    static constexpr unsigned parallel_batch = 0 ;
+
+    /** Whether destroyed objects are reset later, in batches, instead of on the destroying thread.
+     * Destroyed objects wait in a reclaim queue until the factory's reclaim() is called, e.g. at a frame boundary, once a GPU fence passed, or on a worker thread. They return to the pool only after their reset.
+     */
+    static constexpr bool deferred_reset = false ;
+
+    /** Whether the factory keeps every live object in a dense list, so they can be iterated with forEach & parallelForEach.
+     * The factory then holds a reference to every live object, so objects stay live until they are destroyed through the factory, even if every Data of them is dropped.
+     */
+    static constexpr bool dense = false ;
+  };
+}
@@ -0,0 +1,656 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Pool.h
+ * Author: agent
+ *
+ * Created on October 16, 2026, 6:42 PM
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+#include "FreeList.h"
+#include "Slab.h"
+#include "Handle.h"
+#include "Data.h"
+#include "Policy.h"
+#include "Stats.h"
+#include "Mars.h"
+
+namespace mars
+{
+  /** Instanced pool of objects, e.g. owned by a level or scene.
+   * Objects live in the pool's own slab, which can be backed by any memory resource ( e.g. an arena ). Everything in the pool is freed in one pass when it is released or destroyed.
+   * Uses the same object interface & policy as Factory. Creates & destroys are lock-free, but unlike Factory there are no per-thread caches.
+   * @tparam Type The type of object pooled.
+   */
+  template<typename Type>
+  class Pool : private Keeper<Type>
+  {
+    public:
+
+      /** Lightweight, non-owning handle to an object of an instanced pool.
+       * Unlike mars::Handle, which resolves against the global slab shared by Factory & Manager, it carries the slab of its pool, so it never resolves through another pool or the global slab.
+       */
+      class Handle
+      {
+        public:
+
+          /** Default constructor. Creates an invalid handle.
+           */
+          Handle() = default ;
+
+          /** Method to check whether this handle still refers to the object it was made for.
+           * @return Whether or not this handle is valid.
+           */
+          bool valid() const { return this->cell() != nullptr ; } ;
+
+          /** Conversion operator to boolean to check for validation.
+           * @return Whether or not this handle is valid.
+           */
+          explicit operator bool() const { return this->valid() ; } ;
+
+          /** Method to retrieve the object this handle refers to.
+           * @return Pointer to the object if this handle is valid. nullptr otherwise.
+           */
+          Type* get() const ;
+
+          /** Arrow overload to access the referenced object.
+           * @return Pointer to the referenced object. With MARS_CHECKED_ACCESS, a dummy object on invalid access.
+           * @note Forwards a Mars library error on invalid access. Without MARS_CHECKED_ACCESS, the generation is only checked by MARS_ASSERT.
+           */
+          Type* operator->() const ;
+
+          /** Star overload to access the referenced object.
+           * @return Reference to the referenced object.
+           * @note Forwards a Mars library error on invalid access.
+           */
+          Type& operator*() const { return *this->operator->() ; } ;
+
+          /** Method to retrieve the slab index of this handle.
+           * @return The index this handle refers to.
+           */
+          unsigned index() const { return this->m_index ; } ;
+
+          /** Method to retrieve the generation of this handle.
+           * @return The generation this handle was made for.
+           */
+          unsigned generation() const { return this->m_generation ; } ;
+
+          /** Equality operator.
+           * @param handle The handle to compare against.
+           * @return Whether or not both handles refer to the same object of the same pool.
+           */
+          bool operator==( const Handle& handle ) const { return this->m_slab == handle.m_slab && this->m_index == handle.m_index && this->m_generation == handle.m_generation ; } ;
+
+          /** Inequality operator.
+           * @param handle The handle to compare against.
+           * @return Whether or not the handles refer to different objects.
+           */
+          bool operator!=( const Handle& handle ) const { return !( *this == handle ) ; } ;
+
+        private:
+
+          /** Friend declaration so the pool can create & resolve handles.
+           */
+          friend class Pool<Type> ;
+
+          /** Constructor. Creates a handle to the object currently in a cell.
+           * @param slab The slab of the pool the cell belongs to.
+           * @param cell The cell to create a handle to.
+           */
+          Handle( Slab<Type>* slab, const Cell<Type>* cell ) : m_slab( slab ), m_index( cell->index() ), m_generation( cell->generation() ) {} ;
+
+          /** Helper method to retrieve the cell this handle refers to.
+           * @return The cell this handle refers to if valid. nullptr otherwise.
+           */
+          Cell<Type>* cell() const ;
+
+          /** The slab of the pool the object belongs to.
+           */
+          Slab<Type>* m_slab = nullptr ;
+
+          /** The slab index of the object.
+           */
+          unsigned m_index = Chunks<Cell<Type>>::END ;
+
+          /** The generation of the object.
+           */
+          unsigned m_generation = 0 ;
+      };
+
+      /** Default constructor. Allocates objects straight from the operating system.
+       */
+      Pool() ;
+
+      /** Constructor. Allocates objects out of a memory resource.
+       * @param resource The memory resource to allocate objects from. Must outlive this pool.
+       */
+      explicit Pool( std::pmr::memory_resource* resource ) ;
+
+      /** Deconstructor. Releases every object of this pool.
+       * @note Every object retrieved from this pool must be destroyed, and every Data of this pool dropped, beforehand. See release.
+       */
+      ~Pool() ;
+
+      /** Copying is disallowed.
+       */
+      Pool( const Pool<Type>& pool ) = delete ;
+
+      /** Copying is disallowed.
+       */
+      Pool<Type>& operator=( const Pool<Type>& pool ) = delete ;
+
+      /** Method for retrieving an object from this pool.
+       * @param params The parameters to use for initializing the retrieved object. Forwarded as-is.
+       * @return A wrapped up reference to the created object.
+       */
+      template<typename ... Parameters>
+      Data<Type> create( Parameters&&... params ) ;
+
+      /** Method for retrieving an object from this pool as a lightweight handle.
+       * @param params The parameters to use for initializing the retrieved object. Forwarded as-is.
+       * @return A handle to the created object, only valid for this pool.
+       */
+      template<typename ... Parameters>
+      Handle createHandle( Parameters&&... params ) ;
+
+      /** Method for destroying/reusing an object from this pool.
+       * @note Forwards an InvalidAccess library error & leaves the data alone if it is empty, or belongs to another pool or the factory.
+       * @param data The data reference to put back into this pool.
+       * @note With the policy's deferred_reset, the object is only queued, and is reset & pooled by the next reclaim().
+       */
+      void destroy( Data<Type>& data ) ;
+
+      /** Method for destroying/reusing an object referenced by a handle.
+       * @note Only for objects retrieved with createHandle. Does nothing if the handle is already invalid, or belongs to another pool.
+       * @param handle The handle of the object to put back into this pool.
+       */
+      void destroy( Handle handle ) ;
+
+      /** Method to resolve a handle of this pool.
+       * @param handle The handle to resolve.
+       * @return Pointer to the object if the handle is valid & of this pool. nullptr otherwise.
+       */
+      Type* get( Handle handle ) ;
+
+      /** Method to prewarm this pool.
+       * @param count The amount of objects this pool should have pooled & ready.
+       */
+      void reserve( unsigned count ) ;
+
+      /** Method to trim this pool down to the highest usage seen since the last cleanup, but never less than the policy's minimum.
+       */
+      void cleanup() ;
+
+      /** Method to reset every object destroyed since the last reclaim, and return them to this pool.
+       * @note Only needed with the policy's deferred_reset. Thread safe.
+       */
+      void reclaim() ;
+
+      /** Method to free every object of this pool in one pass.
+       * Objects awaiting a deferred reset are reset first. For trivially destructible types this only returns the pool's chunks to their memory resource, one deallocation per chunk.
+       * Other types also run the destructor of every pooled object, so their cost grows with the amount of objects.
+       * @note Every object retrieved from this pool must be destroyed, and every Data of this pool dropped, beforehand, as they would point into the freed chunks.
+       *       Forwards a LiveRelease library error otherwise. Handles of this pool are left invalid, not dangling. Not thread safe.
+       */
+      void release() ;
+
+      /** Method to take a snapshot of this pool's counters.
+       * @return The current counters of this pool.
+       */
+      FactoryStats stats() const ;
+
+    private:
+
+      /** Friend declaration so the factory can use its default pool.
+       */
+      template<typename Type2>
+      friend class Factory ;
+
+      /** Alias for the growth & shrink policy of this pool.
+       */
+      using Policy = PoolPolicy<Type> ;
+
+      /** Constructor. Creates a pool over a slab it does not own. Used for the default pool of Factory.
+       * @param slab The slab to allocate objects from.
+       * @param keeper The object taking back objects whose last Data was dropped without being destroyed.
+       */
+      constexpr Pool( Slab<Type>& slab, Keeper<Type>& keeper ) : owned(), slab( &slab ), keeper( &keeper ), idle( slab.storage() ), pending( slab.storage() ), available( 0 ), allocated( 0 ), peak( 0 ), refill_size( PoolPolicy<Type>::initial ), created( 0 ), destroyed( 0 ), misses( 0 ), refills( 0 ), reclaimed( 0 ) {} ;
+
+      /** Helper method to take a pooled object out of this pool, refilling it if empty.
+       * @return A cell holding a pooled object & one reference.
+       */
+      Cell<Type>* acquire() ;
+
+      /** Helper method to reset a cell's object and put it back into this pool.
+       * @param cell The cell to put back, along with one of its references.
+       */
+      void recycle( Cell<Type>* cell ) ;
+
+      /** Helper method to put an object that was already reset into this pool. Frees it instead if the pool is at the policy's maximum.
+       * @param cell The cell to put back, along with one of its references.
+       */
+      void store( Cell<Type>* cell ) ;
+
+      /** Helper method to allocate a new object.
+       * @return A cell holding the new object & one reference.
+       */
+      Cell<Type>* allocate() ;
+
+      /** Helper method to free an object allocated by this pool.
+       * @param cell The cell to free, along with one of its references.
+       */
+      void free( Cell<Type>* cell ) ;
+
+      /** Method called once the last Data of an object of this pool is dropped without being destroyed. Puts the object back into this pool.
+       * @param cell The cell of the object, holding one reference.
+       */
+      void keep( Cell<Type>* cell ) override ;
+
+      /** Helper method to retrieve the size of the next refill, growing the size of each following refill.
+       * @return The amount of objects to allocate.
+       */
+      unsigned grow() ;
+
+      /** Helper method to update the high water mark of objects out of this pool.
+       */
+      void mark() ;
+
+      /** Helper method to resolve a handle into a cell of this pool.
+       * @param handle The handle to resolve.
+       * @return The cell the handle refers to if valid & of this pool. nullptr otherwise.
+       */
+      Cell<Type>* cell( Handle handle ) ;
+
+      /** The slab owned by this pool. Unused by pools over a shared slab.
+       */
+      Slab<Type> owned ;
+
+      /** The slab objects are allocated from.
+       */
+      Slab<Type>* slab ;
+
+      /** The object taking back objects whose last Data was dropped without being destroyed. This pool, unless it is the default pool of Factory.
+       */
+      Keeper<Type>* keeper ;
+
+      /** The lock-free list of pooled objects.
+       */
+      FreeList<Cell<Type>> idle ;
+
+      /** The reclaim queue of objects destroyed, but not yet reset.
+       */
+      FreeList<Cell<Type>> pending ;
+
+      /** The amount of objects currently pooled.
+       */
+      std::atomic<unsigned> available ;
+
+      /** The amount of objects allocated by this pool that have not been freed.
+       */
+      std::atomic<unsigned> allocated ;
+
+      /** The most objects that were out of this pool at once since the last cleanup.
+       */
+      std::atomic<unsigned> peak ;
+
+      /** The amount of objects the next refill allocates.
+       */
+      std::atomic<unsigned> refill_size ;
+
+      /** The amount of objects handed out by this pool.
+       */
+      std::atomic<std::uint64_t> created ;
+
+      /** The amount of objects given back to this pool.
+       */
+      std::atomic<std::uint64_t> destroyed ;
+
+      /** The amount of creates that found this pool empty.
+       */
+      std::atomic<std::uint64_t> misses ;
+
+      /** The amount of times this pool was refilled.
+       */
+      std::atomic<std::uint64_t> refills ;
+
+      /** The amount of objects reset by reclaim.
+       */
+      std::atomic<std::uint64_t> reclaimed ;
+  };
+
+  template<typename Type>
+  Cell<Type>* Pool<Type>::Handle::cell() const
+  {
+    Cell<Type>* cell = this->m_slab ? this->m_slab->at( this->m_index ) : nullptr ;
+
+    return cell && cell->generation() == this->m_generation ? cell : nullptr ;
+  }
+
+  template<typename Type>
+  Type* Pool<Type>::Handle::get() const
+  {
+    Cell<Type>* cell = this->cell() ;
+
+    return cell ? cell->object() : nullptr ;
+  }
+
+  template<typename Type>
+  Type* Pool<Type>::Handle::operator->() const
+  {
+    #if MARS_CHECKED_ACCESS
+      Type* object = this->get() ;
+
+      if( object ) return object ;
+      mars::handleError( __FILE__, __LINE__, mars::Error::InvalidAccess ) ;
+      return &mars::dummy<Type>() ;
+    #else
+      MARS_ASSERT( this->valid() ) ;
+      return this->m_slab->storage()[ this->m_index ].object() ;
+    #endif
+  }
+
+  template<typename Type>
+  Pool<Type>::Pool() : owned(), slab( &this->owned ), keeper( this ), idle( this->owned.storage() ), pending( this->owned.storage() ), available( 0 ), allocated( 0 ), peak( 0 ), refill_size( Policy::initial ), created( 0 ), destroyed( 0 ), misses( 0 ), refills( 0 ), reclaimed( 0 )
+  {
+  }
+
+  template<typename Type>
+  Pool<Type>::Pool( std::pmr::memory_resource* resource ) : owned( resource ), slab( &this->owned ), keeper( this ), idle( this->owned.storage() ), pending( this->owned.storage() ), available( 0 ), allocated( 0 ), peak( 0 ), refill_size( Policy::initial ), created( 0 ), destroyed( 0 ), misses( 0 ), refills( 0 ), reclaimed( 0 )
+  {
+  }
+
+  template<typename Type>
+  Pool<Type>::~Pool()
+  {
+    this->release() ;
+  }
+
+  template<typename Type>
+  template<typename ... Parameters>
+  Data<Type> Pool<Type>::create( Parameters&&... params )
+  {
+    Data<Type> data ;
+
+    data.m_cell = this->acquire() ;
+
+    data->initialize( std::forward<Parameters>( params )... ) ;
+    return data ;
+  }
+
+  template<typename Type>
+  template<typename ... Parameters>
+  typename Pool<Type>::Handle Pool<Type>::createHandle( Parameters&&... params )
+  {
+    Cell<Type>* cell = this->acquire() ;
+
+    cell->object()->initialize( std::forward<Parameters>( params )... ) ;
+    return Handle( this->slab, cell ) ;
+  }
+
+  template<typename Type>
+  void Pool<Type>::destroy( Data<Type>& data )
+  {
+    // Data of another pool or the factory would otherwise be recycled into this pool's slab by index.
+    if( !data.m_cell || data.m_cell->owner() != this->slab )
+    {
+      mars::handleError( __FILE__, __LINE__, mars::Error::InvalidAccess ) ;
+      return ;
+    }
+
+    this->recycle( data.m_cell ) ;
+    data.m_cell = nullptr ;
+  }
+
+  template<typename Type>
+  void Pool<Type>::destroy( Handle handle )
+  {
+    Cell<Type>* cell = this->cell( handle ) ;
+
+    if( cell ) this->recycle( cell ) ;
+  }
+
+  template<typename Type>
+  Type* Pool<Type>::get( Handle handle )
+  {
+    Cell<Type>* cell = this->cell( handle ) ;
+
+    return cell ? cell->object() : nullptr ;
+  }
+
+  template<typename Type>
+  void Pool<Type>::reserve( unsigned count )
+  {
+    while( this->available.load( std::memory_order_relaxed ) < count )
+    {
+      this->idle.push( this->allocate()->index() ) ;
+      this->available.fetch_add( 1, std::memory_order_relaxed ) ;
+    }
+  }
+
+  template<typename Type>
+  void Pool<Type>::reclaim()
+  {
+    unsigned count = 0 ;
+
+    for( unsigned index = this->pending.detach(); index != FreeList<Cell<Type>>::END; count++ )
+    {
+      Cell<Type>* cell = &this->slab->storage()[ index ] ;
+
+      // The next link is read before the cell goes back into the pool, where it gets overwritten.
+      index = this->pending.follow( index ) ;
+      cell->object()->reset() ;
+      this->store( cell ) ;
+    }
+
+    this->reclaimed.fetch_add( count, std::memory_order_relaxed ) ;
+  }
+
+  template<typename Type>
+  void Pool<Type>::cleanup()
+  {
+    this->reclaim() ;
+
+    const unsigned outstanding = this->allocated.load( std::memory_order_relaxed ) - this->available.load( std::memory_order_relaxed ) ;
+    const unsigned high        = this->peak.exchange( outstanding, std::memory_order_relaxed ) ;
+    const unsigned wanted      = high > outstanding ? high - outstanding : 0 ;
+    const unsigned keep        = wanted > Policy::minimum ? wanted : Policy::minimum ;
+
+    while( this->available.load( std::memory_order_relaxed ) > keep )
+    {
+      const unsigned index = this->idle.pop() ;
+      if( index == FreeList<Cell<Type>>::END ) break ;
+
+      this->available.fetch_sub( 1, std::memory_order_relaxed ) ;
+      this->free( &this->slab->storage()[ index ] ) ;
+    }
+
+    this->refill_size.store( Policy::initial, std::memory_order_relaxed ) ;
+  }
+
+  template<typename Type>
+  void Pool<Type>::release()
+  {
+    // The shared slab of the default pool also holds Manager objects, so it is never released.
+    if( this->slab != &this->owned ) return ;
+
+    this->reclaim() ;
+
+    // Objects still out of the pool, and any Data of them, would point into the chunks freed below.
+    if( this->allocated.load( std::memory_order_relaxed ) != this->available.load( std::memory_order_relaxed ) )
+    {
+      mars::handleError( __FILE__, __LINE__, mars::Error::LiveRelease ) ;
+    }
+
+    if( !std::is_trivially_destructible<Type>::value )
+    {
+      for( unsigned index = this->idle.pop(); index != FreeList<Cell<Type>>::END; index = this->idle.pop() )
+      {
+        this->owned.storage()[ index ].object()->~Type() ;
+      }
+    }
+
+    this->owned  .clear() ;
+    this->idle   .clear() ;
+    this->pending.clear() ;
+
+    this->available  .store( 0              , std::memory_order_relaxed ) ;
+    this->allocated  .store( 0              , std::memory_order_relaxed ) ;
+    this->peak       .store( 0              , std::memory_order_relaxed ) ;
+    this->refill_size.store( Policy::initial, std::memory_order_relaxed ) ;
+  }
+
+  template<typename Type>
+  FactoryStats Pool<Type>::stats() const
+  {
+    FactoryStats stats ;
+
+    // Read before the destroys, so that the snapshot never has more reclaimed objects than destroyed ones.
+    const std::uint64_t reclaimed = this->reclaimed.load( std::memory_order_relaxed ) ;
+
+    stats.name       = mars::typeName<Type>() ;
+    stats.misses     = this->misses   .load( std::memory_order_relaxed ) ;
+    stats.created    = this->created  .load( std::memory_order_relaxed ) ;
+    stats.destroyed  = this->destroyed.load( std::memory_order_relaxed ) ;
+    stats.refills    = this->refills  .load( std::memory_order_relaxed ) ;
+    stats.allocated  = this->allocated.load( std::memory_order_relaxed ) ;
+    stats.pooled     = this->available.load( std::memory_order_relaxed ) ;
+    stats.peak       = this->peak     .load( std::memory_order_relaxed ) ;
+    stats.hits       = stats.created   > stats.misses ? stats.created - stats.misses   : 0 ;
+    stats.pending    = static_cast<unsigned>( Policy::deferred_reset && stats.destroyed > reclaimed ? stats.destroyed - reclaimed : 0 ) ;
+    stats.live       = stats.allocated > stats.pooled + stats.pending ? stats.allocated - stats.pooled - stats.pending : 0 ;
+
+    return stats ;
+  }
+
+  template<typename Type>
+  Cell<Type>* Pool<Type>::acquire()
+  {
+    const unsigned index = this->idle.pop() ;
+    Cell<Type>*    cell  = nullptr          ;
+
+    this->created.fetch_add( 1, std::memory_order_relaxed ) ;
+
+    if( index != FreeList<Cell<Type>>::END )
+    {
+      this->available.fetch_sub( 1, std::memory_order_relaxed ) ;
+      cell = &this->slab->storage()[ index ] ;
+    }
+    else
+    {
+      const unsigned amount = this->grow() ;
+
+      this->available.fetch_add( amount - 1, std::memory_order_relaxed ) ;
+      this->misses   .fetch_add( 1         , std::memory_order_relaxed ) ;
+
+      for( unsigned count = 1; count < amount; count++ ) this->idle.push( this->allocate()->index() ) ;
+
+      cell = this->allocate() ;
+    }
+
+    this->mark() ;
+    return cell ;
+  }
+
+  template<typename Type>
+  void Pool<Type>::recycle( Cell<Type>* cell )
+  {
+    this->destroyed.fetch_add( 1, std::memory_order_relaxed ) ;
+    cell->retire() ;
+
+    if( Policy::deferred_reset )
+    {
+      this->pending.push( cell->index() ) ;
+      return ;
+    }
+
+    cell->object()->reset() ;
+    this->store( cell ) ;
+  }
+
+  template<typename Type>
+  void Pool<Type>::store( Cell<Type>* cell )
+  {
+    if( this->available.load( std::memory_order_relaxed ) >= Policy::maximum )
+    {
+      this->free( cell ) ;
+      return ;
+    }
+
+    this->available.fetch_add( 1, std::memory_order_relaxed ) ;
+    this->idle.push( cell->index() ) ;
+  }
+
+  template<typename Type>
+  Cell<Type>* Pool<Type>::allocate()
+  {
+    Cell<Type>* cell = this->slab->allocate() ;
+
+    cell->entrust( this->keeper ) ;
+    this->allocated.fetch_add( 1, std::memory_order_relaxed ) ;
+    return cell ;
+  }
+
+  template<typename Type>
+  void Pool<Type>::free( Cell<Type>* cell )
+  {
+    // Taken from the keeper first, so the cell goes back to the slab even if a racing weak lock removes the last reference.
+    cell->entrust( nullptr ) ;
+    cell->dereference() ;
+    this->allocated.fetch_sub( 1, std::memory_order_relaxed ) ;
+  }
+
+  template<typename Type>
+  void Pool<Type>::keep( Cell<Type>* cell )
+  {
+    this->recycle( cell ) ;
+  }
+
+  template<typename Type>
+  unsigned Pool<Type>::grow()
+  {
+    unsigned amount = this->refill_size.load( std::memory_order_relaxed ) ;
+
+    amount = amount != 0 ? amount : 1 ;
+    this->refills.fetch_add( 1, std::memory_order_relaxed ) ;
+    this->refill_size.store( amount * Policy::growth < Policy::maximum_refill ? amount * Policy::growth : Policy::maximum_refill, std::memory_order_relaxed ) ;
+
+    return amount ;
+  }
+
+  template<typename Type>
+  void Pool<Type>::mark()
+  {
+    const unsigned outstanding = this->allocated.load( std::memory_order_relaxed ) - this->available.load( std::memory_order_relaxed ) ;
+    unsigned       current     = this->peak.load( std::memory_order_relaxed ) ;
+
+    while( outstanding > current && !this->peak.compare_exchange_weak( current, outstanding, std::memory_order_relaxed ) ) {}
+  }
+
+  template<typename Type>
+  Cell<Type>* Pool<Type>::cell( Handle handle )
+  {
+    return handle.m_slab == this->slab ? handle.cell() : nullptr ;
+  }
+}
@@ -0,0 +1,467 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Slab.h
+ * Author: agent
+ *
+ * Created on October 16, 2026, 6:28 PM
+ */
+
+#pragma once
+
+#include <atomic>
+#include <new>
+#include <utility>
+#include "Epoch.h"
+#include "FreeList.h"
+
+namespace mars
+{
+  /** Forward declare for cell friendship.
+   */
+  template<typename Type>
+  class Slab ;
+
+  /** Forward declare for keepers.
+   */
+  template<typename Type>
+  class Cell ;
+
+  /** Object taking back the cells of its objects once their last reference is removed, instead of them being released to their slab, e.g. the pool they were created from.
+   * @tparam Type The type of object kept.
+   */
+  template<typename Type>
+  class Keeper
+  {
+    public:
+
+      /** Method called once the last reference of a cell entrusted to this object is removed. Called on the thread removing the reference.
+       * @param cell The cell to take back. Already retired, and holding one reference for the keeper.
+       */
+      virtual void keep( Cell<Type>* cell ) = 0 ;
+
+    protected:
+
+      /** Deconstructor. Trivial, so that static keepers are never torn down while objects may still be handed back to them.
+       */
+      ~Keeper() = default ;
+  };
+
+  /** Object notified whenever a cell it watches is left with a single reference, e.g. the one kept by the cell's owner.
+   * @note The notification is made with the epoch pinned, so owners retiring their watchers through Epoch never have them freed mid-call.
+   */
+  class Watcher
+  {
+    public:
+
+      /** Virtual deconstructor.
+       */
+      virtual ~Watcher() {} ;
+
+      /** Method called once the watched cell is down to a single reference. Called on the thread removing the reference, so must not block.
+       */
+      virtual void orphaned() = 0 ;
+  };
+
+  /** Storage for a single object inside of a slab, with the object's intrusive reference count living right next to it.
+   * @tparam Type The type of object stored.
+   */
+  template<typename Type>
+  class Cell
+  {
+    public:
+
+      /** Method to retrieve the object stored in this cell.
+       * @return Pointer to the object stored in this cell.
+       */
+      Type* object() ;
+
+      /** Method to retrieve the object stored in this cell.
+       * @return Const pointer to the object stored in this cell.
+       */
+      const Type* object() const ;
+
+      /** Method to retrieve the amount of references to this cell.
+       * @return The amount of references to this cell.
+       */
+      unsigned count() const ;
+
+      /** Method to add a reference to this cell.
+       */
+      void reference() ;
+
+      /** Method to remove a reference from this cell. Hands the cell back to its keeper when the last reference is removed, or destroys the object & returns the cell to its slab if it has none.
+       * Notifies the watcher of this cell, if any, when a single reference is left.
+       */
+      void dereference() ;
+
+      /** Method to add a reference to this cell, unless its object was already released.
+       * Used by lock-free lookups that may race with the release of the object.
+       * @return Whether or not a reference was added.
+       */
+      bool retain() ;
+
+      /** Method to take the only reference of this cell, so nothing can retain it anymore.
+       * @note On success the caller must release the cell through its slab.
+       * @return Whether or not the caller held the only reference.
+       */
+      bool claim() ;
+
+      /** Method to retrieve the index of this cell in its slab.
+       * @return The index of this cell.
+       */
+      unsigned index() const ;
+
+      /** Method to retrieve the slab this cell belongs to.
+       * @return Pointer to the slab of this cell.
+       */
+      Slab<Type>* owner() const ;
+
+      /** Method to retrieve the generation of this cell. The generation changes every time the object in this cell is retired.
+       * @return The generation of this cell.
+       */
+      unsigned generation() const ;
+
+      /** Method to retire the object currently in this cell, invalidating every handle to it.
+       */
+      void retire() ;
+
+      /** Method to retrieve the position of this cell's object in a dense list of live objects.
+       * @return The position of this cell's object in its owner's dense list.
+       */
+      unsigned slot() const ;
+
+      /** Method to set the position of this cell's object in a dense list of live objects.
+       * @param slot The position of this cell's object in its owner's dense list.
+       */
+      void place( unsigned slot ) ;
+
+      /** Method to set the object notified whenever this cell is left with a single reference.
+       * @note The caller must hold a reference. A cell has at most one watcher, which must be removed before the cell is released.
+       * @param watcher The watcher of this cell. nullptr to stop watching it.
+       */
+      void watch( Watcher* watcher ) ;
+
+      /** Method to set the object taking back this cell once its last reference is removed.
+       * @note The caller must hold a reference.
+       * @param keeper The keeper of this cell. nullptr to release the cell to its slab instead.
+       */
+      void entrust( Keeper<Type>* keeper ) ;
+
+    private:
+
+      /** Friend declarations so the slab & its free list can manage this cell.
+       */
+      friend class Slab<Type> ;
+      friend class FreeList<Cell<Type>> ;
+
+      /** The storage for the object. First, so that the object is aligned to the cell.
+       */
+      alignas( Type ) unsigned char storage[ sizeof( Type ) ] ;
+
+      /** The slab this cell belongs to.
+       */
+      Slab<Type>* slab ;
+
+      /** The amount of references to this cell.
+       */
+      std::atomic<unsigned> refs ;
+
+      /** The link to the next cell while this cell is free.
+       */
+      std::atomic<unsigned> next ;
+
+      /** The generation of the object in this cell.
+       */
+      std::atomic<unsigned> gen ;
+
+      /** The index of this cell in its slab.
+       */
+      unsigned position ;
+
+      /** The position of the object in its owner's dense list of live objects, if it keeps one.
+       */
+      unsigned dense ;
+
+      /** The object notified whenever this cell is left with a single reference. nullptr if nothing watches it.
+       */
+      std::atomic<Watcher*> watcher ;
+
+      /** The object taking back this cell once its last reference is removed. nullptr to release it to its slab.
+       */
+      Keeper<Type>* keeper ;
+  };
+
+  /** Object for allocating cells out of large, contiguous, page-aligned chunks.
+   * Allocation & release are lock-free. Chunk memory is kept for reuse until the slab is destroyed.
+   * @tparam Type The type of object to allocate.
+   */
+  template<typename Type>
+  class Slab
+  {
+    public:
+
+      /** Default constructor. Constant so that static instances are initialized before any dynamic initialization runs.
+       */
+      constexpr Slab() : cells(), free( cells ) {} ;
+
+      /** Constructor. Allocates cells out of a memory resource instead of the operating system.
+       * @param resource The memory resource to allocate cells from. Must outlive this object.
+       */
+      constexpr explicit Slab( std::pmr::memory_resource* resource ) : cells( resource ), free( cells ) {} ;
+
+      /** Method to allocate a cell and construct an object in it.
+       * @param params The parameters to construct the object with. Forwarded as-is.
+       * @return Pointer to the allocated cell, holding one reference.
+       */
+      template<typename ... Parameters>
+      Cell<Type>* allocate( Parameters&&... params ) ;
+
+      /** Method to destroy a cell's object and return the cell to this slab.
+       * @note Called when the last reference of a cell is removed.
+       * @param cell The cell to release.
+       */
+      void release( Cell<Type>* cell ) ;
+
+      /** Method to hand a cell whose last reference was removed back to its keeper, or release it if it has none.
+       * @param cell The cell to drop.
+       */
+      void drop( Cell<Type>* cell ) ;
+
+      /** Method to look up a cell by index.
+       * @param index The index of the cell.
+       * @return Pointer to the cell at the index. nullptr if the index was never allocated.
+       */
+      Cell<Type>* at( unsigned index ) ;
+
+      /** Method to retrieve the amount of cells this slab has ever had to allocate.
+       * @return The amount of cells allocated by this slab.
+       */
+      unsigned size() const ;
+
+      /** Method to release every cell of this slab at once, without destroying the objects in them.
+       * @note Not thread safe. Every object of this slab must be destroyed ( or trivially destructible ) and unreferenced.
+       */
+      void clear() ;
+
+      /** Method to retrieve the storage of this slab's cells, e.g. for linking cells into other lists.
+       * @return Reference to the storage of this slab's cells.
+       */
+      constexpr Chunks<Cell<Type>>& storage() { return this->cells ; } ;
+
+      /** The slab shared by every user of this type that does not bring its own.
+       */
+      static Slab<Type> global ;
+
+    private:
+
+      /** The storage of every cell of this slab.
+       */
+      Chunks<Cell<Type>> cells ;
+
+      /** The lock-free list of unused cells.
+       */
+      FreeList<Cell<Type>> free ;
+  };
+
+  template<typename Type>
+  Slab<Type> Slab<Type>::global ;
+
+  template<typename Type>
+  Type* Cell<Type>::object()
+  {
+    return std::launder( reinterpret_cast<Type*>( this->storage ) ) ;
+  }
+
+  template<typename Type>
+  const Type* Cell<Type>::object() const
+  {
+    return std::launder( reinterpret_cast<const Type*>( this->storage ) ) ;
+  }
+
+  template<typename Type>
+  unsigned Cell<Type>::count() const
+  {
+    return this->refs.load( std::memory_order_relaxed ) ;
+  }
+
+  template<typename Type>
+  void Cell<Type>::reference()
+  {
+    this->refs.fetch_add( 1, std::memory_order_relaxed ) ;
+  }
+
+  template<typename Type>
+  void Cell<Type>::dereference()
+  {
+    Watcher* watcher = this->watcher.load( std::memory_order_acquire ) ;
+
+    if( !watcher )
+    {
+      if( this->refs.fetch_sub( 1, std::memory_order_acq_rel ) == 1 ) this->slab->drop( this ) ;
+      return ;
+    }
+
+    unsigned count = this->refs.load( std::memory_order_relaxed ) ;
+
+    // Removing a reference while others are left holding theirs notifies nothing, so does not pin the epoch.
+    while( count > 2 )
+    {
+      if( this->refs.compare_exchange_weak( count, count - 1, std::memory_order_acq_rel, std::memory_order_relaxed ) ) return ;
+    }
+
+    // Pinned before the reference is removed, as the owner may release the cell & retire the watcher straight after.
+    Epoch::Guard guard ;
+
+    count = this->refs.fetch_sub( 1, std::memory_order_acq_rel ) ;
+
+    if     ( count == 2 ) watcher->orphaned() ;
+    else if( count == 1 ) this->slab->drop( this ) ;
+  }
+
+  template<typename Type>
+  bool Cell<Type>::retain()
+  {
+    unsigned count = this->refs.load( std::memory_order_relaxed ) ;
+
+    while( count != 0 )
+    {
+      if( this->refs.compare_exchange_weak( count, count + 1, std::memory_order_acquire, std::memory_order_relaxed ) ) return true ;
+    }
+
+    return false ;
+  }
+
+  template<typename Type>
+  bool Cell<Type>::claim()
+  {
+    unsigned count = 1 ;
+
+    return this->refs.compare_exchange_strong( count, 0, std::memory_order_acq_rel, std::memory_order_relaxed ) ;
+  }
+
+  template<typename Type>
+  unsigned Cell<Type>::index() const
+  {
+    return this->position ;
+  }
+
+  template<typename Type>
+  Slab<Type>* Cell<Type>::owner() const
+  {
+    return this->slab ;
+  }
+
+  template<typename Type>
+  unsigned Cell<Type>::generation() const
+  {
+    return this->gen.load( std::memory_order_relaxed ) ;
+  }
+
+  template<typename Type>
+  void Cell<Type>::retire()
+  {
+    this->gen.fetch_add( 1, std::memory_order_relaxed ) ;
+  }
+
+  template<typename Type>
+  unsigned Cell<Type>::slot() const
+  {
+    return this->dense ;
+  }
+
+  template<typename Type>
+  void Cell<Type>::place( unsigned slot )
+  {
+    this->dense = slot ;
+  }
+
+  template<typename Type>
+  void Cell<Type>::watch( Watcher* watcher )
+  {
+    this->watcher.store( watcher, std::memory_order_release ) ;
+  }
+
+  template<typename Type>
+  void Cell<Type>::entrust( Keeper<Type>* keeper )
+  {
+    this->keeper = keeper ;
+  }
+
+  template<typename Type>
+  template<typename ... Parameters>
+  Cell<Type>* Slab<Type>::allocate( Parameters&&... params )
+  {
+    unsigned index = this->free.pop() ;
+
+    if( index == FreeList<Cell<Type>>::END ) index = this->cells.allocate() ;
+
+    Cell<Type>& cell = this->cells[ index ] ;
+
+    cell.slab     = this  ;
+    cell.position = index ;
+    cell.refs.store( 1, std::memory_order_relaxed ) ;
+    cell.watcher.store( nullptr, std::memory_order_relaxed ) ;
+    cell.keeper   = nullptr ;
+    new ( cell.storage ) Type( std::forward<Parameters>( params )... ) ;
+
+    return &cell ;
+  }
+
+  template<typename Type>
+  void Slab<Type>::release( Cell<Type>* cell )
+  {
+    cell->retire() ;
+    cell->object()->~Type() ;
+    this->free.push( cell->position ) ;
+  }
+
+  template<typename Type>
+  void Slab<Type>::drop( Cell<Type>* cell )
+  {
+    if( !cell->keeper )
+    {
+      this->release( cell ) ;
+      return ;
+    }
+
+    // Retired before the keeper's reference is restored, so weak locks racing it fail their generation check.
+    cell->retire() ;
+    cell->refs.store( 1, std::memory_order_release ) ;
+    cell->keeper->keep( cell ) ;
+  }
+
+  template<typename Type>
+  Cell<Type>* Slab<Type>::at( unsigned index )
+  {
+    return index < this->cells.size() ? &this->cells[ index ] : nullptr ;
+  }
+
+  template<typename Type>
+  unsigned Slab<Type>::size() const
+  {
+    return this->cells.size() ;
+  }
+
+  template<typename Type>
+  void Slab<Type>::clear()
+  {
+    this->cells.clear() ;
+    this->free .clear() ;
+  }
+}
@@ -0,0 +1,394 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   SoAPool.h
+ * Author: agent
+ *
+ * Created on October 16, 2026, 6:51 PM
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Mars.h"
+
+namespace mars
+{
+  /** Contiguous view of a single field of every live object of a SoAPool.
+   * Loops over a column's data are plain loops over an array, so the compiler can vectorize them.
+   * @note Invalidated by any create or destroy on its pool.
+   * @tparam Field The type of the field viewed.
+   */
+  template<typename Field>
+  class Column
+  {
+    public:
+
+      /** Constructor.
+       * @param data The first element of the column.
+       * @param size The amount of elements in the column.
+       */
+      Column( Field* data, unsigned size ) : m_data( data ), m_size( size ) {} ;
+
+      /** Method to retrieve the first element of this column.
+       * @return Pointer to the first element of this column.
+       */
+      Field* data() const { return this->m_data ; } ;
+
+      /** Method to retrieve the amount of elements in this column.
+       * @return The amount of elements in this column.
+       */
+      unsigned size() const { return this->m_size ; } ;
+
+      /** Method to retrieve the start of this column, for range based loops.
+       * @return Pointer to the first element of this column.
+       */
+      Field* begin() const { return this->m_data ; } ;
+
+      /** Method to retrieve the end of this column, for range based loops.
+       * @return Pointer past the last element of this column.
+       */
+      Field* end() const { return this->m_data + this->m_size ; } ;
+
+      /** Index operator.
+       * @param position The dense position of the element.
+       * @return Reference to the element at the position.
+       */
+      Field& operator[]( unsigned position ) const { return this->m_data[ position ] ; } ;
+
+    private:
+
+      /** The first element of the column.
+       */
+      Field* m_data ;
+
+      /** The amount of elements in the column.
+       */
+      unsigned m_size ;
+  };
+
+  /** Pool of objects stored as a structure of arrays, e.g. the transforms or bodies of many entities.
+   * Every field lives in its own contiguous column, packed with the fields of the other live objects. Systems reading a single field only pull that field through the cache.
+   * Objects are referenced through generational handles, like Factory's. Destroyed objects are swap-removed from the columns, and their handle indices are reused with a new generation.
+   * @note Not thread safe. Columns may be processed across threads, e.g. with parallelFor, as long as nothing is created or destroyed meanwhile.
+   * @tparam Fields The type of each field of an object.
+   */
+  template<typename ... Fields>
+  class SoAPool
+  {
+    public:
+
+      /** Lightweight, non-owning handle to an object of a SoAPool.
+       * A 32-bit index plus the generation of the object it was made for. Becomes invalid once its object is destroyed.
+       */
+      class Handle
+      {
+        public:
+
+          /** Default constructor. Creates an invalid handle.
+           */
+          Handle() = default ;
+
+          /** Method to retrieve the index of this handle.
+           * @return The index this handle refers to.
+           */
+          unsigned index() const { return this->m_index ; } ;
+
+          /** Method to retrieve the generation of this handle.
+           * @return The generation this handle was made for.
+           */
+          unsigned generation() const { return this->m_generation ; } ;
+
+          /** Equality operator.
+           * @param handle The handle to compare against.
+           * @return Whether or not both handles refer to the same object.
+           */
+          bool operator==( const Handle& handle ) const { return this->m_index == handle.m_index && this->m_generation == handle.m_generation ; } ;
+
+          /** Inequality operator.
+           * @param handle The handle to compare against.
+           * @return Whether or not the handles refer to different objects.
+           */
+          bool operator!=( const Handle& handle ) const { return !( *this == handle ) ; } ;
+
+        private:
+
+          /** Friend declaration so the pool can create handles.
+           */
+          friend class SoAPool<Fields...> ;
+
+          /** Constructor.
+           * @param index The index of the object.
+           * @param generation The generation of the object.
+           */
+          Handle( unsigned index, unsigned generation ) : m_index( index ), m_generation( generation ) {} ;
+
+          /** The index of the object.
+           */
+          unsigned m_index = 0xFFFFFFFF ;
+
+          /** The generation of the object.
+           */
+          unsigned m_generation = 0 ;
+      };
+
+      /** Alias for the type of a field.
+       * @tparam Index The index of the field.
+       */
+      template<unsigned Index>
+      using Field = typename std::tuple_element<Index, std::tuple<Fields...>>::type ;
+
+      /** Default constructor.
+       */
+      SoAPool() = default ;
+
+      /** Method to create an object in this pool.
+       * @param fields The initial value of each field. Forwarded as-is.
+       * @return A handle to the created object.
+       */
+      template<typename ... Values>
+      Handle create( Values&&... fields ) ;
+
+      /** Method to destroy an object of this pool. The last object is moved into its place.
+       * @param handle The handle of the object to destroy. Does nothing if the handle is already invalid.
+       */
+      void destroy( Handle handle ) ;
+
+      /** Method to check whether a handle still refers to an object of this pool.
+       * @param handle The handle to check.
+       * @return Whether or not the handle is valid.
+       */
+      bool valid( Handle handle ) const ;
+
+      /** Method to retrieve a single field of an object.
+       * @tparam Index The index of the field.
+       * @param handle The handle of the object.
+       * @return Pointer to the field if the handle is valid. nullptr otherwise.
+       * @note Invalidated by any create or destroy on this pool.
+       */
+      template<unsigned Index>
+      Field<Index>* get( Handle handle ) ;
+
+      /** Method to retrieve the column of a field.
+       * @tparam Index The index of the field.
+       * @return A view of the field of every live object, in dense order.
+       */
+      template<unsigned Index>
+      Column<Field<Index>> column() ;
+
+      /** Method to retrieve the handle of the object at a dense position, e.g. while iterating columns.
+       * @param position The dense position of the object.
+       * @return A handle to the object at the position.
+       */
+      Handle handle( unsigned position ) const ;
+
+      /** Method to retrieve the dense position of an object.
+       * @param handle The handle of the object.
+       * @return The position of the object in every column. The amount of live objects if the handle is invalid.
+       */
+      unsigned position( Handle handle ) const ;
+
+      /** Method to retrieve the amount of live objects in this pool.
+       * @return The amount of live objects.
+       */
+      unsigned size() const ;
+
+      /** Method to prewarm this pool, so creates up to the amount do not reallocate columns.
+       * @param count The amount of objects this pool should have room for.
+       */
+      void reserve( unsigned count ) ;
+
+      /** Method to destroy every object of this pool at once, invalidating every handle.
+       */
+      void clear() ;
+
+    private:
+
+      /** The link from a handle index into the columns.
+       */
+      struct Slot
+      {
+        unsigned dense      = 0 ; ///< The dense position of the object, or the next free slot while unused.
+        unsigned generation = 0 ; ///< The generation of the object in this slot.
+      };
+
+      /** Marks the end of the list of free slots.
+       */
+      static constexpr unsigned END = 0xFFFFFFFF ;
+
+      /** Helper method to move the last object of every column into a position, then shrink the columns.
+       * @param position The position to fill.
+       */
+      template<std::size_t ... Indices>
+      void remove( unsigned position, std::index_sequence<Indices...> ) ;
+
+      /** The columns of every field, in dense order.
+       */
+      std::tuple<std::vector<Fields>...> columns ;
+
+      /** The slot index of the object at each dense position.
+       */
+      std::vector<unsigned> owners ;
+
+      /** The slots handles index into.
+       */
+      std::vector<Slot> slots ;
+
+      /** The first free slot.
+       */
+      unsigned free = END ;
+  };
+
+  template<typename ... Fields>
+  template<typename ... Values>
+  typename SoAPool<Fields...>::Handle SoAPool<Fields...>::create( Values&&... fields )
+  {
+    static_assert( sizeof...( Values ) == sizeof...( Fields ), "Every field of a SoAPool object needs an initial value." ) ;
+
+    unsigned index = this->free ;
+
+    if( index == END )
+    {
+      index = static_cast<unsigned>( this->slots.size() ) ;
+      this->slots.emplace_back() ;
+    }
+    else
+    {
+      this->free = this->slots[ index ].dense ;
+    }
+
+    Slot& slot = this->slots[ index ] ;
+
+    slot.dense = static_cast<unsigned>( this->owners.size() ) ;
+    this->owners.push_back( index ) ;
+
+    std::apply( [ &fields... ]( std::vector<Fields>&... columns ) { ( columns.emplace_back( std::forward<Values>( fields ) ), ... ) ; }, this->columns ) ;
+
+    return Handle( index, slot.generation ) ;
+  }
+
+  template<typename ... Fields>
+  void SoAPool<Fields...>::destroy( Handle handle )
+  {
+    if( !this->valid( handle ) ) return ;
+
+    Slot&          slot     = this->slots[ handle.m_index ] ;
+    const unsigned position = slot.dense                    ;
+
+    this->remove( position, std::index_sequence_for<Fields...>() ) ;
+
+    if( position < this->owners.size() ) this->slots[ this->owners[ position ] ].dense = position ;
+
+    slot.generation++ ;
+    slot.dense = this->free ;
+    this->free = handle.m_index ;
+  }
+
+  template<typename ... Fields>
+  bool SoAPool<Fields...>::valid( Handle handle ) const
+  {
+    return handle.m_index < this->slots.size() && this->slots[ handle.m_index ].generation == handle.m_generation ;
+  }
+
+  template<typename ... Fields>
+  template<unsigned Index>
+  typename SoAPool<Fields...>::template Field<Index>* SoAPool<Fields...>::get( Handle handle )
+  {
+    if( !this->valid( handle ) ) return nullptr ;
+
+    return &std::get<Index>( this->columns )[ this->slots[ handle.m_index ].dense ] ;
+  }
+
+  template<typename ... Fields>
+  template<unsigned Index>
+  Column<typename SoAPool<Fields...>::template Field<Index>> SoAPool<Fields...>::column()
+  {
+    auto& column = std::get<Index>( this->columns ) ;
+
+    return Column<Field<Index>>( column.data(), static_cast<unsigned>( column.size() ) ) ;
+  }
+
+  template<typename ... Fields>
+  typename SoAPool<Fields...>::Handle SoAPool<Fields...>::handle( unsigned position ) const
+  {
+    MARS_ASSERT( position < this->owners.size() ) ;
+
+    const unsigned index = this->owners[ position ] ;
+
+    return Handle( index, this->slots[ index ].generation ) ;
+  }
+
+  template<typename ... Fields>
+  unsigned SoAPool<Fields...>::position( Handle handle ) const
+  {
+    return this->valid( handle ) ? this->slots[ handle.m_index ].dense : this->size() ;
+  }
+
+  template<typename ... Fields>
+  unsigned SoAPool<Fields...>::size() const
+  {
+    return static_cast<unsigned>( this->owners.size() ) ;
+  }
+
+  template<typename ... Fields>
+  void SoAPool<Fields...>::reserve( unsigned count )
+  {
+    std::apply( [ count ]( std::vector<Fields>&... columns ) { ( columns.reserve( count ), ... ) ; }, this->columns ) ;
+
+    this->owners.reserve( count ) ;
+    this->slots .reserve( count ) ;
+  }
+
+  template<typename ... Fields>
+  void SoAPool<Fields...>::clear()
+  {
+    std::apply( []( std::vector<Fields>&... columns ) { ( columns.clear(), ... ) ; }, this->columns ) ;
+
+    // Every slot gets a new generation & is linked back into the free list, so old handles never resolve again.
+    this->free = END ;
+
+    for( unsigned index = static_cast<unsigned>( this->slots.size() ); index-- > 0; )
+    {
+      this->slots[ index ].generation++ ;
+      this->slots[ index ].dense = this->free ;
+      this->free = index ;
+    }
+
+    this->owners.clear() ;
+  }
+
+  template<typename ... Fields>
+  template<std::size_t ... Indices>
+  void SoAPool<Fields...>::remove( unsigned position, std::index_sequence<Indices...> )
+  {
+    const unsigned last = static_cast<unsigned>( this->owners.size() ) - 1 ;
+
+    if( position != last )
+    {
+      ( ( std::get<Indices>( this->columns )[ position ] = std::move( std::get<Indices>( this->columns )[ last ] ) ), ... ) ;
+      this->owners[ position ] = this->owners[ last ] ;
+    }
+
+    ( std::get<Indices>( this->columns ).pop_back(), ... ) ;
+    this->owners.pop_back() ;
+  }
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Stats.cpp
+ * Author: agent
+ *
+ * Created on October 16, 2026, 6:38 PM
+ */
+
+#include "Stats.h"
+#include <mutex>
+
+namespace mars
+{
+  /** Static function to retrieve the global registry of factories.
+   * @return Reference to the registered stats functions.
+   * @note Function local so factories used during static initialization can register safely.
+   */
+  static std::vector<StatsFunction>& registry()
+  {
+    static std::vector<StatsFunction> functions ;
+    return functions ;
+  }
+
+  /** Static function to retrieve the lock guarding the global registry.
+   * @return Reference to the registry lock.
+   */
+  static std::mutex& registryLock()
+  {
+    static std::mutex lock ;
+    return lock ;
+  }
+
+  void registerFactory( StatsFunction function )
+  {
+    std::lock_guard<std::mutex> lock( registryLock() ) ;
+
+    registry().push_back( function ) ;
+  }
+
+  std::vector<FactoryStats> factoryStats()
+  {
+    std::vector<StatsFunction> functions ;
+    std::vector<FactoryStats>  stats     ;
+
+    {
+      std::lock_guard<std::mutex> lock( registryLock() ) ;
+      functions = registry() ;
+    }
+
+    stats.reserve( functions.size() ) ;
+    for( auto function : functions ) stats.push_back( function() ) ;
+
+    return stats ;
+  }
+
+  std::string parseTypeName( const char* signature )
+  {
+    const std::string full( signature ) ;
+
+    #if defined( _MSC_VER )
+      // "const char *__cdecl mars::typeName<struct Foo>(void)"
+      const std::size_t begin = full.find( "typeName<" ) ;
+      const std::size_t end   = full.rfind( ">(" ) ;
+
+      if( begin == std::string::npos || end == std::string::npos ) return full ;
+
+      std::string name = full.substr( begin + 9, end - begin - 9 ) ;
+
+      for( const char* prefix : { "struct ", "class ", "enum " } )
+      {
+        if( name.compare( 0, std::char_traits<char>::length( prefix ), prefix ) == 0 ) name.erase( 0, std::char_traits<char>::length( prefix ) ) ;
+      }
+
+      return name ;
+    #else
+      // GCC: "const char* mars::typeName() [with Type = Foo]", Clang: "const char *mars::typeName() [Type = Foo]"
+      const std::size_t begin = full.find( "Type = " ) ;
+
+      if( begin == std::string::npos ) return full ;
+
+      std::size_t end = full.find_first_of( ";]", begin ) ;
+      if( end == std::string::npos ) end = full.size() ;
+
+      return full.substr( begin + 7, end - begin - 7 ) ;
+    #endif
+  }
+}
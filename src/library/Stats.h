@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Stats.h
+ * Author: agent
+ *
+ * Created on October 16, 2026, 6:38 PM
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined( _MSC_VER )
+  #define MARS_FUNCTION_SIGNATURE __FUNCSIG__
+#else
+  #define MARS_FUNCTION_SIGNATURE __PRETTY_FUNCTION__
+#endif
+
+namespace mars
+{
+  /** Snapshot of the counters of a single factory pool.
+   * Counters are gathered without stopping the pool, so a snapshot taken while other threads use the pool is only approximately consistent.
+   */
+  struct FactoryStats
+  {
+    const char*   name        = "" ; ///< The name of the pooled type.
+    std::uint64_t created     = 0  ; ///< The amount of objects handed out by the factory.
+    std::uint64_t destroyed   = 0  ; ///< The amount of objects given back to the factory.
+    std::uint64_t hits        = 0  ; ///< The amount of creates served straight from a thread's cache.
+    std::uint64_t misses      = 0  ; ///< The amount of creates that had to take objects from the shared depot.
+    std::uint64_t refills     = 0  ; ///< The amount of times the depot ran empty and new objects were allocated.
+    std::uint64_t depot_time  = 0  ; ///< The nanoseconds threads spent exchanging magazines with the depot, including refills.
+    unsigned      live        = 0  ; ///< The amount of objects currently handed out.
+    unsigned      pooled      = 0  ; ///< The amount of objects currently pooled, in the depot or in thread caches.
+    unsigned      pending     = 0  ; ///< The amount of destroyed objects waiting to be reset by reclaim().
+    unsigned      allocated   = 0  ; ///< The amount of objects currently allocated by the factory.
+    unsigned      peak        = 0  ; ///< The most objects that were out of the depot at once since the last cleanup.
+  };
+
+  /** Function type used to take a snapshot of a factory's counters.
+   */
+  using StatsFunction = FactoryStats (*)() ;
+
+  /** Static function to add a factory to the global registry. Called once by every factory on first use.
+   * @param function The function to take a snapshot of the factory's counters with.
+   */
+  void registerFactory( StatsFunction function ) ;
+
+  /** Static function to take a snapshot of every factory used so far.
+   * @return The counters of every registered factory, in order of first use.
+   */
+  std::vector<FactoryStats> factoryStats() ;
+
+  /** Static function to extract a type name out of a function signature produced by typeName.
+   * @param signature The signature of a typeName instantiation.
+   * @return The name of the type the signature was instantiated for.
+   */
+  std::string parseTypeName( const char* signature ) ;
+
+  /** Static function to retrieve the name of a type, without needing RTTI.
+   * @tparam Type The type to name.
+   * @return The name of the type, as spelled by the compiler.
+   */
+  template<typename Type>
+  const char* typeName()
+  {
+    static const std::string name = mars::parseTypeName( MARS_FUNCTION_SIGNATURE ) ;
+
+    return name.c_str() ;
+  }
+}
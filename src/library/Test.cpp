@@ -25,8 +25,50 @@
 #include <Athena/Manager.h>
 #include "Factory.h"
 #include "Manager.h"
+#include "Pool.h"
+#include "SoAPool.h"
+#include "JobSystem.h"
+#include "FlatMap.h"
+#include "ConcurrentMap.h"
+#include "AssetKey.h"
+#include "Loader.h"
+#include "FileWatcher.h"
 #include <string>
+#include <fstream>
+#include <filesystem>
 #include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <type_traits>
+#include <cstdlib>
+#include <memory_resource>
+#include <new>
+
+/** Counts every allocation made by the test, to check allocation-free paths.
+ */
+static std::atomic<unsigned> allocations( 0 ) ;
+
+void* operator new( std::size_t size )
+{
+  allocations.fetch_add( 1, std::memory_order_relaxed ) ;
+  void* memory = std::malloc( size != 0 ? size : 1 ) ;
+  if( memory == nullptr ) std::abort() ;
+  return memory ;
+}
+
+void operator delete( void* memory ) noexcept
+{
+  std::free( memory ) ;
+}
+
+void operator delete( void* memory, std::size_t ) noexcept
+{
+  std::free( memory ) ;
+}
 
 namespace mars
 {
@@ -52,6 +94,117 @@ namespace mars
     public: Impl() = default ;
   };
   
+  class Particle
+  {
+    public:
+      Particle() = default ;
+      
+      void initialize( unsigned id ) { this->owner = id ; this->uses.fetch_add( 1 ) ; } ;
+      bool initialized() const { return this->owner != 0 ; } ;
+      void reset() { this->owner = 0 ; this->uses.fetch_sub( 1 ) ; } ;
+      
+      unsigned id() const { return this->owner ; } ;
+      unsigned users() const { return this->uses.load() ; } ;
+      
+    private:
+      unsigned              owner = 0 ;
+      std::atomic<unsigned> uses { 0 } ;
+  };
+  
+  class Bullet
+  {
+    public:
+      Bullet() { Bullet::alive++ ; } ;
+      ~Bullet() { Bullet::alive-- ; } ;
+      
+      void initialize() { this->initted = true ; } ;
+      bool initialized() const { return this->initted ; } ;
+      void reset() { this->initted = false ; } ;
+      
+      static unsigned alive ;
+    private:
+      bool initted = false ;
+  };
+  
+  unsigned Bullet::alive = 0 ;
+  
+  template<>
+  struct PoolPolicy<Bullet> : PoolPolicy<void>
+  {
+    static constexpr unsigned initial        = 256 ;
+    static constexpr unsigned minimum        = 32  ;
+    static constexpr unsigned parallel_batch = 64  ;
+  };
+  
+  /** Parameter type that is expensive to copy, and counts how often it is.
+   */
+  struct Heavy
+  {
+    Heavy() : payload( 1024 ) {} ;
+    Heavy( const Heavy& heavy ) : payload( heavy.payload ) { Heavy::copies++ ; } ;
+    Heavy( Heavy&& heavy ) = default ;
+    Heavy& operator=( const Heavy& heavy ) { this->payload = heavy.payload ; Heavy::copies++ ; return *this ; } ;
+    Heavy& operator=( Heavy&& heavy ) = default ;
+    
+    std::vector<unsigned> payload ;
+    static unsigned       copies  ;
+  };
+  
+  unsigned Heavy::copies = 0 ;
+  
+  class Mesh
+  {
+    public:
+      Mesh() { Mesh::defaults++ ; } ;
+      Mesh( std::string name, Heavy heavy ) : name( std::move( name ) ), heavy( std::move( heavy ) ) {} ;
+      
+      void initialize( std::string name, Heavy heavy ) { this->name = std::move( name ) ; this->heavy = std::move( heavy ) ; } ;
+      bool initialized() const { return !this->name.empty() ; } ;
+      void reset() { this->name.clear() ; this->heavy.payload.clear() ; } ;
+      
+      static unsigned defaults ;
+    private:
+      std::string name  ;
+      Heavy       heavy ;
+  };
+  
+  unsigned Mesh::defaults = 0 ;
+  
+  athena::Result test_forwarding()
+  {
+    using Factory = mars::Factory<Mesh> ;
+    using Manager = mars::Manager<unsigned, Mesh> ;
+    
+    Factory::reserve( 32 ) ;
+    Factory::destroy( Factory::createHandle( std::string( 64, 'a' ), Heavy() ) ) ;
+    
+    std::string name( 64, 'b' ) ;
+    Heavy       heavy           ;
+    
+    unsigned copies = Heavy::copies ;
+    unsigned start  = allocations.load() ;
+    auto     mesh   = Factory::create( std::move( name ), std::move( heavy ) ) ;
+    
+    if( !mesh || Heavy::copies != copies || allocations.load() != start ) return false ;
+    
+    Factory::destroy( mesh ) ;
+    
+    // Manager allocates its own bookkeeping, so only copies are checked for it.
+    copies = Heavy::copies ;
+    Manager::create( 0, std::string( 64, 'c' ), Heavy() ) ;
+    if( Heavy::copies != copies ) return false ;
+    
+    const unsigned defaults = Mesh::defaults ;
+    
+    copies = Heavy::copies ;
+    Manager::emplace( 1, std::string( 64, 'd' ), Heavy() ) ;
+    if( Heavy::copies != copies || Mesh::defaults != defaults || !Manager::reference( 1 ) ) return false ;
+    
+    Manager::cleanup() ;
+    
+    return true ;
+  }
+  
   athena::Result test_manager()
   {
     using Model   = mars::Model  <Impl           > ;
@@ -95,6 +248,1541 @@ namespace mars
     
     return true ;
   }
+  
+  athena::Result test_factory_policy()
+  {
+    using Factory = mars::Factory<Bullet> ;
+    
+    std::vector<mars::Data<Bullet>> bullets ;
+    const unsigned                  base = Bullet::alive ;
+    
+    Factory::reserve( 1000 ) ;
+    
+    if( Bullet::alive - base != 1000 ) return false ;
+    
+    for( unsigned index = 0; index < 1000; index++ ) bullets.push_back( Factory::create() ) ;
+    
+    if( Bullet::alive - base != 1000 ) return false ;
+    
+    for( auto& bullet : bullets ) Factory::destroy( bullet ) ;
+    bullets.clear() ;
+    
+    // The burst is the high water mark, so the first cleanup keeps it around.
+    Factory::cleanup() ;
+    if( Bullet::alive - base != 1000 ) return false ;
+    
+    // Nothing was used since, so the second cleanup shrinks to the minimum.
+    Factory::cleanup() ;
+    if( Bullet::alive - base != 32 ) return false ;
+    
+    // An empty pool refills by the policy's initial amount.
+    for( unsigned index = 0; index < 33; index++ ) bullets.push_back( Factory::create() ) ;
+    
+    return Bullet::alive - base == 32 + 256 ;
+  }
+  
+  athena::Result test_factory_batch()
+  {
+    using Factory = mars::Factory<Bullet> ;
+    
+    auto batch = Factory::createBatch( 5000 ) ;
+    
+    if( batch.size() != 5000 ) return false ;
+    for( auto& bullet : batch ) if( !bullet || bullet.count() != 1 ) return false ;
+    
+    auto copy = batch ;
+    
+    Factory::destroyBatch( batch ) ;
+    
+    if( !batch.empty() ) return false ;
+    for( auto& bullet : copy ) if( bullet ) return false ;
+    
+    return true ;
+  }
+  
+  class Shell
+  {
+    public:
+      Shell() = default ;
+      
+      void initialize() { this->initted = true ; } ;
+      bool initialized() const { return this->initted ; } ;
+      void reset() { this->initted = false ; } ;
+      
+    private:
+      bool initted = false ;
+  };
+  
+  athena::Result test_factory_stats()
+  {
+    using Factory = mars::Factory<Shell> ;
+    
+    std::vector<mars::Data<Shell>> shells ;
+    
+    for( unsigned index = 0; index < 100; index++ ) shells.push_back( Factory::create() ) ;
+    
+    auto stats = Factory::stats() ;
+    
+    if( std::string( stats.name ).find( "Shell" ) == std::string::npos ) return false ;
+    if( stats.created != 100 || stats.live != 100 || stats.hits + stats.misses != 100 || stats.refills == 0 ) return false ;
+    if( stats.allocated < 100 || stats.peak < 100 || stats.pooled != stats.allocated - 100 ) return false ;
+    
+    for( auto& shell : shells ) Factory::destroy( shell ) ;
+    
+    // Counters of threads that exited are kept.
+    std::thread( []() { auto shell = Factory::create() ; Factory::destroy( shell ) ; } ).join() ;
+    
+    stats = Factory::stats() ;
+    
+    if( stats.created != 101 || stats.destroyed != 101 || stats.live != 0 || stats.pooled != stats.allocated ) return false ;
+    
+    // Data dropped without being destroyed goes back to the factory once its last copy is gone.
+    {
+      auto dropped = Factory::create() ;
+      auto copy    = dropped            ;
+    }
+    
+    stats = Factory::stats() ;
+    
+    if( stats.created != 102 || stats.destroyed != 102 || stats.live != 0 || stats.pooled != stats.allocated ) return false ;
+    
+    bool registered = false ;
+    
+    for( const auto& factory : mars::factoryStats() ) if( std::string( factory.name ) == stats.name ) registered = true ;
+    
+    Factory::cleanup() ;
+    
+    return registered ;
+  }
+  
+  /** Memory resource that counts the allocations made through it.
+   */
+  class CountingResource : public std::pmr::memory_resource
+  {
+    public:
+      unsigned allocations   = 0 ;
+      unsigned deallocations = 0 ;
+      
+    private:
+      void* do_allocate( std::size_t bytes, std::size_t alignment ) override { this->allocations++ ; return std::pmr::new_delete_resource()->allocate( bytes, alignment ) ; } ;
+      void do_deallocate( void* memory, std::size_t bytes, std::size_t alignment ) override { this->deallocations++ ; std::pmr::new_delete_resource()->deallocate( memory, bytes, alignment ) ; } ;
+      bool do_is_equal( const std::pmr::memory_resource& resource ) const noexcept override { return this == &resource ; } ;
+  };
+  
+  /** Counts the invalid accesses forwarded to the error handler.
+   */
+  static unsigned invalid_accesses = 0 ;
+  
+  /** Counts the pools released with objects still alive.
+   */
+  static unsigned live_releases = 0 ;
+  
+  void countError( const char*, unsigned, mars::Error error )
+  {
+    if( error == mars::Error::InvalidAccess ) invalid_accesses++ ;
+    if( error == mars::Error::LiveRelease   ) live_releases++    ;
+  }
+  
+  /** Counts library errors instead of handling them for as long as it lives, then restores the previous handler.
+   */
+  class CountErrors
+  {
+    public:
+      CountErrors() : previous( mars::setErrorHandler( &countError ) ) {} ;
+      ~CountErrors() { mars::setErrorHandler( this->previous ) ; } ;
+      
+    private:
+      mars::ErrorCallback previous ;
+  };
+  
+  athena::Result test_pool()
+  {
+    CountingResource resource ;
+    
+    {
+      mars::Pool<Particle> level( &resource ) ;
+      std::vector<mars::Pool<Particle>::Handle> particles ;
+      
+      for( unsigned index = 0; index < 10000; index++ ) particles.push_back( level.createHandle( index + 1 ) ) ;
+      
+      if( level.get( particles[ 42 ] ) == nullptr || level.get( particles[ 42 ] )->id() != 43 ) return false ;
+      if( level.stats().live != 10000 || resource.allocations == 0 ) return false ;
+      
+      // Pool handles & global handles are distinct types, and never resolve through each other's slab, even at the same index.
+      static_assert( !std::is_convertible<mars::Handle<Particle>, mars::Pool<Particle>::Handle>::value, "Global handles must not be pool handles." ) ;
+      static_assert( !std::is_convertible<mars::Pool<Particle>::Handle, mars::Handle<Particle>>::value, "Pool handles must not be global handles." ) ;
+      
+      auto     global = mars::Factory<Particle>::createHandle( 99999u ) ;
+      auto     local  = mars::Pool<Particle>::Handle()                ;
+      unsigned id     = 0                                             ;
+      
+      for( unsigned index = 0; index < particles.size(); index++ ) if( particles[ index ].index() == global.index() ) { local = particles[ index ] ; id = index + 1 ; }
+      
+      if( !local || local->id() != id || global->id() != 99999 ) return false ;
+      
+      mars::Pool<Particle> other ;
+      auto foreign = other.createHandle( 5u ) ;
+      auto pooled  = level.create( 1u )       ;
+      
+      // Pool data has no global handle to hand out.
+      const bool unresolved = !pooled.handle().valid() ;
+      
+      level.destroy( pooled ) ;
+      
+      if( other.get( local ) != nullptr || level.get( foreign ) != nullptr || !unresolved ) return false ;
+      
+      // Destroying another pool's handle leaves its object alone.
+      other.destroy( local ) ;
+      mars::Factory<Particle>::destroy( global ) ;
+      
+      if( !local || local->id() != id || !foreign ) return false ;
+      
+      other.destroy( foreign ) ;
+      
+      // Destroying data of the factory or another pool is reported, and leaves this pool & the data alone.
+      {
+        CountErrors    counting                    ;
+        const unsigned accesses = invalid_accesses ;
+        const auto     before   = level.stats()    ;
+        auto           shared   = mars::Factory<Particle>::create( 77u ) ;
+        auto           borrowed = other.create( 78u ) ;
+        
+        level.destroy( shared   ) ;
+        level.destroy( borrowed ) ;
+        
+        const auto after = level.stats() ;
+        
+        if( invalid_accesses != accesses + 2 || !shared || shared->id() != 77 || !borrowed || borrowed->id() != 78 ) return false ;
+        if( after.destroyed != before.destroyed || after.pooled != before.pooled || after.live != before.live ) return false ;
+        
+        mars::Factory<Particle>::destroy( shared ) ;
+        other.destroy( borrowed ) ;
+      }
+      
+      // Likewise, the factory never takes in data of a pool, whose chunks are freed along with it.
+      {
+        CountErrors    counting                    ;
+        const unsigned accesses = invalid_accesses ;
+        const auto     before   = mars::Factory<Particle>::stats() ;
+        auto           scoped   = level.create( 79u ) ;
+        auto           batched  = level.create( 80u ) ;
+        
+        mars::Factory<Particle>::destroy( scoped ) ;
+        mars::Factory<Particle>::destroyBatch( &batched, 1 ) ;
+        
+        if( invalid_accesses != accesses + 2 || !scoped || scoped->id() != 79 || !batched || batched->id() != 80 ) return false ;
+        if( mars::Factory<Particle>::stats().destroyed != before.destroyed ) return false ;
+        
+        level.destroy( scoped  ) ;
+        level.destroy( batched ) ;
+      }
+      
+      level.destroy( particles[ 42 ] ) ;
+      
+      if( level.get( particles[ 42 ] ) != nullptr ) return false ;
+      
+      auto data = level.create( 7u ) ;
+      
+      if( !data || data->id() != 7 || data->users() != 1 ) return false ;
+      
+      level.destroy( data ) ;
+      
+      // Data dropped without being destroyed goes back to its pool.
+      {
+        auto dropped = level.create( 8u ) ;
+      }
+      
+      if( level.stats().live != 9999 || level.stats().pooled == 0 ) return false ;
+      
+      for( auto particle : particles ) level.destroy( particle ) ;
+      
+      // Particles are trivially destructible, so releasing only hands the chunks back to the resource. Their handles are left invalid.
+      const unsigned chunks = resource.allocations ;
+      
+      level.release() ;
+      
+      if( resource.deallocations != chunks || chunks > 16 || level.stats().allocated != 0 || level.get( particles[ 0 ] ) != nullptr ) return false ;
+      
+      // A released pool can be used again.
+      auto again = level.create( 9u ) ;
+      
+      if( !again || again->id() != 9 ) return false ;
+      
+      level.destroy( again ) ;
+    }
+    
+    return resource.allocations == resource.deallocations ;
+  }
+  
+  /** Object with expensive teardown, e.g. a GPU resource.
+   */
+  class Texture
+  {
+    public:
+      Texture() = default ;
+      
+      void initialize( unsigned id ) { this->handle = id ; } ;
+      bool initialized() const { return this->handle != 0 ; } ;
+      void reset() { this->handle = 0 ; this->resetter = std::this_thread::get_id() ; Texture::resets++ ; } ;
+      
+      std::thread::id resetBy() const { return this->resetter ; } ;
+      
+      static std::atomic<unsigned> resets ;
+    private:
+      unsigned        handle = 0 ;
+      std::thread::id resetter   ;
+  };
+  
+  std::atomic<unsigned> Texture::resets( 0 ) ;
+  
+  template<>
+  struct PoolPolicy<Texture> : PoolPolicy<void>
+  {
+    static constexpr bool deferred_reset = true ;
+  };
+  
+  athena::Result test_deferred_reset()
+  {
+    using Factory = mars::Factory<Texture> ;
+    
+    std::vector<mars::Data<Texture>> textures ;
+    std::vector<mars::Handle<Texture>> handles ;
+    
+    for( unsigned index = 0; index < 100; index++ ) textures.push_back( Factory::create( index + 1 ) ) ;
+    for( auto& texture : textures ) handles.push_back( texture.handle() ) ;
+    
+    const unsigned allocated = Factory::stats().allocated ;
+    
+    Factory::destroyBatch( textures ) ;
+    
+    // Destroying only queues the objects, but their handles are invalid straight away.
+    if( Texture::resets != 0 || Factory::stats().pending != 100 ) return false ;
+    for( auto handle : handles ) if( handle.valid() ) return false ;
+    
+    std::thread::id worker ;
+    std::thread( [&worker]() { worker = std::this_thread::get_id() ; Factory::reclaim() ; } ).join() ;
+    
+    if( Texture::resets != 100 || Factory::stats().pending != 0 ) return false ;
+    
+    // Reclaimed objects are reused, so nothing new is allocated.
+    unsigned reused = 0 ;
+    
+    for( unsigned index = 0; index < 100; index++ ) textures.push_back( Factory::create( index + 1 ) ) ;
+    for( auto& texture : textures ) if( texture->resetBy() == worker ) reused++ ;
+    
+    if( Factory::stats().allocated != allocated || reused == 0 ) return false ;
+    
+    Factory::destroyBatch( textures ) ;
+    
+    mars::Pool<Texture> pool ;
+    auto texture = pool.create( 7u ) ;
+    
+    pool.destroy( texture ) ;
+    if( Texture::resets != 100 || pool.stats().pending != 1 ) return false ;
+    
+    pool.reclaim() ;
+    
+    Factory::cleanup() ;
+    
+    return Texture::resets == 201 && pool.stats().pending == 0 && pool.stats().pooled != 0 ;
+  }
+  
+  /** Object updated every frame, e.g. a rigid body.
+   */
+  class Body
+  {
+    public:
+      Body() = default ;
+      
+      void initialize( unsigned id ) { this->identifier = id ; this->steps = 0 ; } ;
+      void reset() { this->identifier = 0 ; } ;
+      bool initialized() const { return this->identifier != 0 ; } ;
+      void step() { this->steps++ ; } ;
+      
+      unsigned id() const { return this->identifier ; } ;
+      unsigned stepped() const { return this->steps ; } ;
+    private:
+      unsigned identifier = 0 ;
+      unsigned steps      = 0 ;
+  };
+  
+  template<>
+  struct PoolPolicy<Body> : PoolPolicy<void>
+  {
+    static constexpr bool     dense          = true ;
+    static constexpr unsigned parallel_batch = 256  ;
+  };
+  
+  athena::Result test_dense_iteration()
+  {
+    using Factory = mars::Factory<Body> ;
+    
+    constexpr unsigned COUNT = 10000 ;
+    
+    std::vector<mars::Data<Body>> bodies ;
+    
+    for( unsigned index = 0; index < COUNT; index++ ) bodies.push_back( Factory::create( index + 1 ) ) ;
+    
+    // Every third body is destroyed, so the rest are swapped around in the dense list.
+    unsigned live = 0 ;
+    
+    for( unsigned index = 0; index < COUNT; index++ )
+    {
+      if( index % 3 == 0 ) Factory::destroy( bodies[ index ] ) ;
+      else                 live++ ;
+    }
+    
+    unsigned visited = 0 ;
+    std::uint64_t sum = 0 ;
+    
+    Factory::forEach( [ &visited, &sum ]( Body& body ) { visited++ ; sum += body.id() ; } ) ;
+    
+    std::uint64_t expected = 0 ;
+    for( unsigned index = 0; index < COUNT; index++ ) if( index % 3 != 0 ) expected += index + 1 ;
+    
+    if( visited != live || sum != expected ) return false ;
+    
+    // Every object is visited exactly once, whatever thread it lands on.
+    std::atomic<unsigned> parallel( 0 ) ;
+    
+    Factory::parallelForEach( [ &parallel ]( Body& body ) { body.step() ; parallel++ ; } ) ;
+    
+    if( parallel != live ) return false ;
+    for( unsigned index = 0; index < COUNT; index++ ) if( index % 3 != 0 && bodies[ index ]->stepped() != 1 ) return false ;
+    
+    // Dropping every Data keeps the objects live, as the factory still references them.
+    auto batch = Factory::createBatch( 100, 1u ) ;
+    batch.clear() ;
+    
+    visited = 0 ;
+    Factory::forEach( [ &visited ]( Body& ) { visited++ ; } ) ;
+    
+    if( visited != live + 100 ) return false ;
+    
+    bodies.erase( std::remove_if( bodies.begin(), bodies.end(), []( const mars::Data<Body>& body ) { return !body ; } ), bodies.end() ) ;
+    Factory::destroyBatch( bodies ) ;
+    
+    visited = 0 ;
+    Factory::forEach( [ &visited ]( Body& ) { visited++ ; } ) ;
+    
+    return visited == 100 ;
+  }
+  
+  athena::Result test_soa_pool()
+  {
+    using Pool = mars::SoAPool<float, float, unsigned> ;
+    
+    constexpr unsigned COUNT = 1000 ;
+    
+    Pool                      pool    ;
+    std::vector<Pool::Handle> handles ;
+    
+    pool.reserve( COUNT ) ;
+    for( unsigned index = 0; index < COUNT; index++ ) handles.push_back( pool.create( 0.0f, 1.0f, index ) ) ;
+    
+    // Destroying swaps the last objects into the holes, but every other handle keeps resolving to its own object.
+    for( unsigned index = 0; index < COUNT; index += 2 ) pool.destroy( handles[ index ] ) ;
+    
+    if( pool.size() != COUNT / 2 ) return false ;
+    
+    for( unsigned index = 0; index < COUNT; index++ )
+    {
+      if( index % 2 == 0 && ( pool.valid( handles[ index ] ) || pool.get<2>( handles[ index ] ) != nullptr ) ) return false ;
+      if( index % 2 == 1 && *pool.get<2>( handles[ index ] ) != index ) return false ;
+    }
+    
+    // Columns are plain arrays.
+    auto position = pool.column<0>() ;
+    auto velocity = pool.column<1>() ;
+    
+    for( unsigned index = 0; index < position.size(); index++ ) position.data()[ index ] += velocity.data()[ index ] * 2.0f ;
+    for( float value : pool.column<0>() ) if( value != 2.0f ) return false ;
+    
+    for( unsigned index = 0; index < pool.size(); index++ )
+    {
+      if( pool.position( pool.handle( index ) ) != index ) return false ;
+    }
+    
+    // Freed indices are reused with a new generation, so stale handles stay invalid.
+    auto reused = pool.create( 5.0f, 0.0f, 7u ) ;
+    
+    if( reused.index() != handles[ COUNT - 2 ].index() || reused == handles[ COUNT - 2 ] || pool.valid( handles[ COUNT - 2 ] ) ) return false ;
+    
+    pool.clear() ;
+    
+    return pool.size() == 0 && !pool.valid( reused ) && !pool.valid( handles[ 1 ] ) && pool.create( 0.0f, 0.0f, 0u ).index() == 0 ;
+  }
+  
+  athena::Result test_job_system()
+  {
+    mars::JobSystem system( 3 ) ;
+    
+    // Plain jobs, counted on a counter.
+    std::atomic<unsigned> ran( 0 ) ;
+    mars::Counter         jobs     ;
+    
+    for( unsigned index = 0; index < 1000; index++ ) system.run( [ &ran ]() { ran++ ; }, &jobs ) ;
+    system.wait( jobs ) ;
+    
+    if( ran != 1000 || !jobs.done() ) return false ;
+    
+    // A job waiting on a counter only starts once every job of the counter finished.
+    std::atomic<unsigned> first( 0 ) ;
+    std::atomic<bool>     ordered( false ) ;
+    mars::Counter         before   ;
+    mars::Counter         after    ;
+    
+    for( unsigned index = 0; index < 100; index++ ) system.run( [ &first ]() { std::this_thread::yield() ; first++ ; }, &before ) ;
+    system.run( [ &first, &ordered ]() { ordered = first == 100 ; }, &after, &before ) ;
+    system.wait( after ) ;
+    
+    if( !ordered ) return false ;
+    
+    // Jobs waiting on other jobs help instead of blocking, even with a single worker.
+    mars::JobSystem       single( 1 ) ;
+    std::atomic<unsigned> nested( 0 ) ;
+    mars::Counter         outer      ;
+    
+    for( unsigned index = 0; index < 8; index++ )
+    {
+      single.run( [ &single, &nested ]() { single.parallelFor( 1000, 10, [ &nested ]( unsigned begin, unsigned end ) { nested += end - begin ; } ) ; }, &outer ) ;
+    }
+    
+    single.wait( outer ) ;
+    
+    if( nested != 8000 ) return false ;
+    
+    // Without workers, everything runs on the waiting thread.
+    mars::JobSystem       none( 0 ) ;
+    std::atomic<unsigned> covered( 0 ) ;
+    
+    none.parallelFor( 5000, 100, [ &covered ]( unsigned begin, unsigned end ) { covered += end - begin ; } ) ;
+    
+    return covered == 5000 ;
+  }
+  
+  athena::Result test_job_system_coverage()
+  {
+    // A prime count, so no grain splits it evenly.
+    constexpr unsigned COUNT = 10007 ;
+    
+    const unsigned                     workers[] = { 0, 1, 3, 7 }              ;
+    const unsigned                     grains [] = { 1, 64, 1000, COUNT * 2 }  ;
+    std::vector<std::atomic<unsigned>> visits( COUNT )                         ;
+    
+    for( unsigned threads : workers )
+    {
+      mars::JobSystem system( threads ) ;
+      
+      for( unsigned grain : grains )
+      {
+        for( auto& visit : visits ) visit.store( 0 ) ;
+        
+        system.parallelFor( COUNT, grain, [ &visits ]( unsigned begin, unsigned end )
+        {
+          for( unsigned index = begin; index < end; index++ ) visits[ index ].fetch_add( 1, std::memory_order_relaxed ) ;
+        } ) ;
+        
+        // Every index is visited exactly once, whatever the amount of workers & grain.
+        for( auto& visit : visits ) if( visit.load() != 1 ) return false ;
+      }
+      
+      bool touched = false ;
+      
+      system.parallelFor( 0, 64, [ &touched ]( unsigned, unsigned ) { touched = true ; } ) ;
+      
+      if( touched ) return false ;
+    }
+    
+    return true ;
+  }
+  
+  using Requests = mars::Manager<std::string, Particle> ;
+  
+  /** State of the requests delivered on loader threads.
+   */
+  static std::atomic<unsigned> fulfilled( 0 ) ;
+  static std::atomic<unsigned> delivered( 0 ) ;
+  static std::atomic<bool>     on_loader( true ) ;
+  static std::thread::id       requester ;
+  
+  /** Holds back every particle load while set, standing in for slow file I/O.
+   */
+  static std::atomic<bool> stalled( false ) ;
+  
+  void fulfillParticle( std::string key, Requests::Callback* callback )
+  {
+    fulfilled++ ;
+    
+    while( stalled ) std::this_thread::yield() ;
+    
+    callback->callback( key, Requests::create( key, static_cast<unsigned>( key.size() ) ) ) ;
+  }
+  
+  void deliverParticle( std::string key, mars::Reference<Particle> particle )
+  {
+    if( std::this_thread::get_id() == requester || !particle || particle->id() != key.size() ) on_loader = false ;
+    
+    delivered++ ;
+  }
+  
+  /** Receives requests batched onto the thread dispatching them.
+   */
+  struct Receiver
+  {
+    std::vector<mars::Reference<Particle>> particles ;
+    bool                                   valid = true ;
+    
+    void receive( std::string key, mars::Reference<Particle> particle )
+    {
+      if( std::this_thread::get_id() != requester ) this->valid = false ;
+      if( key == "missing" ? bool( particle ) : !particle ) this->valid = false ;
+      
+      this->particles.push_back( particle ) ;
+    }
+  };
+  
+  athena::Result test_manager_request()
+  {
+    mars::Dispatcher dispatcher ;
+    Receiver         receiver   ;
+    
+    requester = std::this_thread::get_id() ;
+    stalled   = true ;
+    Requests::addFulfiller( &fulfillParticle, "particles" ) ;
+    
+    for( unsigned index = 0; index < 32; index++ )
+    {
+      Requests::request( &deliverParticle, "particle/" + std::to_string( index ) ) ;
+      Requests::request( &receiver, &Receiver::receive, "batched/" + std::to_string( index ), &dispatcher ) ;
+    }
+    
+    // Requests return while every load is still held back, so nothing was delivered yet.
+    const bool pending = delivered == 0 && !Requests::has( "particle/0" ) && !Requests::has( "batched/0" ) ;
+    
+    stalled = false ;
+    mars::Loader::global().wait() ;
+    
+    if( !pending ) return false ;
+    
+    // Dispatched requests are only delivered at the sync point, on the dispatching thread.
+    if( delivered != 32 || !on_loader || !receiver.particles.empty() ) return false ;
+    if( dispatcher.dispatch() != 32 || receiver.particles.size() != 32 || !receiver.valid ) return false ;
+    if( !Requests::has( "batched/31" ) || fulfilled != 64 ) return false ;
+    
+    // Loaded keys are delivered without fulfilling them again.
+    Requests::request( &receiver, &Receiver::receive, "batched/0", &dispatcher ) ;
+    Requests::removeFulfiller( "particles" ) ;
+    Requests::request( &receiver, &Receiver::receive, "missing", &dispatcher ) ;
+    
+    mars::Loader::global().wait() ;
+    
+    if( dispatcher.dispatch() != 2 || fulfilled != 64 || !receiver.valid ) return false ;
+    
+    // Deliveries follow load completion, so the two may arrive in any order.
+    {
+      const auto& again  = receiver.particles[ 32 ] ? receiver.particles[ 32 ] : receiver.particles[ 33 ] ;
+      const auto  loaded = Requests::reference( "batched/0" ) ;
+      
+      if( again.operator->() != loaded.operator->() ) return false ;
+    }
+    
+    receiver.particles.clear() ;
+    Requests::cleanup() ;
+    
+    return !Requests::has( "particle/0" ) && !Requests::has( "batched/0" ) ;
+  }
+  
+  /** Gate holding back the coalesced load, until every request joined it.
+   */
+  static std::atomic<bool> gate( false ) ;
+  
+  void fulfillGated( std::string key, Requests::Callback* callback )
+  {
+    fulfilled++ ;
+    
+    while( !gate ) std::this_thread::yield() ;
+    
+    callback->callback( key, Requests::create( key, 7u ) ) ;
+  }
+  
+  /** The amount of requests made from other threads that joined the coalesced load.
+   */
+  static std::atomic<unsigned> joined( 0 ) ;
+  
+  void joinParticle( std::string, mars::Reference<Particle> particle )
+  {
+    if( particle && particle->id() == 7 ) joined++ ;
+  }
+  
+  athena::Result test_manager_coalescing()
+  {
+    mars::Dispatcher dispatcher ;
+    Receiver         receiver   ;
+    
+    requester = std::this_thread::get_id() ;
+    fulfilled = 0 ;
+    Requests::addFulfiller( &fulfillGated, "gated" ) ;
+    
+    // Requests made while the key loads join the load in flight, from any thread.
+    std::vector<std::thread> threads ;
+    
+    for( unsigned index = 0; index < 10; index++ ) Requests::request( &receiver, &Receiver::receive, "shared", &dispatcher ) ;
+    for( unsigned index = 0; index < 4; index++ ) threads.emplace_back( []() { Requests::request( &joinParticle, "shared" ) ; } ) ;
+    for( auto& thread : threads ) thread.join() ;
+    
+    gate = true ;
+    mars::Loader::global().wait() ;
+    
+    if( fulfilled != 1 || joined != 4 || dispatcher.dispatch() != 10 || !receiver.valid ) return false ;
+    
+    for( auto& particle : receiver.particles ) if( particle.operator->() != receiver.particles[ 0 ].operator->() || particle->id() != 7 ) return false ;
+    
+    receiver.particles.clear() ;
+    Requests::removeFulfiller( "gated" ) ;
+    Requests::cleanup() ;
+    
+    return !Requests::has( "shared" ) ;
+  }
+  
+  /** Task recording the order loader tasks ran in.
+   */
+  struct Step : public mars::Task
+  {
+    std::vector<unsigned>* order ;
+    unsigned               id    ;
+    
+    Step( std::vector<unsigned>* order, unsigned id ) : order( order ), id( id ) {} ;
+    
+    void run() override { this->order->push_back( this->id ) ; } ;
+  };
+  
+  /** Task holding a loader thread until released.
+   */
+  struct Hold : public mars::Task
+  {
+    std::atomic<bool> started  = { false } ;
+    std::atomic<bool> released = { false } ;
+    
+    void run() override { this->started = true ; while( !this->released ) std::this_thread::yield() ; } ;
+  };
+  
+  /** Keys loaded by the held fulfiller, and the amount of loads waiting to be released.
+   */
+  static std::vector<std::string> held_keys ;
+  static std::mutex               held_lock ;
+  static std::atomic<unsigned>    held_started( 0 ) ;
+  static std::atomic<bool>        held( true ) ;
+  
+  void fulfillHeld( std::string key, Requests::Callback* callback )
+  {
+    {
+      std::lock_guard<std::mutex> lock( held_lock ) ;
+      held_keys.push_back( key ) ;
+    }
+    
+    held_started++ ;
+    while( held ) std::this_thread::yield() ;
+    
+    callback->callback( key, Requests::create( key, 3u ) ) ;
+  }
+  
+  athena::Result test_manager_priority()
+  {
+    // A single loader thread runs the highest priority first, first come first served among equals.
+    {
+      mars::Loader          loader( 1 ) ;
+      std::vector<unsigned> order       ;
+      Hold                  hold        ;
+      Step                  steps[ 6 ] = { { &order, 0 }, { &order, 1 }, { &order, 2 }, { &order, 3 }, { &order, 4 }, { &order, 5 } } ;
+      
+      loader.submit( &hold ) ;
+      while( !hold.started ) std::this_thread::yield() ;
+      
+      loader.submit( &steps[ 0 ], 1 ) ;
+      loader.submit( &steps[ 1 ], 5 ) ;
+      loader.submit( &steps[ 2 ], 3 ) ;
+      loader.submit( &steps[ 3 ], 5 ) ;
+      loader.submit( &steps[ 4 ], 0 ) ;
+      loader.submit( &steps[ 5 ], 2 ) ;
+      
+      if( !loader.prioritize( &steps[ 4 ], 9 ) || !loader.prioritize( &steps[ 1 ], -1 ) || !loader.cancel( &steps[ 2 ] ) || loader.cancel( &steps[ 2 ] ) ) return false ;
+      
+      hold.released = true ;
+      loader.wait() ;
+      
+      if( order != std::vector<unsigned>{ 4, 3, 5, 0, 1 } || loader.prioritize( &steps[ 0 ], 1 ) ) return false ;
+    }
+    
+    mars::Dispatcher dispatcher ;
+    Receiver         receiver   ;
+    
+    requester = std::this_thread::get_id() ;
+    held      = true ;
+    Requests::addFulfiller( &fulfillHeld, "held" ) ;
+    
+    // Holds every loader thread, so the requests after wait in the loader's queue.
+    for( unsigned index = 0; index < mars::Loader::global().threads(); index++ ) Requests::request( &receiver, &Receiver::receive, "hold/" + std::to_string( index ), &dispatcher ) ;
+    while( held_started != mars::Loader::global().threads() ) std::this_thread::yield() ;
+    
+    auto far    = Requests::request( &receiver, &Receiver::receive, "far" , &dispatcher, 0 ) ;
+    auto near   = Requests::request( &receiver, &Receiver::receive, "near", &dispatcher, 5 ) ;
+    auto gone   = Requests::request( &receiver, &Receiver::receive, "gone", &dispatcher, 9 ) ;
+    auto shared = Requests::request( &receiver, &Receiver::receive, "near", &dispatcher, 1 ) ;
+    
+    // Cancelling one of two requests of a key keeps the load for the other.
+    if( !gone.cancel() || gone.cancel() || !shared.cancel() || !far.prioritize( 10 ) || Requests::Ticket().cancel() ) return false ;
+    
+    held = false ;
+    mars::Loader::global().wait() ;
+    
+    const unsigned delivered = dispatcher.dispatch() ;
+    
+    if( delivered != mars::Loader::global().threads() + 2 || !receiver.valid || far.cancel() || near.prioritize( 1 ) ) return false ;
+    if( std::find( held_keys.begin(), held_keys.end(), "gone" ) != held_keys.end() || Requests::has( "gone" ) || !Requests::has( "near" ) ) return false ;
+    
+    receiver.particles.clear() ;
+    Requests::removeFulfiller( "held" ) ;
+    Requests::cleanup() ;
+    
+    return true ;
+  }
+  
+  #if MARS_COROUTINES
+  /** Minimal coroutine type, running eagerly & freeing itself once finished.
+   */
+  struct Coroutine
+  {
+    struct promise_type
+    {
+      Coroutine           get_return_object() { return {} ; } ;
+      std::suspend_never  initial_suspend() noexcept { return {} ; } ;
+      std::suspend_never  final_suspend() noexcept { return {} ; } ;
+      void                return_void() {} ;
+      void                unhandled_exception() { std::terminate() ; } ;
+    };
+  };
+  
+  /** Loads a scene as straight-line code. The first two loads run concurrently, the third depends on the first.
+   */
+  Coroutine loadScene( mars::Dispatcher* executor, std::vector<unsigned>* ids, std::atomic<bool>* done )
+  {
+    auto first  = Requests::load( "scene/first" , executor ) ;
+    auto second = Requests::load( "scene/second", executor ) ;
+    
+    mars::Reference<Particle> model = co_await first ;
+    
+    if( std::this_thread::get_id() != requester ) ids->push_back( 0 ) ;
+    
+    mars::Reference<Particle> texture = co_await second ;
+    mars::Reference<Particle> shader  = co_await Requests::load( "scene/" + std::to_string( model->id() ), executor, 5 ) ;
+    
+    // Already loaded keys complete without suspending.
+    mars::Reference<Particle> again = co_await Requests::load( "scene/first" ) ;
+    
+    if( std::this_thread::get_id() != requester ) ids->push_back( 0 ) ;
+    
+    ids->push_back( model->id() ) ;
+    ids->push_back( texture->id() ) ;
+    ids->push_back( shader->id() ) ;
+    ids->push_back( again->id() ) ;
+    
+    *done = true ;
+  }
+  
+  athena::Result test_manager_coroutine()
+  {
+    mars::Dispatcher      dispatcher       ;
+    std::vector<unsigned> ids              ;
+    std::atomic<bool>     done( false )    ;
+    
+    requester = std::this_thread::get_id() ;
+    Requests::addFulfiller( &fulfillParticle, "particles" ) ;
+    
+    loadScene( &dispatcher, &ids, &done ) ;
+    
+    // The coroutine only ever resumes on this thread, at the sync point.
+    while( !done )
+    {
+      dispatcher.dispatch() ;
+      std::this_thread::yield() ;
+    }
+    
+    Requests::removeFulfiller( "particles" ) ;
+    Requests::cleanup() ;
+    
+    return ids == std::vector<unsigned>{ 11, 12, 8, 11 } ;
+  }
+  #endif
+  
+  class Probe
+  {
+    public:
+      Probe() { Probe::constructed++ ; } ;
+      
+      void initialize() { this->initted = true ; } ;
+      bool initialized() const { return this->initted ; } ;
+      void reset() { this->initted = false ; } ;
+      
+      static unsigned constructed ;
+    private:
+      bool initted = false ;
+  };
+  
+  unsigned Probe::constructed = 0 ;
+  
+  athena::Result test_access()
+  {
+    using Factory = mars::Factory<Probe> ;
+    
+    // The dummy object is only constructed on demand, so nothing exists before the first create.
+    if( Probe::constructed != 0 ) return false ;
+    
+    auto probe = Factory::create() ;
+    
+    if( !probe || !probe->initialized() ) return false ;
+    
+    const unsigned constructed = Probe::constructed ;
+    
+    #if MARS_CHECKED_ACCESS
+      const auto handle = probe.handle() ;
+    #endif
+    
+    Factory::destroy( probe ) ;
+    
+    #if MARS_CHECKED_ACCESS
+      // The default handler aborts on fatal errors, so errors are only counted while this test runs.
+      CountErrors    counting                    ;
+      const unsigned accesses = invalid_accesses ;
+      const unsigned releases = live_releases    ;
+      
+      const bool dummy = !probe->initialized() && !( *probe ).initialized() ;
+      
+      if( !dummy || invalid_accesses != accesses + 2 || Probe::constructed != constructed + 1 ) return false ;
+      
+      // Handles share the dummy object, so dereferencing a stale one is as safe as an empty data.
+      const bool stale = !handle->initialized() && !( *handle ).initialized() ;
+      
+      if( !stale || invalid_accesses != accesses + 4 || Probe::constructed != constructed + 1 ) return false ;
+      
+      // Releasing a pool with objects still out of it is reported, as their Data would be left dangling.
+      mars::Pool<Probe> scene ;
+      auto              live = scene.createHandle() ;
+      
+      scene.release() ;
+      
+      if( live_releases != releases + 1 || live.valid() ) return false ;
+    #endif
+    
+    Factory::cleanup() ;
+    
+    return constructed != 0 ;
+  }
+  
+  athena::Result test_manager_concurrent()
+  {
+    using Manager = mars::Manager<unsigned, Particle> ;
+    
+    constexpr unsigned KEYS       = 256   ;
+    constexpr unsigned THREADS    = 8     ;
+    constexpr unsigned ITERATIONS = 10000 ;
+    
+    // Duplicate creates & lookups racing with cleanup report errors on purpose, so they are only counted.
+    CountErrors counting ;
+    
+    std::vector<std::vector<const Particle*>> seen( THREADS, std::vector<const Particle*>( KEYS, nullptr ) ) ;
+    std::vector<std::thread>                  threads ;
+    std::atomic<bool>                         valid( true ) ;
+    
+    // Every thread creates every key, but each key resolves to a single object, initialized once.
+    for( unsigned thread = 0; thread < THREADS; thread++ )
+    {
+      threads.emplace_back( [ &seen, thread ]()
+      {
+        for( unsigned key = 0; key < KEYS; key++ ) seen[ thread ][ key ] = Manager::create( key, thread + 1 ).operator->() ;
+      } ) ;
+    }
+    
+    for( auto& thread : threads ) thread.join() ;
+    threads.clear() ;
+    
+    for( unsigned key = 0; key < KEYS; key++ )
+    {
+      for( unsigned thread = 1; thread < THREADS; thread++ ) if( seen[ thread ][ key ] != seen[ 0 ][ key ] ) return false ;
+      if( seen[ 0 ][ key ]->users() != 1 || !Manager::has( key ) ) return false ;
+    }
+    
+    // Concurrent lookups resolve every key to the object created for it, and never initialize it again.
+    for( unsigned thread = 0; thread < THREADS; thread++ )
+    {
+      threads.emplace_back( [ &valid, &seen, thread ]()
+      {
+        for( unsigned iteration = 0; iteration < ITERATIONS; iteration++ )
+        {
+          const unsigned key = ( iteration + thread ) % KEYS ;
+          auto           ref = Manager::reference( key ) ;
+          
+          if( ref.operator->() != seen[ 0 ][ key ] || !ref->initialized() ) valid = false ;
+        }
+      } ) ;
+    }
+    
+    for( auto& thread : threads ) thread.join() ;
+    threads.clear() ;
+    
+    for( unsigned key = 0; key < KEYS; key++ ) if( seen[ 0 ][ key ]->users() != 1 ) return false ;
+    
+    // Lookups racing with cleanup either keep their object alive or find nothing, but never see a released object.
+    std::atomic<bool> running( true ) ;
+    
+    for( unsigned thread = 0; thread < THREADS; thread++ )
+    {
+      threads.emplace_back( [ &valid, &running, thread ]()
+      {
+        for( unsigned iteration = 0; running; iteration++ )
+        {
+          auto ref = Manager::reference( ( iteration + thread ) % KEYS ) ;
+          
+          if( ref && !ref->initialized() ) valid = false ;
+        }
+      } ) ;
+    }
+    
+    while( Manager::has( 0 ) || Manager::has( KEYS - 1 ) ) Manager::cleanup() ;
+    
+    running = false ;
+    for( auto& thread : threads ) thread.join() ;
+    
+    Manager::cleanup() ;
+    
+    for( unsigned key = 0; key < KEYS; key++ ) if( Manager::has( key ) ) return false ;
+    
+    return valid.load() ;
+  }
+
+  /** Waits for a condition set on another thread, giving up after a few seconds.
+   */
+  template<typename Condition>
+  bool eventually( Condition condition )
+  {
+    const auto start = std::chrono::steady_clock::now() ;
+    
+    while( !condition() )
+    {
+      if( std::chrono::steady_clock::now() - start > std::chrono::seconds( 5 ) ) return false ;
+      
+      std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) ) ;
+    }
+    
+    return true ;
+  }
+  
+  void countChange( void* changes )
+  {
+    static_cast<std::atomic<unsigned>*>( changes )->fetch_add( 1 ) ;
+  }
+  
+  athena::Result test_file_watcher()
+  {
+    const std::string     path = ( std::filesystem::temp_directory_path() / "mars_file_watcher_test.txt" ).string() ;
+    std::atomic<unsigned> changes( 0 ) ;
+    
+    std::ofstream( path ) << "1" ;
+    
+    // Writes are noticed whether the watcher polls or is notified.
+    for( bool polling : { true, false } )
+    {
+      mars::FileWatcher watcher( 10, polling ) ;
+      
+      const unsigned id = watcher.watch( path, &countChange, &changes ) ;
+      
+      changes = 0 ;
+      std::ofstream( path ) << ( polling ? "22" : "333" ) ;
+      
+      if( !eventually( [ &changes ]() { return changes != 0 ; } ) ) return false ;
+      
+      // Unwatched files are never called back again.
+      watcher.unwatch( id ) ;
+      
+      const unsigned seen = changes ;
+      
+      std::ofstream( path ) << "4444" ;
+      std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) ) ;
+      
+      if( changes != seen ) return false ;
+    }
+    
+    std::filesystem::remove( path ) ;
+    
+    return true ;
+  }
+  
+  /** The file reloaded particles read their id from.
+   */
+  static std::string reload_path ;
+  
+  void fulfillFile( std::string key, Requests::Callback* callback )
+  {
+    unsigned      id = 0              ;
+    std::ifstream file( reload_path ) ;
+    
+    file >> id ;
+    
+    callback->callback( key, Requests::make( id ) ) ;
+  }
+  
+  void fulfillTexture( std::string key, mars::Manager<std::string, Texture>::Callback* callback )
+  {
+    callback->callback( key, mars::Manager<std::string, Texture>::make( 2u ) ) ;
+  }
+  
+  athena::Result test_manager_reload()
+  {
+    using Textures = mars::Manager<std::string, Texture> ;
+    
+    std::atomic<bool> valid   ( true ) ;
+    std::atomic<bool> reading ( true ) ;
+    bool              swapped = true   ;
+    
+    reload_path = ( std::filesystem::temp_directory_path() / "mars_reload_test.txt" ).string() ;
+    std::ofstream( reload_path ) << 2 ;
+    Requests::addFulfiller( &fulfillFile, "files" ) ;
+    
+    // Keys not in the manager are not loaded by reloading them.
+    Requests::reload( "reloaded" ) ;
+    mars::Loader::global().wait() ;
+    
+    if( Requests::has( "reloaded" ) ) return false ;
+    
+    auto                         held = Requests::create( "reloaded", 1u ) ;
+    const Requests::KeyReference tracked( "reloaded" )                  ;
+    
+    // Lookups racing with reloads always find the key, either before or after it was replaced.
+    std::thread reader( [ &valid, &reading ]()
+    {
+      while( reading )
+      {
+        auto particle = Requests::reference( "reloaded" ) ;
+        
+        if( !particle || !particle->initialized() ) valid = false ;
+      }
+    } ) ;
+    
+    Requests::reload( "reloaded" ) ;
+    mars::Loader::global().wait() ;
+    
+    // References handed out keep the data they reference. Later lookups, & key references, retrieve the reloaded data.
+    if( held->id() != 1 || Requests::reference( "reloaded" )->id() != 2 || tracked.lock()->id() != 2 ) swapped = false ;
+    
+    for( unsigned id = 3; id < 20; id++ )
+    {
+      std::ofstream( reload_path ) << id ;
+      Requests::reload( "reloaded" ) ;
+      mars::Loader::global().wait() ;
+    }
+    
+    if( Requests::reference( "reloaded" )->id() != 19 || held->id() != 1 ) swapped = false ;
+    
+    // Watched keys reload when their file changes.
+    Requests::watch( "reloaded", reload_path ) ;
+    std::ofstream( reload_path ) << 100 ;
+    
+    if( !eventually( []() { return Requests::reference( "reloaded" )->id() == 100 ; } ) ) swapped = false ;
+    
+    Requests::unwatch( "reloaded" ) ;
+    
+    reading = false ;
+    reader.join() ;
+    
+    Requests::removeFulfiller( "files" ) ;
+    Requests::cleanup() ;
+    std::filesystem::remove( reload_path ) ;
+    
+    if( !swapped || !valid || Requests::has( "reloaded" ) || held->id() != 1 || !tracked.expired() || tracked.lock() ) return false ;
+    
+    // Data replaced while still referenced is reset by cleanup once let go, like any other data released.
+    const unsigned resets = Texture::resets ;
+    
+    Textures::addFulfiller( &fulfillTexture, "textures" ) ;
+    
+    {
+      auto current = Textures::create( "replaced", 1u ) ;
+      
+      {
+        auto previous = current ;
+        
+        Textures::reload( "replaced" ) ;
+        mars::Loader::global().wait() ;
+        
+        current = Textures::reference( "replaced" ) ;
+        Textures::cleanup() ;
+        
+        if( Texture::resets != resets || !previous->initialized() ) return false ;
+      }
+      
+      Textures::cleanup() ;
+      
+      if( Texture::resets != resets + 1 || !current->initialized() ) return false ;
+    }
+    
+    Textures::removeFulfiller( "textures" ) ;
+    Textures::cleanup() ;
+    
+    return Texture::resets == resets + 2 && !Textures::has( "replaced" ) ;
+  }
+  
+  athena::Result test_flat_map()
+  {
+    constexpr unsigned COUNT = 100000 ;
+    
+    mars::FlatMap<unsigned, unsigned> map ;
+    
+    for( unsigned key = 0; key < COUNT; key++ ) map[ key * 7 ] = key ;
+    
+    if( map.size() != COUNT || map.insert( 7, 0 ).second || map.find( 7 )->second != 1 ) return false ;
+    
+    // Erased slots are skipped by lookups, and reused by inserts.
+    for( unsigned key = 0; key < COUNT; key += 2 ) if( !map.erase( key * 7 ) ) return false ;
+    for( unsigned key = 0; key < COUNT; key++ ) if( ( map.find( key * 7 ) != map.end() ) != ( key % 2 == 1 ) ) return false ;
+    
+    unsigned iterated = 0 ;
+    for( auto& entry : map ) if( entry.first == entry.second * 7 ) iterated++ ;
+    
+    if( iterated != COUNT / 2 || map.find( 3 ) != map.end() ) return false ;
+    
+    mars::FlatMap<std::string, unsigned> names ;
+    
+    for( unsigned key = 0; key < 1000; key++ ) names.insert( "asset/" + std::to_string( key ), key ) ;
+    for( unsigned key = 0; key < 1000; key++ ) if( names.find( "asset/" + std::to_string( key ) )->second != key ) return false ;
+    
+    // Flat & concurrent maps agree with the node based map on every key & value, through erases & reinserts.
+    constexpr unsigned KEYS = 4096 ;
+    
+    std::unordered_map<unsigned, unsigned>    nodes      ;
+    mars::FlatMap<unsigned, unsigned>         flat       ;
+    mars::ConcurrentMap<unsigned, unsigned>   concurrent ;
+    
+    auto insert = [ & ]( unsigned key, unsigned value )
+    {
+      unsigned stored ;
+      
+      nodes[ key ] = value ;
+      flat.insert( key, value ) ;
+      concurrent.insert( key, [ value ]() { return value ; }, stored ) ;
+    };
+    
+    for( unsigned key = 0; key < KEYS; key++ ) insert( key * 2654435761u, key ) ;
+    
+    for( unsigned key = 0; key < KEYS; key += 3 )
+    {
+      nodes.erase( key * 2654435761u ) ;
+      flat .erase( key * 2654435761u ) ;
+      concurrent.eraseIf( key * 2654435761u, []( unsigned, unsigned ) { return true ; } ) ;
+    }
+    
+    for( unsigned key = 0; key < KEYS; key += 6 ) insert( key * 2654435761u, key + KEYS ) ;
+    
+    for( unsigned key = 0; key < KEYS; key++ )
+    {
+      const unsigned hashed = key * 2654435761u ;
+      const auto     node   = nodes.find( hashed ) ;
+      const auto     entry  = flat .find( hashed ) ;
+      unsigned       value  = 0                    ;
+      
+      if( ( node == nodes.end() ) != ( entry == flat.end() ) || ( node == nodes.end() ) == concurrent.find( hashed, value ) ) return false ;
+      if( node != nodes.end() && ( entry->second != node->second || value != node->second ) ) return false ;
+    }
+    
+    return flat.size() == nodes.size() ;
+  }
+  
+  athena::Result test_asset_key()
+  {
+    using namespace mars::literals ;
+    using Manager = mars::Manager<mars::AssetKey, Particle> ;
+    
+    // Reference values of 64-bit FNV-1a, computed at compile time.
+    static_assert( mars::AssetKey::hash( ""  ) == 0xCBF29CE484222325ull, "FNV-1a offset basis" ) ;
+    static_assert( mars::AssetKey::hash( "a" ) == 0xAF63DC4C8601EC8Cull, "FNV-1a of a"         ) ;
+    
+    constexpr mars::AssetKey literal = "textures/grass.png" ;
+    constexpr mars::AssetKey suffix  = "textures/grass.png"_asset ;
+    
+    static_assert( literal == suffix && literal == MARS_ASSET_KEY( "textures/grass.png" ), "Literal keys hash alike" ) ;
+    
+    const std::string      path = "textures/grass.png" ;
+    const std::string_view view = path                 ;
+    
+    if( mars::AssetKey( path ) != literal || mars::AssetKey( view ) != literal || mars::AssetKey( "textures/dirt.png" ) == literal ) return false ;
+    
+    #if MARS_ASSET_NAMES
+      if( std::string( literal.name() ) != path ) return false ;
+    #endif
+    
+    #if MARS_ASSET_NAMES && defined( MARS_CONSTANT_EVALUATED )
+      // Both literal spellings remember their path when made at runtime.
+      mars::AssetKey sand = "textures/sand.png"_asset ;
+      mars::AssetKey clay = "textures/clay.png"       ;
+      
+      if( std::string( sand.name() ) != "textures/sand.png" || std::string( clay.name() ) != "textures/clay.png" ) return false ;
+    #endif
+    
+    if( std::string( mars::AssetKey::fromHash( 1 ).name() ) != "" ) return false ;
+    
+    // Keys made from literals, std::string & std::string_view all resolve to the same object.
+    {
+      auto grass = Manager::create( "textures/grass.png", 1u ) ;
+      auto dirt  = Manager::create( std::string( view.substr( 0, 9 ) ) + "dirt.png", 2u ) ;
+      
+      if( Manager::reference( view )->id() != 1 || Manager::reference( path )->id() != 1 || Manager::reference( "textures/dirt.png" )->id() != 2 ) return false ;
+      if( Manager::has( "textures/rock.png" ) ) return false ;
+    }
+    
+    Manager::cleanup() ;
+    
+    return !Manager::has( literal ) ;
+  }
+  
+  /** Object with a memory cost of its own, e.g. an image.
+   */
+  class Image
+  {
+    public:
+      void initialize( std::size_t bytes ) { this->bytes = bytes ; } ;
+      bool initialized() const { return this->bytes != 0 ; } ;
+      void reset() { this->bytes = 0 ; } ;
+      std::size_t byteSize() const { return this->bytes ; } ;
+    private:
+      std::size_t bytes = 0 ;
+  };
+  
+  athena::Result test_manager_budget()
+  {
+    using Manager = mars::Manager<unsigned, Image> ;
+    
+    Particle particle ;
+    
+    if( mars::ByteSize<Particle>::of( particle ) != sizeof( Particle ) ) return false ;
+    
+    Manager::setBudget( 1000 ) ;
+    
+    auto held = Manager::create( 0, std::size_t( 200 ) ) ;
+    
+    for( unsigned key = 1; key < 10; key++ ) Manager::create( key, std::size_t( 200 ) ) ;
+    
+    // The least recently unreferenced data goes until the budget fits. Held data stays.
+    Manager::cleanup() ;
+    
+    if( Manager::residentBytes() != 1000 ) return false ;
+    
+    for( unsigned key = 0; key < 10; key++ ) if( Manager::has( key ) != ( key == 0 || key > 5 ) ) return false ;
+    
+    // Data referenced again moves to the recently unreferenced end once let go.
+    Manager::reference( 6 ) ;
+    Manager::create( 10, std::size_t( 200 ) ) ;
+    Manager::cleanup() ;
+    
+    if( Manager::residentBytes() != 1000 || !Manager::has( 6 ) || Manager::has( 7 ) || !Manager::has( 8 ) ) return false ;
+    
+    Manager::cleanup() ;
+    
+    if( !Manager::has( 8 ) || held->byteSize() != 200 ) return false ;
+    
+    // Without a budget, every unreferenced data goes on cleanup.
+    Manager::setBudget( 0 ) ;
+    Manager::cleanup() ;
+    
+    if( Manager::residentBytes() != 200 || !Manager::has( 0 ) || Manager::has( 1 ) ) return false ;
+    
+    held = Manager::create( 1, std::size_t( 50 ) ) ;
+    Manager::cleanup() ;
+    
+    return Manager::residentBytes() == 50 && Manager::has( 1 ) && !Manager::has( 0 ) ;
+  }
+  
+  athena::Result test_manager_weak()
+  {
+    using Manager = mars::Manager<std::string, Image> ;
+    
+    mars::WeakReference<Image> weak ;
+    
+    if( !weak.expired() || weak.lock().count() != 0 ) return false ;
+    
+    {
+      auto ref = Manager::create( "weak", std::size_t( 10 ) ) ;
+      
+      weak = mars::WeakReference<Image>( ref ) ;
+      
+      if( ref.count() != 2 || weak.lock().operator->() != ref.operator->() ) return false ;
+      
+      // Referenced data is never visited by cleanup.
+      Manager::cleanup() ;
+      
+      if( !Manager::has( "weak" ) ) return false ;
+    }
+    
+    {
+      // Locking data only the manager references keeps it alive through cleanup.
+      auto locked = weak.lock() ;
+      
+      Manager::cleanup() ;
+      
+      if( !locked || !Manager::has( "weak" ) || locked->byteSize() != 10 ) return false ;
+    }
+    
+    Manager::cleanup() ;
+    
+    if( Manager::has( "weak" ) || !weak.expired() || weak.lock().count() != 0 ) return false ;
+    
+    // Data unreferenced from other threads is queued for cleanup just the same.
+    std::vector<std::thread> threads ;
+    
+    for( unsigned index = 0; index < 4; index++ )
+    {
+      threads.emplace_back( [ index ]()
+      {
+        for( unsigned key = 0; key < 256; key++ ) Manager::create( std::to_string( index * 256 + key ), std::size_t( 1 ) ) ;
+      } ) ;
+    }
+    
+    for( auto& thread : threads ) thread.join() ;
+    
+    if( Manager::residentBytes() != 1024 ) return false ;
+    
+    Manager::cleanup() ;
+    
+    return Manager::residentBytes() == 0 && !Manager::has( "0" ) ;
+  }
+  
+  athena::Result test_manager_batch()
+  {
+    using Manager = mars::Manager<mars::AssetKey, Image> ;
+    
+    std::vector<mars::AssetKey> keys ;
+    
+    for( unsigned index = 0; index < 1000; index++ ) keys.emplace_back( "batch/" + std::to_string( index ) ) ;
+    
+    keys.push_back( keys[ 10 ] ) ;
+    
+    auto created = Manager::getOrCreateMany( keys, std::size_t( 4 ) ) ;
+    
+    // Keys appearing more than once are created once.
+    if( created.size() != keys.size() || Manager::residentBytes() != 4000 || created[ 10 ].operator->() != created.back().operator->() ) return false ;
+    
+    for( auto& ref : created ) if( !ref || ref->byteSize() != 4 ) return false ;
+    
+    // Existing keys are retrieved instead of created again.
+    auto retrieved = Manager::getOrCreateMany( keys.data(), 500, std::size_t( 8 ) ) ;
+    
+    if( retrieved.size() != 500 || Manager::residentBytes() != 4000 ) return false ;
+    
+    for( unsigned index = 0; index < 500; index++ ) if( retrieved[ index ].operator->() != created[ index ].operator->() ) return false ;
+    
+    auto referenced = Manager::referenceMany( keys ) ;
+    
+    // Held by the manager, and every batch resolving the key.
+    if( referenced.size() != keys.size() || referenced[ 0 ].count() != 4 || referenced[ 999 ].count() != 3 ) return false ;
+    
+    for( unsigned index = 0; index < keys.size(); index++ ) if( referenced[ index ].operator->() != created[ index ].operator->() ) return false ;
+    
+    created   .clear() ;
+    retrieved .clear() ;
+    referenced.clear() ;
+    
+    Manager::cleanup() ;
+    
+    return Manager::residentBytes() == 0 && !Manager::has( keys[ 0 ] ) ;
+  }
+  
+  athena::Result test_slab()
+  {
+    mars::Slab<Particle> slab ;
+    
+    auto first  = slab.allocate() ;
+    auto second = slab.allocate() ;
+    
+    if( first->count() != 1 || second != first + 1 ) return false ;
+    
+    first->dereference() ;
+    
+    auto third = slab.allocate() ;
+    
+    if( third != first || slab.size() != 2 ) return false ;
+    
+    third ->dereference() ;
+    second->dereference() ;
+    
+    return true ;
+  }
+  
+  athena::Result test_handle()
+  {
+    using Factory = mars::Factory<Particle> ;
+    using Manager = mars::Manager<unsigned, Particle> ;
+    
+    static_assert( std::is_trivially_copyable<mars::Handle<Particle>>::value, "Handles must be trivially copyable." ) ;
+    static_assert( sizeof( mars::Handle<Particle> ) == 8, "Handles must be an index & generation." ) ;
+    
+    auto handle = Factory::createHandle( 7u ) ;
+    auto copy   = handle ;
+    
+    if( !handle.valid() || copy != handle || copy->id() != 7 ) return false ;
+    
+    Factory::destroy( handle ) ;
+    
+    if( copy.valid() || copy.get() != nullptr ) return false ;
+    
+    auto data = Factory::create( 8u ) ;
+    
+    if( data.handle()->id() != 8 ) return false ;
+    
+    Factory::destroy( data ) ;
+    
+    Manager::create( 1, 9u ) ;
+    auto managed = Manager::handle( 1 ) ;
+    
+    if( !managed || managed->id() != 9 ) return false ;
+    
+    Manager::cleanup() ;
+    
+    return !managed.valid() ;
+  }
+  
+  athena::Result test_factory_threaded()
+  {
+    using Factory = mars::Factory<Particle> ;
+    
+    constexpr unsigned ITERATIONS = 20000 ;
+    constexpr unsigned MAX_THREADS = 32 ;
+    
+    std::atomic<bool> valid( true ) ;
+    
+    for( unsigned count = 1; count <= MAX_THREADS; count *= 2 )
+    {
+      std::vector<std::thread> threads ;
+      
+      for( unsigned thread = 0; thread < count; thread++ )
+      {
+        threads.emplace_back( [&valid, thread]()
+        {
+          for( unsigned iteration = 0; iteration < ITERATIONS; iteration++ )
+          {
+            auto particle = Factory::create( thread + 1 ) ;
+            
+            if( !particle || particle->id() != thread + 1 || particle->users() != 1 ) valid = false ;
+            
+            Factory::destroy( particle ) ;
+          }
+        } ) ;
+      }
+      
+      for( auto& thread : threads ) thread.join() ;
+    }
+    
+    Factory::cleanup() ;
+    
+    return valid.load() ;
+  }
 }
 
 int main()
@@ -103,6 +1791,34 @@ int main()
   manager.initialize( "Mars Library Test" ) ;
   
   manager.add( "Factory Test", &mars::test_factory ) ;
+  manager.add( "Factory Threaded Test", &mars::test_factory_threaded ) ;
+  manager.add( "Factory Policy Test", &mars::test_factory_policy ) ;
+  manager.add( "Factory Batch Test", &mars::test_factory_batch ) ;
+  manager.add( "Factory Stats Test", &mars::test_factory_stats ) ;
+  manager.add( "Pool Test", &mars::test_pool ) ;
+  manager.add( "Deferred Reset Test", &mars::test_deferred_reset ) ;
+  manager.add( "Slab Test", &mars::test_slab ) ;
+  manager.add( "Handle Test", &mars::test_handle ) ;
   manager.add( "Manager Test", &mars::test_manager ) ;
+  manager.add( "Flat Map Test", &mars::test_flat_map ) ;
+  manager.add( "Asset Key Test", &mars::test_asset_key ) ;
+  manager.add( "Manager Budget Test", &mars::test_manager_budget ) ;
+  manager.add( "Manager Weak Test", &mars::test_manager_weak ) ;
+  manager.add( "Manager Batch Test", &mars::test_manager_batch ) ;
+  manager.add( "Forwarding Test", &mars::test_forwarding ) ;
+  manager.add( "Dense Iteration Test", &mars::test_dense_iteration ) ;
+  manager.add( "SoA Pool Test", &mars::test_soa_pool ) ;
+  manager.add( "Job System Test", &mars::test_job_system ) ;
+  manager.add( "Job System Coverage Test", &mars::test_job_system_coverage ) ;
+  manager.add( "Manager Request Test", &mars::test_manager_request ) ;
+  manager.add( "Manager Coalescing Test", &mars::test_manager_coalescing ) ;
+  manager.add( "Manager Priority Test", &mars::test_manager_priority ) ;
+  #if MARS_COROUTINES
+  manager.add( "Manager Coroutine Test", &mars::test_manager_coroutine ) ;
+  #endif
+  manager.add( "Access Test", &mars::test_access ) ;
+  manager.add( "Manager Concurrent Test", &mars::test_manager_concurrent ) ;
+  manager.add( "File Watcher Test", &mars::test_file_watcher ) ;
+  manager.add( "Manager Reload Test", &mars::test_manager_reload ) ;
   return manager.test( athena::Output::Verbose ) ;
 }
\ No newline at end of file
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   WeakReference.h
+ * Author: agent
+ *
+ * Created on October 16, 2026, 7:30 PM
+ */
+
+#pragma once
+
+#include "Data.h"
+#include "Handle.h"
+
+namespace mars
+{
+  /** Non-owning reference to an object retrieved from a Factory or Manager, that can be locked back into a Data while the object is alive.
+   * Locking goes straight to the object's slab cell, so it costs a single atomic increment and never looks anything up.
+   * @note Weak references do not keep their object alive, nor keep a Manager from releasing it on cleanup.
+   * @tparam Type The type of object referenced.
+   */
+  template<typename Type>
+  class WeakReference
+  {
+    public:
+
+      /** Default constructor. Creates a weak reference to nothing.
+       */
+      WeakReference() = default ;
+
+      /** Constructor. Creates a weak reference to the object of a data.
+       * @param data The data to reference.
+       */
+      WeakReference( const Data<Type>& data ) ;
+
+      /** Constructor. Creates a weak reference to the object of a handle.
+       * @param handle The handle to reference.
+       */
+      explicit WeakReference( Handle<Type> handle ) ;
+
+      /** Method to retrieve a strong reference to the object, if it is still alive.
+       * @return A reference to the object. Empty if it was released.
+       */
+      Data<Type> lock() const ;
+
+      /** Method to check whether the object was released.
+       * @return Whether or not the object was released.
+       */
+      bool expired() const ;
+
+      /** Method to retrieve the handle of the object.
+       * @return The handle of the object. Invalid once released.
+       */
+      Handle<Type> handle() const ;
+
+    private:
+
+      /** The handle of the object.
+       */
+      Handle<Type> m_handle ;
+  };
+
+  template<typename Type>
+  WeakReference<Type>::WeakReference( const Data<Type>& data ) : m_handle( data.handle() )
+  {
+  }
+
+  template<typename Type>
+  WeakReference<Type>::WeakReference( Handle<Type> handle ) : m_handle( handle )
+  {
+  }
+
+  template<typename Type>
+  Data<Type> WeakReference<Type>::lock() const
+  {
+    Data<Type>  data                         ;
+    Cell<Type>* cell = this->m_handle.cell() ;
+
+    // The cell may be released & reused between the generation check and the retain, so the generation is checked again once retained.
+    if( cell && cell->retain() )
+    {
+      if( cell->generation() == this->m_handle.generation() ) data.m_cell = cell ;
+      else                                                    cell->dereference() ;
+    }
+
+    return data ;
+  }
+
+  template<typename Type>
+  bool WeakReference<Type>::expired() const
+  {
+    return !this->m_handle.valid() ;
+  }
+
+  template<typename Type>
+  Handle<Type> WeakReference<Type>::handle() const
+  {
+    return this->m_handle ;
+  }
+}